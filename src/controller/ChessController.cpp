@@ -58,14 +58,7 @@ void ChessController::run() {
         std::string sanAttempt = Utils::moveToSAN(move, *model); 
         bool moveSuccessful = model->makeMove(move);
         if (!moveSuccessful) {
-            std::cout << "Move made: " << sanAttempt;
-            // Add check/mate suffix based on state after the move
-            if (model->getIsCheckmate()) {
-                std::cout << "#"; // Checkmate
-            } else if (model->isInCheck()) {
-                 std::cout << "+"; // Check
-            }
-             std::cout << std::endl;
+            std::cout << "Move made: " << sanAttempt << std::endl;
 
             if (model->isGameOver()) {
                 view->displayBoard(model); 
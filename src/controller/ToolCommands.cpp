@@ -0,0 +1,1261 @@
+#include "ToolCommands.h"
+#include "core/FenUtils.h"
+#include "engine/BitbaseGenerator.h"
+#include "engine/BookBuilder.h"
+#include "engine/EpdSuite.h"
+#include "engine/ExternalEngine.h"
+#include "engine/GameCodec.h"
+#include "engine/MateSolver.h"
+#include "engine/San.h"
+#include "engine/Search.h"
+#include "model/ChessModel.h"
+#include "model/DatabaseManager.h"
+#include "model/Move.h"
+#include "model/PgnExporter.h"
+#include "model/PgnImporter.h"
+
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QFileInfo>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <iterator>
+#include <memory>
+#include <thread>
+
+namespace {
+
+// Reads "--name <int>" into value; false on a missing or malformed number
+bool readIntOption(const std::vector<std::string>& args, size_t& i, int& value)
+{
+    if (i + 1 >= args.size()) return false;
+    try {
+        size_t used = 0;
+        value = std::stoi(args[i + 1], &used);
+        if (used != args[i + 1].size()) return false;
+    } catch (const std::exception&) {
+        return false;
+    }
+    ++i;
+    return true;
+}
+
+const int BENCH_DEPTH = 10;
+const int BENCH_HASH_MB = 16;
+// Passes over the positions and games in the throughput benches
+const int FEN_BENCH_ROUNDS = 200000;
+const int SAN_BENCH_ROUNDS = 100000;
+const int DB_BENCH_GAMES = 500;
+
+// Total nodes of the search bench at the default depth and hash size. A change to the
+// search that is meant to alter its behaviour updates this number in the same commit.
+const uint64_t SEARCH_SIGNATURE = 12209721;
+
+// Openings, middlegames and endgames, with castling, en passant and promotions
+const char* const BENCH_POSITIONS[] = {
+    "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+    "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 10",
+    "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 11",
+    "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1",
+    "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8",
+    "r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10",
+    "r3k2r/2pb1ppp/2pp1q2/p7/1nP1B3/1P2P3/P2N1PPP/R2QK2R w KQkq a6 0 14",
+    "4rrk1/2p1b1p1/p1p3q1/4p3/2P2n1p/1P1NR2P/PB3PP1/3R1QK1 b - - 2 24",
+    "r3qbrk/6p1/2b2pPp/p3pP1Q/PpPpP2P/3P1B2/2PB3K/R5R1 w - - 16 42",
+    "6k1/1R3p2/6p1/2Bp3p/3P2q1/P7/1P2rQ1K/5R2 b - - 4 44",
+    "8/8/1p2k1p1/3p3p/1p1P1P1P/1P2PK2/8/8 w - - 3 54",
+    "7r/2p3k1/1p1p1qp1/1P1Bp3/p1P2r1P/P7/4R3/Q4RK1 w - - 0 36",
+    "r1bq1rk1/pp2b1pp/n1pp1n2/3P1p2/2P1p3/2N1P2N/PP2BPPP/R1BQ1RK1 b - - 2 10",
+    "3r3k/2r4p/1p1b3q/p4P2/P2Pp3/1B2P3/3BQ1RP/6K1 w - - 3 87",
+    "2r4r/1p4k1/1Pnp4/3Qb1pq/8/4BpPp/5P2/2RR1BK1 w - - 0 42",
+    "4q1bk/6b1/7p/p1p4p/PNPpP2P/KN4P1/3Q4/4R3 b - - 0 37",
+    "2q3r1/1r2pk2/pp3pp1/2pP3p/P1Pb1BbP/1P4Q1/R3NPP1/4R1K1 w - - 2 34",
+    "1r2r2k/1b4q1/pp5p/2pPp1p1/P3Pn2/1P1B1Q1P/2R3P1/4BR1K b - - 1 37",
+    "r3kbbr/pp1n1p1P/3ppnp1/q5N1/1P1pP3/P1N1B3/2P1QP2/R3KB1R b KQkq b3 0 17",
+    "8/6pk/2b1Rp2/3r4/1R1B2PP/P5K1/8/2r5 b - - 16 42",
+    "1r4k1/4ppb1/2n1b1qp/pB4p1/1n1BP1P1/7P/2PNQPK1/3RN3 w - - 8 29",
+    "8/p2B4/PkP5/4p1pK/4Pb1p/5P2/8/8 w - - 29 68",
+    "3r4/ppq1ppkp/4bnp1/2pN4/2P1P3/1P4P1/PQ3PBP/R4K2 b - - 2 20",
+    "5rr1/4n2k/4q2P/P1P2n2/3B1p2/4pP2/2N1P3/1RR1K2Q w - - 1 49",
+    "1r5k/2pq2p1/3p3p/p1pP4/4QP2/PP1R3P/6PK/8 w - - 1 51",
+    "q5k1/5ppp/1r3bn1/1B6/P1N2P2/BQ2P1P1/5K1P/8 b - - 2 34",
+    "r1b2k1r/5n2/p4q2/1ppn1Pp1/3pp1p1/NP2P3/P1PPBK2/1RQN2R1 w - - 0 22",
+    "r1bqk2r/pppp1ppp/5n2/4b3/4P3/P1N5/1PP2PPP/R1BQKB1R w KQkq - 0 5",
+    "r1bqr1k1/pp1p1ppp/2p5/8/3N1Q2/P2BB3/1PP2PPP/R3K2n b Q - 1 12",
+    "r1bq2k1/p4r1p/1pp2pp1/3p4/1P1B3Q/P2B1N2/2P3PP/4R1K1 b - - 2 19",
+    "r4qk1/6r1/1p4p1/2ppBbN1/1p5Q/P7/2P3PP/5RK1 w - - 2 25",
+    "r7/6k1/1p6/2pp1p2/7Q/8/p1P2K1P/8 w - - 0 32",
+    "r3k2r/ppp1pp1p/2nqb1pn/3p4/4P3/2PP4/PP1NBPPP/R2QK1NR w KQkq - 1 5",
+    "3r1rk1/1pp1pn1p/p1n1q1p1/3p4/Q3P3/2P5/PP1NBPPP/4RRK1 w - - 0 12",
+    "5rk1/1pp1pn1p/p3Brp1/8/1n6/5N2/PP3PPP/2R2RK1 w - - 2 20",
+    "8/1p2pk1p/p1p1r1p1/3n4/8/5R2/PP3PPP/4R1K1 b - - 3 27",
+    "8/4pk2/1p1r2p1/p1p4p/Pn5P/3R4/1P3PP1/4RK2 w - - 1 33",
+    "8/5k2/1pnrp1p1/p1p4p/P6P/4R1PK/1P3P2/4R3 b - - 1 38",
+    "8/8/1p1kp1p1/p1pr1n1p/P6P/1R4P1/1P3PK1/1R6 b - - 15 45",
+    "8/8/1p1k2p1/p1prp2p/P2n3P/6P1/1P1R1PK1/4R3 b - - 5 49",
+    "8/8/1p4p1/p1p2k1p/P2npP1P/4K1P1/1P6/3R4 w - - 6 54",
+    "8/8/1p4p1/p1p2k1p/P2n1P1P/4K1P1/1P6/6R1 b - - 6 59",
+    "8/5k2/1p4p1/p1pK3p/P2n1P1P/6P1/1P6/4R3 b - - 14 63",
+    "8/1R6/1p1K1kp1/p6p/P1p2P1P/6P1/1Pn5/8 w - - 0 67",
+    "1rb1rn1k/p3q1bp/2p3p1/2p1p3/2P1P2N/PP1RQNP1/1B3P2/4R1K1 b - - 4 23",
+    "4rrk1/pp1n1pp1/q5p1/P1pP4/2n3P1/7P/1P3PB1/R1BQ1RK1 w - - 3 22",
+    "r2qr1k1/pb1nbppp/1pn1p3/2ppP3/3P4/2PB1NN1/PP3PPP/R1BQR1K1 w - - 4 12",
+    "2r2b2/5p2/5k2/p1r1pP2/P2pB3/1P3P2/K1P3R1/7R w - - 23 93",
+    "6k1/5p1p/6p1/8/8/2Q5/5PPP/6K1 w - - 0 1",
+    "8/8/4k3/8/2p5/8/B2P2K1/8 w - - 0 1",
+};
+
+// Records at the writers' limits for the FEN bench's round trips: a placement of 71
+// characters, every castling right, an en-passant square and the largest counters
+const char* const FEN_LIMIT_POSITIONS[] = {
+    "rnbqkbnr/pppppppp/nbnbnbnb/bnbnbnbn/qrqrPrqr/QRQR1RQR/PPPP1PPP/RNBQKBNR b KQkq e3 999 99999",
+    "rnbqkbnr/pppppppp/nbnbnbnb/bnbnbnbn/qrqrprqr/QRQR1RQR/PPPP1PPP/RNBQKBNR w KQkq - 0 1",
+};
+
+// Whole games in SAN with every kind of move: captures, castling both ways, en passant,
+// promotions, checks and moves that need a file or rank to tell two pieces apart
+struct SanBenchGame {
+    const char* fen;
+    const char* moves;
+};
+
+const SanBenchGame SAN_BENCH_GAMES[] = {
+    { Board::START_FEN,
+      "e4 e5 Nf3 d6 d4 Bg4 dxe5 Bxf3 Qxf3 dxe5 Bc4 Nf6 Qb3 Qe7 Nc3 c6 Bg5 b5 Nxb5 cxb5 "
+      "Bxb5+ Nbd7 O-O-O Rd8 Rxd7 Rxd7 Rd1 Qe6 Bxd7+ Nxd7 Qb8+ Nxb8 Rd8#" },
+    { Board::START_FEN,
+      "e4 e5 f4 exf4 Bc4 Qh4+ Kf1 b5 Bxb5 Nf6 Nf3 Qh6 d3 Nh5 Nh4 Qg5 Nf5 c6 g4 Nf6 Rg1 cxb5 "
+      "h4 Qg6 h5 Qg5 Qf3 Ng8 Bxf4 Qf6 Nc3 Bc5 Nd5 Qxb2 Bd6 Bxg1 e5 Qxa1+ Ke2 Na6 Nxg7+ Kd8 "
+      "Qf6+ Nxf6 Be7#" },
+    { Board::START_FEN,
+      "e4 Nf6 e5 d5 exd6 e5 dxc7 Bd6 cxb8=N Rxb8 Nf3 O-O Bc4 Qc7 O-O" },
+    { "3k4/8/8/8/8/8/8/R3K2R w KQ - 0 1",
+      "Rad1+ Ke7 Rh7+ Kf6 Rhd7 Ke5 R1d5+ Ke4" },
+};
+
+// Mates checked against the alpha-beta search, from mate in one to mate in eight
+const char* const MATE_BENCH_POSITIONS[] = {
+    "6k1/5ppp/8/8/8/8/5PPP/3R2K1 w - - dm 1; id \"back rank\";",
+    "r1bqkb1r/pppp1ppp/2n2n2/4p2Q/2B1P3/8/PPPP1PPP/RNB1K1NR w KQkq - dm 1; id \"scholar\";",
+    "6rk/6pp/8/6N1/8/8/8/6K1 w - - dm 1; id \"smothered\";",
+    "7k/8/5K2/8/8/8/8/6Q1 w - - dm 1; id \"KQK 1\";",
+    "r2qkb1r/pp2nppp/3p4/2pNN1B1/2BnP3/3P4/PPP2PPP/R2bK2R w KQkq - dm 2; id \"Bxf7\";",
+    "6k1/pp4p1/2p5/2bp4/8/P5Pb/1P3rrP/2BRRN1K b - - dm 2; id \"rook sacrifice\";",
+    "2r3k1/p4p2/3Rp2p/1p2P1pK/8/1P4P1/P3Q2P/1q6 b - - dm 3; id \"king hunt\";",
+    "8/8/8/8/8/5k2/8/4QK2 w - - dm 4; id \"KQK 4\";",
+    "8/8/8/8/8/1k6/8/KQ6 w - - dm 5; id \"KQK 5\";",
+    "8/2k5/8/2K5/8/8/8/1R6 w - - dm 6; id \"KRK 6\";",
+    "rn3rk1/pbppq1pp/1p2pb2/4N2Q/3PN3/3B4/PPP2PPP/R3K2R w KQ - dm 7; id \"Lasker-Thomas\";",
+    "8/8/8/3k4/8/8/8/3QK3 w - - dm 8; id \"KQK 8\";",
+};
+
+double secondsSince(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+uint64_t gamesPerSecond(uint64_t games, double seconds)
+{
+    return seconds > 0 ? uint64_t(double(games) / seconds) : 0;
+}
+
+struct BenchResult {
+    std::string fen;
+    std::string bestMove;
+    int score = 0;
+    uint64_t nodes = 0;
+    double ms = 0;
+};
+
+// FENs and UCI moves need no escaping, so the report is written by hand
+bool writeBenchJson(const std::string& path, const std::string& bench, int depth, int hashMb,
+                    const std::vector<BenchResult>& results, uint64_t nodes, double ms,
+                    uint64_t expected, bool checked)
+{
+    std::ofstream out(path);
+    if (!out) return false;
+    out << "{\n"
+        << "  \"bench\": \"" << bench << "\",\n"
+        << "  \"depth\": " << depth << ",\n"
+        << "  \"hash_mb\": " << hashMb << ",\n"
+        << "  \"positions\": " << results.size() << ",\n"
+        << "  \"nodes\": " << nodes << ",\n"
+        << "  \"expected_nodes\": ";
+    if (checked) out << expected;
+    else out << "null";
+    out << ",\n"
+        << "  \"signature_ok\": " << (!checked || nodes == expected ? "true" : "false") << ",\n"
+        << "  \"time_ms\": " << uint64_t(ms) << ",\n"
+        << "  \"nps\": " << (ms > 0 ? uint64_t(nodes * 1000.0 / ms) : 0) << ",\n"
+        << "  \"results\": [\n";
+    for (size_t i = 0; i < results.size(); ++i) {
+        const BenchResult& r = results[i];
+        out << "    { \"fen\": \"" << r.fen << "\", \"bestmove\": \"" << r.bestMove << "\", \"score\": "
+            << r.score << ", \"nodes\": " << r.nodes << ", \"time_ms\": " << uint64_t(r.ms) << " }"
+            << (i + 1 < results.size() ? ",\n" : "\n");
+    }
+    out << "  ]\n}\n";
+    return bool(out);
+}
+
+int benchSearch(int depth, int hashMb, const std::string& jsonPath)
+{
+    TranspositionTable tt(static_cast<size_t>(hashMb));
+    Search search(tt);
+    std::vector<BenchResult> results;
+    uint64_t totalNodes = 0;
+    double totalMs = 0;
+    const int count = int(std::size(BENCH_POSITIONS));
+
+    for (int i = 0; i < count; ++i) {
+        Board board;
+        if (!board.setFromFen(BENCH_POSITIONS[i])) {
+            std::cerr << "Invalid bench position: " << BENCH_POSITIONS[i] << "\n";
+            return 1;
+        }
+        // Every position starts from the same state, so none depends on the ones before
+        tt.clear();
+        search.clearHistory();
+        SearchLimits limits;
+        limits.depth = depth;
+
+        const auto start = std::chrono::steady_clock::now();
+        const SearchResult result = search.run(board, limits);
+        BenchResult r;
+        r.fen = BENCH_POSITIONS[i];
+        r.bestMove = result.bestMove.isNone() ? "0000" : result.bestMove.toUci();
+        r.score = result.score;
+        r.nodes = result.nodes;
+        r.ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        totalNodes += r.nodes;
+        totalMs += r.ms;
+        std::cout << "Position " << (i + 1) << "/" << count << ": " << r.bestMove << ", "
+                  << r.nodes << " nodes" << std::endl;
+        results.push_back(r);
+    }
+
+    // The signature only holds for the settings it was taken with
+    const bool checked = depth == BENCH_DEPTH && hashMb == BENCH_HASH_MB;
+    const bool ok = !checked || totalNodes == SEARCH_SIGNATURE;
+    std::cout << "\nNodes searched: " << totalNodes << "\n"
+              << "Time (ms):      " << uint64_t(totalMs) << "\n"
+              << "Nodes/second:   " << (totalMs > 0 ? uint64_t(totalNodes * 1000.0 / totalMs) : 0) << "\n";
+    if (!checked) {
+        std::cout << "Signature:      not checked (only at depth " << BENCH_DEPTH << " with "
+                  << BENCH_HASH_MB << " MB hash)\n";
+    } else if (ok) {
+        std::cout << "Signature:      " << totalNodes << " OK\n";
+    } else {
+        std::cout << "Signature:      " << totalNodes << " MISMATCH, expected " << SEARCH_SIGNATURE << "\n";
+    }
+
+    if (!jsonPath.empty()
+        && !writeBenchJson(jsonPath, "search", depth, hashMb, results, totalNodes, totalMs, SEARCH_SIGNATURE, checked)) {
+        std::cerr << "Cannot write " << jsonPath << "\n";
+        return 1;
+    }
+    return ok ? 0 : 1;
+}
+
+struct ThroughputResult {
+    std::string name;
+    uint64_t items = 0;
+    double ms = 0;
+};
+
+bool writeThroughputJson(const std::string& path, const std::string& bench, const std::vector<ThroughputResult>& results)
+{
+    std::ofstream out(path);
+    if (!out) return false;
+    out << "{\n"
+        << "  \"bench\": \"" << bench << "\",\n"
+        << "  \"results\": [\n";
+    for (size_t i = 0; i < results.size(); ++i) {
+        const ThroughputResult& r = results[i];
+        out << "    { \"name\": \"" << r.name << "\", \"items\": " << r.items << ", \"time_ms\": " << uint64_t(r.ms)
+            << ", \"per_second\": " << (r.ms > 0 ? uint64_t(r.items * 1000.0 / r.ms) : 0) << " }"
+            << (i + 1 < results.size() ? ",\n" : "\n");
+    }
+    out << "  ]\n}\n";
+    return bool(out);
+}
+
+void printThroughput(const ThroughputResult& r)
+{
+    std::cout << r.name << ": " << r.items << " in " << uint64_t(r.ms) << " ms, "
+              << (r.ms > 0 ? uint64_t(r.items * 1000.0 / r.ms) : 0) << "/s" << std::endl;
+}
+
+// Parses the bench positions over and over, into the plain FEN fields and into a Board
+int benchFen(int rounds, const std::string& jsonPath)
+{
+    std::vector<std::string_view> fens(std::begin(BENCH_POSITIONS), std::end(BENCH_POSITIONS));
+    fens.insert(fens.end(), std::begin(FEN_LIMIT_POSITIONS), std::end(FEN_LIMIT_POSITIONS));
+    const size_t count = fens.size();
+    std::vector<ThroughputResult> results;
+    uint64_t checksum = 0; // keeps the work from being optimized away
+
+    FenPosition fields;
+    auto start = std::chrono::steady_clock::now();
+    for (int round = 0; round < rounds; ++round) {
+        for (std::string_view fen : fens) {
+            if (FenUtils::parse(fen, fields) != FenError::None) {
+                std::cerr << "Invalid bench position: " << fen << "\n";
+                return 1;
+            }
+            checksum += uint64_t(fields.halfmoveClock + fields.enPassantSquare) + uint8_t(fields.squares[4]);
+        }
+    }
+    results.push_back({ "FenUtils::parse", uint64_t(rounds) * count,
+                        std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() });
+    printThroughput(results.back());
+
+    Board board;
+    start = std::chrono::steady_clock::now();
+    for (int round = 0; round < rounds; ++round) {
+        for (std::string_view fen : fens) {
+            board.setFromFen(fen);
+            checksum += board.key();
+        }
+    }
+    results.push_back({ "Board::setFromFen", uint64_t(rounds) * count,
+                        std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() });
+    printThroughput(results.back());
+
+    // The writers must give back exactly what was read
+    std::vector<FenPosition> positions(count);
+    std::vector<Board> boards(count);
+    char fen[FenUtils::FEN_BUFFER_SIZE];
+    for (size_t i = 0; i < count; ++i) {
+        FenUtils::parse(fens[i], positions[i]);
+        boards[i].setFromFen(fens[i]);
+        if (std::string_view(fen, FenUtils::write(positions[i], fen)) != fens[i]) {
+            std::cerr << "FenUtils::write changed " << fens[i] << " into " << fen << "\n";
+            return 1;
+        }
+    }
+    char epd[256];
+    for (size_t i = 0; i < count; ++i) {
+        // The four position fields, then the counters as operations
+        const std::string_view fields = fens[i].substr(0, fens[i].rfind(' ', fens[i].rfind(' ') - 1));
+        const std::string expected = std::string(fields) + " hmvc " + std::to_string(positions[i].halfmoveClock)
+                                   + "; fmvn " + std::to_string(positions[i].fullmoveNumber) + "; id \"bench\";";
+        const std::string_view written(epd, FenUtils::writeEpd(positions[i], "id \"bench\";", epd, sizeof(epd)));
+        if (written != expected) {
+            std::cerr << "FenUtils::writeEpd wrote \"" << written << "\" for " << fens[i] << "\n";
+            return 1;
+        }
+    }
+
+    start = std::chrono::steady_clock::now();
+    for (int round = 0; round < rounds; ++round) {
+        for (const FenPosition& position : positions) checksum += FenUtils::write(position, fen) + uint8_t(fen[0]);
+    }
+    results.push_back({ "FenUtils::write", uint64_t(rounds) * count,
+                        std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() });
+    printThroughput(results.back());
+
+    start = std::chrono::steady_clock::now();
+    for (int round = 0; round < rounds; ++round) {
+        for (const FenPosition& position : positions) {
+            checksum += FenUtils::writeEpd(position, "id \"bench\";", epd, sizeof(epd)) + uint8_t(epd[0]);
+        }
+    }
+    results.push_back({ "FenUtils::writeEpd", uint64_t(rounds) * count,
+                        std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() });
+    printThroughput(results.back());
+
+    start = std::chrono::steady_clock::now();
+    for (int round = 0; round < rounds; ++round) {
+        for (const Board& position : boards) checksum += position.writeFen(fen) + uint8_t(fen[0]);
+    }
+    results.push_back({ "Board::writeFen", uint64_t(rounds) * count,
+                        std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() });
+    printThroughput(results.back());
+    std::cout << "Checksum: " << checksum << "\n";
+
+    if (!jsonPath.empty() && !writeThroughputJson(jsonPath, "fen", results)) {
+        std::cerr << "Cannot write " << jsonPath << "\n";
+        return 1;
+    }
+    return 0;
+}
+
+// Replays the bench games from their SAN over and over, then once more from the moves
+// already found, so the difference is the time spent parsing; then writes them back
+int benchSan(int rounds, const std::string& jsonPath)
+{
+    struct Game {
+        Board start;
+        std::vector<std::string_view> tokens;
+        std::vector<BoardMove> moves;
+    };
+    std::vector<Game> games;
+    uint64_t plies = 0;
+    for (const SanBenchGame& benchGame : SAN_BENCH_GAMES) {
+        Game game;
+        game.start.setFromFen(benchGame.fen);
+        Board board = game.start;
+        std::string_view moves = benchGame.moves;
+        while (!moves.empty()) {
+            const size_t space = moves.find(' ');
+            std::string_view token = moves.substr(0, space);
+            moves.remove_prefix(space == std::string_view::npos ? moves.size() : space + 1);
+            BoardMove move;
+            SanError error = San::parse(board, token, move);
+            if (error != SanError::None) {
+                std::cerr << "Invalid bench move " << token << ": " << San::errorMessage(error) << "\n";
+                return 1;
+            }
+            board.makeMove(move);
+            game.tokens.push_back(token);
+            game.moves.push_back(move);
+        }
+        plies += game.tokens.size();
+        games.push_back(std::move(game));
+    }
+
+    std::vector<ThroughputResult> results;
+    uint64_t checksum = 0;
+    Board board;
+    auto start = std::chrono::steady_clock::now();
+    for (int round = 0; round < rounds; ++round) {
+        for (const Game& game : games) {
+            board = game.start;
+            for (std::string_view token : game.tokens) {
+                BoardMove move;
+                San::parse(board, token, move);
+                board.makeMove(move);
+            }
+            checksum += board.key();
+        }
+    }
+    const double parseAndMakeMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    start = std::chrono::steady_clock::now();
+    for (int round = 0; round < rounds; ++round) {
+        for (const Game& game : games) {
+            board = game.start;
+            for (BoardMove move : game.moves) board.makeMove(move);
+            checksum += board.key();
+        }
+    }
+    const double makeMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    // Writing goes through whole games at once, as an export would
+    std::string text;
+    start = std::chrono::steady_clock::now();
+    for (int round = 0; round < rounds; ++round) {
+        for (const Game& game : games) {
+            text.clear();
+            San::writeMoves(game.start, game.moves.data(), game.moves.size(), text);
+            checksum += text.size();
+        }
+    }
+    const double writeMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    results.push_back({ "San::parse + makeMove", uint64_t(rounds) * plies, parseAndMakeMs });
+    results.push_back({ "makeMove", uint64_t(rounds) * plies, makeMs });
+    results.push_back({ "San::parse", uint64_t(rounds) * plies, std::max(parseAndMakeMs - makeMs, 0.0) });
+    results.push_back({ "San::writeMoves", uint64_t(rounds) * plies, writeMs });
+    for (const ThroughputResult& r : results) printThroughput(r);
+    std::cout << "Checksum: " << checksum << "\n";
+
+    if (!jsonPath.empty() && !writeThroughputJson(jsonPath, "san", results)) {
+        std::cerr << "Cannot write " << jsonPath << "\n";
+        return 1;
+    }
+    return 0;
+}
+
+// Saves the SAN bench games into a scratch database the way the GUI does, a move at a
+// time with finishGame at the end, then loads every game back as the GUI's Load Game does.
+// sqliteDefaults opens the database without the connection pragmas, for comparison.
+int benchDatabase(int games, const std::string& dbPath, bool sqliteDefaults, const std::string& jsonPath)
+{
+    struct Ply {
+        Move move;
+        int moveNumber;
+        bool isWhiteMove;
+        QString san;
+        QString fenAfterMove;
+    };
+    std::vector<std::vector<Ply>> benchGames;
+    for (const SanBenchGame& benchGame : SAN_BENCH_GAMES) {
+        Board board;
+        board.setFromFen(benchGame.fen);
+        std::vector<Ply> plies;
+        std::string_view moves = benchGame.moves;
+        while (!moves.empty()) {
+            const size_t space = moves.find(' ');
+            std::string_view token = moves.substr(0, space);
+            moves.remove_prefix(space == std::string_view::npos ? moves.size() : space + 1);
+            BoardMove move;
+            if (San::parse(board, token, move) != SanError::None) {
+                std::cerr << "Invalid bench move " << token << "\n";
+                return 1;
+            }
+            const int moveNumber = board.fullmoveNumber();
+            const bool isWhiteMove = board.sideToMove() == WHITE;
+            board.makeMove(move);
+            plies.push_back({ Board::toModelMove(move), moveNumber, isWhiteMove,
+                              QString::fromLatin1(token.data(), int(token.size())), QString::fromStdString(board.toFen()) });
+        }
+        benchGames.push_back(std::move(plies));
+    }
+
+    std::remove(dbPath.c_str());
+    std::vector<ThroughputResult> results;
+    uint64_t checksum = 0;
+    {
+        DatabaseManager database(QString::fromStdString(dbPath));
+        if (sqliteDefaults) database.setConnectionSettings(DatabaseManager::ConnectionSettings::sqliteDefaults());
+        if (!database.initDatabase()) {
+            std::cerr << "Cannot create the bench database " << dbPath << "\n";
+            return 1;
+        }
+
+        std::vector<qint64> gameIds;
+        uint64_t plies = 0;
+        double saveMs = 0;
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < games; ++i) {
+            const std::vector<Ply>& game = benchGames[size_t(i) % benchGames.size()];
+            const qint64 gameId = database.startNewGame();
+            if (gameId < 0) return 1;
+            const auto saveStart = std::chrono::steady_clock::now();
+            for (const Ply& ply : game) {
+                if (!database.saveMove(gameId, ply.moveNumber, ply.isWhiteMove, ply.move, ply.san, ply.fenAfterMove)) return 1;
+            }
+            saveMs += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - saveStart).count();
+            if (!database.finishGame(gameId, "1/2-1/2", game.back().fenAfterMove)) return 1;
+            plies += game.size();
+            gameIds.push_back(gameId);
+        }
+        const double insertMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        results.push_back({ "saveMove calls", plies, saveMs });
+        results.push_back({ "moves committed", plies, insertMs });
+        results.push_back({ "games committed", uint64_t(games), insertMs });
+
+        ChessModel model;
+        QList<QString> sanMoves;
+        QList<QString> fenAfterMoves;
+        start = std::chrono::steady_clock::now();
+        for (qint64 gameId : gameIds) {
+            if (!database.loadGameMoves(gameId, &model, sanMoves, &fenAfterMoves)) return 1;
+            checksum += uint64_t(sanMoves.size() + fenAfterMoves.size());
+        }
+        results.push_back({ "loadGameMoves", uint64_t(games),
+                            std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() });
+    }
+    for (const char* suffix : { "", "-wal", "-shm", "-journal" }) std::remove((dbPath + suffix).c_str());
+
+    for (const ThroughputResult& r : results) printThroughput(r);
+    std::cout << "Checksum: " << checksum << "\n";
+
+    if (!jsonPath.empty() && !writeThroughputJson(jsonPath, "db", results)) {
+        std::cerr << "Cannot write " << jsonPath << "\n";
+        return 1;
+    }
+    return 0;
+}
+
+} // namespace
+
+int runBuildBook(const std::vector<std::string>& args)
+{
+    std::string outputPath;
+    QString dbPath = "chess_games.db";
+    BookBuilder::Settings settings;
+    settings.threads = int(std::max(1u, std::thread::hardware_concurrency()));
+
+    for (size_t i = 0; i < args.size(); ++i) {
+        const std::string& arg = args[i];
+        bool ok = true;
+        if (arg == "--db" && i + 1 < args.size()) {
+            dbPath = QFileInfo(QString::fromStdString(args[++i])).absoluteFilePath();
+        } else if (arg == "--plies") {
+            ok = readIntOption(args, i, settings.maxPlies) && settings.maxPlies > 0;
+        } else if (arg == "--min-games") {
+            ok = readIntOption(args, i, settings.minGames) && settings.minGames > 0;
+        } else if (arg == "--threads") {
+            ok = readIntOption(args, i, settings.threads) && settings.threads > 0;
+        } else if (outputPath.empty() && arg.rfind("--", 0) != 0) {
+            outputPath = arg;
+        } else {
+            ok = false;
+        }
+        if (!ok) {
+            std::cerr << "Invalid argument: " << arg << "\n";
+            outputPath.clear();
+            break;
+        }
+    }
+    if (outputPath.empty()) {
+        std::cerr << "Usage: --build-book <out.bin> [--db <path>] [--plies <n>] [--min-games <n>] [--threads <n>]\n";
+        return 2;
+    }
+
+    DatabaseManager database(dbPath);
+    if (!database.initDatabase()) {
+        std::cerr << "Cannot open the games database\n";
+        return 1;
+    }
+
+    const auto start = std::chrono::steady_clock::now();
+    BookBuilder builder(settings);
+    uint64_t gamesRead = 0;
+    bool readOk = database.forEachFinishedGame(settings.maxPlies,
+        [&](qint64, const QString& result, const QString& startFen, const QByteArray& packedMoves) {
+            BookBuilder::Result outcome = result == "1-0" ? BookBuilder::Result::WhiteWins
+                                        : result == "0-1" ? BookBuilder::Result::BlackWins
+                                                          : BookBuilder::Result::Draw;
+            builder.addGame(outcome, packedMoves.toStdString(), startFen.toStdString());
+            if (++gamesRead % 100000 == 0) {
+                std::cerr << gamesRead << " games read (" << secondsSince(start) << " s)\n";
+            }
+            return true;
+        });
+    if (!readOk) {
+        std::cerr << "Reading games failed\n";
+        return 1;
+    }
+
+    if (!builder.finish(outputPath)) {
+        std::cerr << "Cannot write " << outputPath << "\n";
+        return 1;
+    }
+
+    const BookBuilder::Stats& stats = builder.stats();
+    std::cout << "Book " << outputPath << ": " << stats.entries << " entries for "
+              << stats.positions << " positions from " << stats.games << " games";
+    if (stats.skippedMoves > 0) std::cout << " (" << stats.skippedMoves << " unreplayable plies skipped)";
+    std::cout << " in " << secondsSince(start) << " s\n";
+    return 0;
+}
+
+int runImportPgn(const std::vector<std::string>& args)
+{
+    std::string pgnPath;
+    QString dbPath = "chess_games.db";
+    PgnImporter::Settings settings;
+    settings.threads = int(std::max(1u, std::thread::hardware_concurrency()));
+
+    for (size_t i = 0; i < args.size(); ++i) {
+        const std::string& arg = args[i];
+        bool ok = true;
+        if (arg == "--db" && i + 1 < args.size()) {
+            dbPath = QFileInfo(QString::fromStdString(args[++i])).absoluteFilePath();
+        } else if (arg == "--threads") {
+            ok = readIntOption(args, i, settings.threads) && settings.threads > 0;
+        } else if (arg == "--transaction") {
+            ok = readIntOption(args, i, settings.transactionGames) && settings.transactionGames > 0;
+        } else if (pgnPath.empty() && arg.rfind("--", 0) != 0) {
+            pgnPath = arg;
+        } else {
+            ok = false;
+        }
+        if (!ok) {
+            std::cerr << "Invalid argument: " << arg << "\n";
+            pgnPath.clear();
+            break;
+        }
+    }
+    if (pgnPath.empty()) {
+        std::cerr << "Usage: --import-pgn <games.pgn> [--db <path>] [--threads <n>] [--transaction <games>]\n";
+        return 2;
+    }
+
+    // Creates the tables, and the columns for the PGN tags in an older database
+    QString absoluteDbPath;
+    {
+        DatabaseManager database(dbPath);
+        if (!database.initDatabase()) {
+            std::cerr << "Cannot open the games database\n";
+            return 1;
+        }
+        absoluteDbPath = database.databasePath();
+    }
+
+    PgnImporter importer(absoluteDbPath, settings);
+    const bool ok = importer.import(pgnPath, [](const PgnImporter::Progress& progress) {
+        std::cerr << progress.gamesImported << " games, "
+                  << (progress.totalBytes > 0 ? progress.bytesDone * 100 / progress.totalBytes : 100) << "% of the file, "
+                  << gamesPerSecond(progress.gamesImported, progress.seconds) << " games/s\n";
+    });
+
+    for (const std::string& error : importer.errors()) std::cerr << "Rejected " << error << "\n";
+    const PgnImporter::Progress& stats = importer.stats();
+    if (!ok) {
+        std::cerr << "Import of " << pgnPath << " failed after " << stats.gamesImported << " games\n";
+        return 1;
+    }
+    std::cout << "Imported " << stats.gamesImported << " games (" << stats.plies << " plies) from " << pgnPath
+              << " in " << stats.seconds << " s, " << gamesPerSecond(stats.gamesImported, stats.seconds) << " games/s";
+    if (stats.gamesRejected > 0) std::cout << "; " << stats.gamesRejected << " games rejected";
+    std::cout << "\n";
+    return 0;
+}
+
+int runExportPgn(const std::vector<std::string>& args)
+{
+    std::string pgnPath;
+    QString dbPath = "chess_games.db";
+    bool finishedOnly = false;
+
+    for (size_t i = 0; i < args.size(); ++i) {
+        const std::string& arg = args[i];
+        bool ok = true;
+        if (arg == "--db" && i + 1 < args.size()) {
+            dbPath = QFileInfo(QString::fromStdString(args[++i])).absoluteFilePath();
+        } else if (arg == "--finished") {
+            finishedOnly = true;
+        } else if (pgnPath.empty() && arg.rfind("--", 0) != 0) {
+            pgnPath = arg;
+        } else {
+            ok = false;
+        }
+        if (!ok) {
+            std::cerr << "Invalid argument: " << arg << "\n";
+            pgnPath.clear();
+            break;
+        }
+    }
+    if (pgnPath.empty()) {
+        std::cerr << "Usage: --export-pgn <out.pgn> [--db <path>] [--finished]\n";
+        return 2;
+    }
+
+    // Brings an older database up to the columns the export reads
+    QString absoluteDbPath;
+    {
+        DatabaseManager database(dbPath);
+        if (!database.initDatabase()) {
+            std::cerr << "Cannot open the games database\n";
+            return 1;
+        }
+        absoluteDbPath = database.databasePath();
+    }
+
+    PgnExporter exporter(absoluteDbPath);
+    const bool ok = exporter.exportTo(pgnPath, finishedOnly);
+    const PgnExporter::Stats& stats = exporter.stats();
+    if (!ok) {
+        std::cerr << "Export to " << pgnPath << " failed after " << stats.games << " games\n";
+        return 1;
+    }
+    std::cout << "Exported " << stats.games << " games (" << stats.plies << " plies, " << stats.bytes << " bytes) to "
+              << pgnPath << " in " << stats.seconds << " s, " << gamesPerSecond(stats.games, stats.seconds) << " games/s\n";
+    return 0;
+}
+
+int runArchiveGames(const std::vector<std::string>& args)
+{
+    std::string archivePath;
+    QString dbPath = "chess_games.db";
+
+    for (size_t i = 0; i < args.size(); ++i) {
+        const std::string& arg = args[i];
+        if (arg == "--db" && i + 1 < args.size()) {
+            dbPath = QFileInfo(QString::fromStdString(args[++i])).absoluteFilePath();
+        } else if (archivePath.empty() && arg.rfind("--", 0) != 0) {
+            archivePath = arg;
+        } else {
+            std::cerr << "Invalid argument: " << arg << "\n";
+            archivePath.clear();
+            break;
+        }
+    }
+    if (archivePath.empty()) {
+        std::cerr << "Usage: --archive-games <out.cga> [--db <path>]\n";
+        return 2;
+    }
+
+    DatabaseManager database(dbPath);
+    if (!database.initDatabase()) {
+        std::cerr << "Cannot open the games database\n";
+        return 1;
+    }
+    GameArchiveWriter writer;
+    if (!writer.open(archivePath)) {
+        std::cerr << "Cannot create " << archivePath << "\n";
+        return 1;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    uint64_t games = 0;
+    uint64_t plies = 0;
+    qint64 skipped = 0;
+    bool writeOk = true;
+    const bool readOk = database.forEachEncodedGame([&](qint64, const QString& result, const QString& startFen, const QByteArray& encodedMoves) {
+        writeOk = writer.add(result.toStdString(), startFen.toStdString(),
+                             std::string_view(encodedMoves.constData(), size_t(encodedMoves.size())));
+        games++;
+        plies += uint64_t(encodedMoves.size());
+        return writeOk;
+    }, &skipped);
+    writeOk = writer.close() && writeOk;
+    if (!readOk || !writeOk) {
+        std::cerr << (readOk ? "Writing the archive failed\n" : "Reading games failed\n");
+        return 1;
+    }
+    const double writeSeconds = secondsSince(start);
+
+    // Read back and replay every game, as a loader would
+    GameArchiveReader reader;
+    if (!reader.open(QString::fromStdString(archivePath))) {
+        std::cerr << "Cannot read " << archivePath << " back\n";
+        return 1;
+    }
+    start = std::chrono::steady_clock::now();
+    GameArchiveReader::Game game;
+    std::vector<BoardMove> moves;
+    uint64_t decodedPlies = 0;
+    bool decodeOk = true;
+    Board board;
+    while (reader.next(game)) {
+        moves.clear();
+        board.setFromFen(game.fen.empty() ? std::string_view(Board::START_FEN) : game.fen);
+        decodeOk &= GameCodec::decode(board, game.moves, moves);
+        decodedPlies += moves.size();
+    }
+    const double decodeSeconds = secondsSince(start);
+    if (reader.failed() || !decodeOk || decodedPlies != plies) {
+        std::cerr << "The archive does not decode to the games written\n";
+        return 1;
+    }
+
+    const qint64 dbBytes = QFileInfo(database.databasePath()).size();
+    std::cout << "Archived " << games << " games (" << plies << " plies) to " << archivePath << " in " << writeSeconds << " s";
+    if (skipped > 0) std::cout << "; " << skipped << " games whose moves do not replay skipped";
+    std::cout << "\n" << writer.bytesWritten() << " bytes, "
+              << (plies > 0 ? double(writer.bytesWritten()) / double(plies) : 0.0) << " bytes per ply (database: "
+              << (plies > 0 ? double(dbBytes) / double(plies) : 0.0) << " bytes per ply)\n"
+              << "Decoded in " << decodeSeconds << " s, " << gamesPerSecond(decodedPlies, decodeSeconds) << " plies/s\n";
+    return 0;
+}
+
+int runIndexPositions(const std::vector<std::string>& args)
+{
+    QString dbPath = "chess_games.db";
+    for (size_t i = 0; i < args.size(); ++i) {
+        if (args[i] == "--db" && i + 1 < args.size()) {
+            dbPath = QFileInfo(QString::fromStdString(args[++i])).absoluteFilePath();
+        } else {
+            std::cerr << "Invalid argument: " << args[i] << "\n"
+                      << "Usage: --index-positions [--db <path>]\n";
+            return 2;
+        }
+    }
+
+    // initDatabase() creates the Positions table in a database from before it
+    DatabaseManager database(dbPath);
+    if (!database.initDatabase()) {
+        std::cerr << "Cannot open the games database\n";
+        return 1;
+    }
+    const auto start = std::chrono::steady_clock::now();
+    const qint64 positions = database.rebuildPositionIndex();
+    const double seconds = secondsSince(start);
+    if (positions < 0) {
+        std::cerr << "Indexing the positions failed\n";
+        return 1;
+    }
+    std::cout << "Indexed " << positions << " positions in " << seconds << " s, "
+              << gamesPerSecond(uint64_t(positions), seconds) << " positions/s\n";
+    return 0;
+}
+
+int runFindPosition(const std::vector<std::string>& args)
+{
+    std::string fen;
+    QString dbPath = "chess_games.db";
+    int limit = 1000;
+
+    for (size_t i = 0; i < args.size(); ++i) {
+        const std::string& arg = args[i];
+        bool ok = true;
+        if (arg == "--db" && i + 1 < args.size()) {
+            dbPath = QFileInfo(QString::fromStdString(args[++i])).absoluteFilePath();
+        } else if (arg == "--limit") {
+            ok = readIntOption(args, i, limit) && limit >= 0;
+        } else if (fen.empty() && arg.rfind("--", 0) != 0) {
+            fen = arg;
+        } else {
+            ok = false;
+        }
+        if (!ok) {
+            std::cerr << "Invalid argument: " << arg << "\n";
+            fen.clear();
+            break;
+        }
+    }
+    Board board;
+    if (fen.empty() || !board.setFromFen(fen)) {
+        std::cerr << (fen.empty() ? "" : "Invalid FEN: " + fen + "\n")
+                  << "Usage: --find-position \"<fen>\" [--db <path>] [--limit <games>]\n";
+        return 2;
+    }
+
+    DatabaseManager database(dbPath);
+    if (!database.initDatabase()) {
+        std::cerr << "Cannot open the games database\n";
+        return 1;
+    }
+    const auto start = std::chrono::steady_clock::now();
+    const QList<PositionMatch> matches = database.findGamesWithPosition(board.key(), limit);
+    const double seconds = secondsSince(start);
+    for (const PositionMatch& match : matches) {
+        std::cout << "game " << match.gameId << " ply " << match.ply << "\n";
+    }
+    std::cout << matches.size() << " games in " << seconds * 1000 << " ms\n";
+    return 0;
+}
+
+int runGenerateBitbases(const std::vector<std::string>& args)
+{
+    std::string directory;
+    std::vector<std::string> names;
+    int threads = int(std::max(1u, std::thread::hardware_concurrency()));
+
+    for (size_t i = 0; i < args.size(); ++i) {
+        const std::string& arg = args[i];
+        bool ok = true;
+        if (arg == "--threads") {
+            ok = readIntOption(args, i, threads) && threads > 0;
+        } else if (directory.empty() && arg.rfind("--", 0) != 0) {
+            directory = arg;
+        } else if (arg.rfind("--", 0) != 0) {
+            ok = !Bitbases::canonicalName(arg).empty();
+            names.push_back(arg);
+        } else {
+            ok = false;
+        }
+        if (!ok) {
+            std::cerr << "Invalid argument: " << arg << "\n";
+            directory.clear();
+            break;
+        }
+    }
+    if (directory.empty()) {
+        std::cerr << "Usage: --generate-bitbases <out-dir> [KQKR ...] [--threads <n>]\n";
+        return 2;
+    }
+    if (names.empty()) names = Bitbases::allTables();
+
+    const auto start = std::chrono::steady_clock::now();
+    BitbaseGenerator generator(threads);
+    auto report = [](const BitbaseGenerator::Stats& stats) {
+        std::cout << stats.name << ": " << stats.positions << " positions, " << stats.wins << " won, "
+                  << stats.draws << " drawn, " << stats.losses << " lost for the side to move; "
+                  << stats.passes << " passes, " << stats.fileBytes << " bytes, " << stats.seconds << " s"
+                  << std::endl;
+    };
+    for (const std::string& name : names) {
+        if (!generator.generate(name, directory, report)) {
+            std::cerr << "Cannot write the " << Bitbases::canonicalName(name) << " bitbase to " << directory << "\n";
+            return 1;
+        }
+    }
+    std::cout << "Done in " << secondsSince(start) << " s\n";
+    return 0;
+}
+
+int runMateBench(const std::vector<std::string>& args)
+{
+    std::string epdPath;
+    int hashMb = 64;
+    int maxNodes = 0;
+    bool shortest = false;
+
+    for (size_t i = 0; i < args.size(); ++i) {
+        const std::string& arg = args[i];
+        bool ok = true;
+        if (arg == "--hash") {
+            ok = readIntOption(args, i, hashMb) && hashMb > 0;
+        } else if (arg == "--nodes") {
+            ok = readIntOption(args, i, maxNodes) && maxNodes >= 0;
+        } else if (arg == "--shortest") {
+            shortest = true;
+        } else if (epdPath.empty() && arg.rfind("--", 0) != 0) {
+            epdPath = arg;
+        } else {
+            ok = false;
+        }
+        if (!ok) {
+            std::cerr << "Invalid argument: " << arg << "\n";
+            std::cerr << "Usage: --mate-bench [positions.epd] [--hash <mb>] [--nodes <n>] [--shortest]\n";
+            return 2;
+        }
+    }
+
+    EpdSuite suite;
+    if (epdPath.empty()) {
+        std::string text;
+        for (const char* line : MATE_BENCH_POSITIONS) text += std::string(line) + "\n";
+        suite.parse(text);
+    } else if (!suite.load(epdPath)) {
+        std::cerr << "Cannot open " << epdPath << "\n";
+        return 1;
+    }
+    for (const std::string& error : suite.errors()) std::cerr << "Skipping " << error << "\n";
+
+    MateSolver solver(static_cast<size_t>(hashMb));
+    int solved = 0;
+    int tried = 0;
+    uint64_t totalNodes = 0;
+    int64_t totalMs = 0;
+    for (const EpdRecord& record : suite.records()) {
+        if (record.mateIn == 0) continue;
+        Board board;
+        board.setFromPosition(record.position);
+        const std::string id = record.id.empty() ? "#" + std::to_string(tried + 1) : record.id;
+
+        MateSolver::Limits limits;
+        limits.maxMoves = record.mateIn;
+        limits.maxNodes = uint64_t(maxNodes);
+        limits.shortest = shortest;
+        solver.clear();
+        const MateSolver::Result result = solver.solve(board, limits);
+        const bool ok = result.status == MateSolver::Status::Mate && result.mateIn <= record.mateIn
+                        && !result.line.empty();
+
+        tried++;
+        solved += ok ? 1 : 0;
+        totalNodes += result.nodes;
+        totalMs += result.timeMs;
+        std::cout << (ok ? "ok   " : "FAIL ") << id << ": dm " << record.mateIn << ", ";
+        if (result.status == MateSolver::Status::Mate) std::cout << "mate in " << result.mateIn;
+        else if (result.status == MateSolver::Status::NoMate) std::cout << "no mate";
+        else std::cout << "unsolved";
+        std::cout << ", " << result.nodes << " nodes, " << result.timeMs << " ms";
+        if (!result.line.empty()) {
+            std::cout << ":";
+            for (BoardMove move : result.line) std::cout << ' ' << move.toUci();
+        }
+        std::cout << std::endl;
+    }
+
+    std::cout << solved << "/" << tried << " solved, " << totalNodes << " nodes, " << totalMs << " ms";
+    if (totalMs > 0) std::cout << ", " << totalNodes * 1000 / uint64_t(totalMs) << " nodes/s";
+    std::cout << "\n";
+    return solved == tried && tried > 0 ? 0 : 1;
+}
+
+int runEpd(const std::vector<std::string>& args)
+{
+    std::string epdPath;
+    EpdSuite::Settings settings;
+    settings.threads = int(std::max(1u, std::thread::hardware_concurrency()));
+    int hashMb = int(settings.hashMb);
+    int moveTimeMs = int(settings.moveTimeMs);
+
+    for (size_t i = 0; i < args.size(); ++i) {
+        const std::string& arg = args[i];
+        bool ok = true;
+        if (arg == "--depth") {
+            ok = readIntOption(args, i, settings.depth) && settings.depth > 0 && settings.depth < Search::MAX_PLY;
+        } else if (arg == "--time") {
+            ok = readIntOption(args, i, moveTimeMs) && moveTimeMs > 0;
+        } else if (arg == "--threads") {
+            ok = readIntOption(args, i, settings.threads) && settings.threads > 0;
+        } else if (arg == "--hash") {
+            ok = readIntOption(args, i, hashMb) && hashMb > 0;
+        } else if (arg == "--perft-depth") {
+            ok = readIntOption(args, i, settings.maxPerftDepth) && settings.maxPerftDepth > 0;
+        } else if (epdPath.empty() && arg.rfind("--", 0) != 0) {
+            epdPath = arg;
+        } else {
+            ok = false;
+        }
+        if (!ok) {
+            std::cerr << "Invalid argument: " << arg << "\n";
+            epdPath.clear();
+            break;
+        }
+    }
+    if (epdPath.empty()) {
+        std::cerr << "Usage: --epd <suite.epd> [--depth <n> | --time <ms>] [--threads <n>] [--hash <mb>] [--perft-depth <n>]\n";
+        return 2;
+    }
+    settings.hashMb = size_t(hashMb);
+    settings.moveTimeMs = moveTimeMs;
+
+    EpdSuite suite;
+    if (!suite.load(epdPath)) {
+        std::cerr << "Cannot open " << epdPath << "\n";
+        return 1;
+    }
+    for (const std::string& error : suite.errors()) std::cerr << "Skipping " << error << "\n";
+
+    const auto start = std::chrono::steady_clock::now();
+    size_t passed = 0;
+    uint64_t totalNodes = 0;
+    std::vector<std::string> failed;
+    suite.run(settings, [&](size_t index, const EpdRecord& record, const EpdSuite::Result& result) {
+        const std::string id = record.id.empty() ? "#" + std::to_string(index + 1) : record.id;
+        passed += result.passed ? 1 : 0;
+        totalNodes += result.nodes;
+        if (!result.passed) failed.push_back(id);
+        std::cout << (result.passed ? "ok   " : "FAIL ") << id << ": ";
+        if (result.searched) {
+            std::cout << result.bestMove.toUci() << ", depth " << result.depth << ", score " << result.score << ", ";
+        }
+        std::cout << result.nodes << " nodes, " << result.timeMs << " ms";
+        if (!result.passed) std::cout << " (" << result.failure << ")";
+        std::cout << std::endl;
+    });
+
+    const double seconds = secondsSince(start);
+    const size_t total = suite.records().size();
+    std::cout << passed << "/" << total << " passed, " << total - passed << " failed, " << totalNodes << " nodes in "
+              << seconds << " s with " << settings.threads << " threads\n";
+    if (!failed.empty()) {
+        std::cout << "Failed:";
+        for (const std::string& id : failed) std::cout << ' ' << id;
+        std::cout << "\n";
+    }
+    return passed == total && total > 0 ? 0 : 1;
+}
+
+int runBench(const std::vector<std::string>& args)
+{
+    std::string bench = "search";
+    std::string jsonPath;
+    std::string dbPath = (std::filesystem::temp_directory_path() / "chessqt-bench.db").string();
+    int depth = BENCH_DEPTH;
+    int hashMb = BENCH_HASH_MB;
+    int rounds = 0;
+    bool sqliteDefaults = false;
+
+    for (size_t i = 0; i < args.size(); ++i) {
+        const std::string& arg = args[i];
+        bool ok = true;
+        if (arg == "--depth") {
+            ok = readIntOption(args, i, depth) && depth > 0 && depth < Search::MAX_PLY;
+        } else if (arg == "--hash") {
+            ok = readIntOption(args, i, hashMb) && hashMb > 0;
+        } else if (arg == "--rounds") {
+            ok = readIntOption(args, i, rounds) && rounds > 0;
+        } else if (arg == "--json" && i + 1 < args.size()) {
+            jsonPath = args[++i];
+        } else if (arg == "--db" && i + 1 < args.size()) {
+            dbPath = QFileInfo(QString::fromStdString(args[++i])).absoluteFilePath().toStdString();
+        } else if (arg == "--sqlite-defaults") {
+            sqliteDefaults = true;
+        } else if (i == 0 && (arg == "search" || arg == "fen" || arg == "san" || arg == "db")) {
+            bench = arg;
+        } else {
+            ok = false;
+        }
+        if (!ok) {
+            std::cerr << "Invalid argument: " << arg << "\n";
+            std::cerr << "Usage: --bench [search|fen|san|db] [--depth <n>] [--hash <mb>] [--rounds <n>] [--db <path>] [--sqlite-defaults] [--json <path>]\n";
+            return 2;
+        }
+    }
+    if (bench == "fen") return benchFen(rounds > 0 ? rounds : FEN_BENCH_ROUNDS, jsonPath);
+    if (bench == "san") return benchSan(rounds > 0 ? rounds : SAN_BENCH_ROUNDS, jsonPath);
+    if (bench == "db") return benchDatabase(rounds > 0 ? rounds : DB_BENCH_GAMES, dbPath, sqliteDefaults, jsonPath);
+    return benchSearch(depth, hashMb, jsonPath);
+}
+
+int runCheckEngine(const std::vector<std::string>& args)
+{
+    // This program's own UCI mode is the default engine under test
+    QString program = QCoreApplication::applicationFilePath();
+    QStringList arguments { "--uci" };
+    int depth = 6;
+    bool programGiven = false;
+
+    for (size_t i = 0; i < args.size(); ++i) {
+        const std::string& arg = args[i];
+        bool ok = true;
+        if (arg == "--depth") {
+            ok = readIntOption(args, i, depth) && depth > 0 && depth < Search::MAX_PLY;
+        } else if (!programGiven && arg.rfind("--", 0) != 0) {
+            program = QString::fromStdString(arg);
+            arguments.clear();
+            programGiven = true;
+        } else {
+            ok = false;
+        }
+        if (!ok) {
+            std::cerr << "Invalid argument: " << arg << "\n"
+                      << "Usage: --check-engine [<program>] [--depth <n>]\n";
+            return 2;
+        }
+    }
+
+    auto engine = std::make_unique<ExternalEngine>(program, arguments);
+    std::vector<SearchResult> results;
+    int infos = 0;
+    QString error;
+    QObject::connect(engine.get(), &ChessEngine::bestMoveFound, [&](const SearchResult& result) { results.push_back(result); });
+    QObject::connect(engine.get(), &ChessEngine::searchInfo, [&](const SearchInfo&) { infos++; });
+    QObject::connect(engine.get(), &ChessEngine::engineError, [&](const QString& message) { error = message; });
+
+    // Runs the event loop, where all of the engine's I/O happens, until done() or the time is up
+    auto runUntil = [&](int milliseconds, const std::function<bool()>& done) {
+        QElapsedTimer timer;
+        timer.start();
+        while (!done() && error.isEmpty() && timer.elapsed() < milliseconds) {
+            QCoreApplication::processEvents(QEventLoop::WaitForMoreEvents, 10);
+        }
+        return done();
+    };
+    int failures = 0;
+    auto report = [&](const char* check, bool passed, const std::string& detail) {
+        std::cout << check << ": " << (passed ? "ok" : "FAILED") << (detail.empty() ? "" : " (" + detail + ")") << "\n";
+        if (!passed) failures++;
+    };
+
+    Board start;
+    SearchLimits fixedDepth;
+    fixedDepth.depth = depth;
+    SearchLimits infinite;
+    infinite.infinite = true;
+
+    // A search to a fixed depth reports lines and a legal best move
+    engine->startSearch(start, fixedDepth);
+    bool answered = runUntil(30000, [&] { return !results.empty(); });
+    report("search", answered && infos > 0 && start.isLegal(results.front().bestMove),
+           answered ? std::to_string(infos) + " info lines, best move " + results.front().bestMove.toUci() : error.toStdString());
+
+    // A new search replaces a running one: the engine is stopped, and only the new
+    // search's best move, legal in its own position, is delivered
+    Board afterE4;
+    afterE4.setFromFen("rnbqkbnr/pppppppp/8/8/4P3/8/PPPP1PPP/RNBQKBNR b KQkq - 0 1");
+    results.clear();
+    engine->startSearch(start, infinite);
+    runUntil(200, [] { return false; });
+    engine->startSearch(afterE4, fixedDepth);
+    answered = runUntil(30000, [&] { return !results.empty(); });
+    runUntil(200, [] { return false; });
+    report("replace", answered && results.size() == 1 && afterE4.isLegal(results.front().bestMove),
+           std::to_string(results.size()) + " best moves delivered");
+
+    // A cancelled search delivers nothing
+    results.clear();
+    engine->startSearch(start, infinite);
+    runUntil(200, [] { return false; });
+    engine->cancel();
+    runUntil(500, [] { return false; });
+    report("cancel", results.empty() && !engine->isSearching(), std::to_string(results.size()) + " best moves delivered");
+
+    // Closing the engine in the middle of a search does not wait for the process
+    engine->startSearch(start, infinite);
+    runUntil(200, [] { return false; });
+    QElapsedTimer closing;
+    closing.start();
+    engine.reset();
+    const qint64 closeMs = closing.elapsed();
+    report("close", closeMs < 50, std::to_string(closeMs) + " ms");
+
+    if (!error.isEmpty()) std::cerr << error.toStdString() << "\n";
+    return failures == 0 && error.isEmpty() ? 0 : 1;
+}
@@ -0,0 +1,63 @@
+#ifndef TOOL_COMMANDS_H
+#define TOOL_COMMANDS_H
+
+#include <string>
+#include <vector>
+
+// Command-line tools run without the GUI. Each takes the arguments that follow its
+// flag and returns the process exit code.
+
+// --build-book <out.bin> [--db <path>] [--plies <n>] [--min-games <n>] [--threads <n>]
+int runBuildBook(const std::vector<std::string>& args);
+
+// --import-pgn <games.pgn> [--db <path>] [--threads <n>] [--transaction <games>]; adds
+// every game of the file to the games database, reporting progress on stderr and the
+// games that were rejected with the reason
+int runImportPgn(const std::vector<std::string>& args);
+
+// --export-pgn <out.pgn> [--db <path>] [--finished]; writes the games database as PGN,
+// every game or only those with a result
+int runExportPgn(const std::vector<std::string>& args);
+
+// --archive-games <out.cga> [--db <path>]; writes the finished games to a GameCodec archive
+// of one byte per ply, then reads it back and reports its size and the decoding speed
+int runArchiveGames(const std::vector<std::string>& args);
+
+// --index-positions [--db <path>]; fills the Positions table again from the saved moves,
+// for a database from before it existed
+int runIndexPositions(const std::vector<std::string>& args);
+
+// --find-position "<fen>" [--db <path>] [--limit <games>]; lists the games that reached the
+// position, with the ply at which each first did, 1000 games at most by default
+int runFindPosition(const std::vector<std::string>& args);
+
+// --generate-bitbases <out-dir> [KQKR ...] [--threads <n>]; all 3- and 4-piece tables by default
+int runGenerateBitbases(const std::vector<std::string>& args);
+
+// --mate-bench [positions.epd] [--hash <mb>] [--nodes <n>] [--shortest]; solves every
+// "dm <n>" position with the mate solver, a built-in set by default
+int runMateBench(const std::vector<std::string>& args);
+
+// --epd <suite.epd> [--depth <n> | --time <ms>] [--threads <n>] [--hash <mb>] [--perft-depth <n>];
+// checks every position of an EPD suite on a pool of threads: "bm", "am" and "dm" against
+// a search with the given limit (1 s per position by default), "D<n>" perft counts
+// against the move generator. Exits with 1 when any position fails.
+int runEpd(const std::vector<std::string>& args);
+
+// --bench [search|fen|san|db] [--depth <n>] [--hash <mb>] [--rounds <n>] [--json <path>]; fixed
+// workloads for tracking performance between builds. "search" (the default) searches a
+// built-in set of positions to a fixed depth, each from a cleared hash table, so the
+// total node count is a signature of the search's behaviour; exits with 1 when it
+// changes. "fen" parses and writes the same positions --rounds times over, "san"
+// replays a few built-in games from their SAN. "db" saves --rounds games into a scratch
+// database (--db <path>) and loads them back, with --sqlite-defaults to leave out the
+// connection pragmas.
+int runBench(const std::vector<std::string>& args);
+
+// --check-engine [<program>] [--depth <n>]; drives a UCI program through ExternalEngine as the
+// GUI does, this program's --uci mode by default, and checks a search, a search replaced
+// while running, a cancelled search and closing the engine mid-search without waiting.
+// Exits with 1 when a check fails.
+int runCheckEngine(const std::vector<std::string>& args);
+
+#endif // TOOL_COMMANDS_H
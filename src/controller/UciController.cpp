@@ -0,0 +1,294 @@
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <iostream>
+#include "UciController.h"
+
+namespace {
+
+const char* const ENGINE_NAME = "ChessQt";
+const int DEFAULT_HASH_MB = 64;
+const int MAX_HASH_MB = 4096;
+const int MAX_THREADS = 128;
+const int MAX_MULTIPV = 218;
+
+// Selective search features exposed as check options, mostly for testing their value
+struct SearchToggle {
+    const char* name;
+    bool SearchOptions::*flag;
+};
+
+const SearchToggle SEARCH_TOGGLES[] = {
+    { "NullMove", &SearchOptions::nullMove },
+    { "NullMoveVerification", &SearchOptions::nullMoveVerification },
+    { "LateMoveReductions", &SearchOptions::lateMoveReductions },
+    { "ReverseFutility", &SearchOptions::reverseFutility },
+    { "Futility", &SearchOptions::futility },
+    { "CheckExtensions", &SearchOptions::checkExtensions },
+    { "AspirationWindows", &SearchOptions::aspirationWindows },
+};
+
+std::string toLower(std::string text) {
+    std::transform(text.begin(), text.end(), text.begin(),
+                   [](unsigned char c) { return char(std::tolower(c)); });
+    return text;
+}
+
+} // namespace
+
+UciController::UciController() : tt(DEFAULT_HASH_MB), pool(tt) {
+    position.setFromFen(Board::START_FEN);
+    pool.setInfoCallback([this](const SearchInfo& info) { send(formatInfo(info)); });
+}
+
+UciController::~UciController() {
+    stopSearch();
+}
+
+void UciController::send(const std::string& line) {
+    std::lock_guard<std::mutex> lock(outputMutex);
+    std::cout << line << std::endl;
+}
+
+void UciController::run() {
+    std::string line;
+    while (std::getline(std::cin, line)) {
+        std::istringstream input(line);
+        std::string command;
+        if (!(input >> command)) continue;
+
+        if (command == "uci") {
+            handleUci();
+        } else if (command == "isready") {
+            send("readyok");
+        } else if (command == "ucinewgame") {
+            waitForSearch();
+            tt.clear();
+            mateSolver.clear();
+            pool.clearHistory();
+            position.setFromFen(Board::START_FEN);
+        } else if (command == "position") {
+            waitForSearch();
+            handlePosition(input);
+        } else if (command == "go") {
+            waitForSearch();
+            handleGo(input);
+        } else if (command == "stop") {
+            stopSearch();
+        } else if (command == "ponderhit") {
+            pool.ponderHit();
+        } else if (command == "setoption") {
+            waitForSearch();
+            handleSetOption(input);
+        } else if (command == "d") {
+            send(position.toFen());
+        } else if (command == "quit") {
+            break;
+        } else if (command != "debug" && command != "register") {
+            send("info string Unknown command: " + line);
+        }
+    }
+    stopSearch();
+}
+
+void UciController::handleUci() {
+    send(std::string("id name ") + ENGINE_NAME);
+    send("id author ChessQt developers");
+    send("option name Hash type spin default " + std::to_string(DEFAULT_HASH_MB)
+         + " min 1 max " + std::to_string(MAX_HASH_MB));
+    send("option name Clear Hash type button");
+    send("option name Threads type spin default 1 min 1 max " + std::to_string(MAX_THREADS));
+    send("option name MultiPV type spin default 1 min 1 max " + std::to_string(MAX_MULTIPV));
+    send("option name Ponder type check default false");
+    send("option name OwnBook type check default false");
+    send("option name BookFile type string default <empty>");
+    send("option name SyzygyPath type string default <empty>");
+    send("option name BitbasePath type string default <empty>");
+    SearchOptions defaults;
+    for (const SearchToggle& toggle : SEARCH_TOGGLES) {
+        send(std::string("option name ") + toggle.name + " type check default "
+             + (defaults.*toggle.flag ? "true" : "false"));
+    }
+    send("uciok");
+}
+
+void UciController::handlePosition(std::istringstream& input) {
+    std::string token;
+    input >> token;
+    std::string fen;
+    if (token == "startpos") {
+        fen = Board::START_FEN;
+        input >> token; // "moves", if present
+    } else if (token == "fen") {
+        while (input >> token && token != "moves") fen += token + " ";
+    } else {
+        send("info string Expected 'startpos' or 'fen'");
+        return;
+    }
+
+    Board board;
+    if (!board.setFromFen(fen)) {
+        send("info string Invalid FEN: " + fen);
+        return;
+    }
+    while (input >> token) {
+        BoardMove move = board.parseUciMove(token);
+        if (move.isNone()) {
+            send("info string Illegal move: " + token);
+            break;
+        }
+        board.makeMove(move);
+    }
+    position = board;
+}
+
+void UciController::handleGo(std::istringstream& input) {
+    SearchLimits limits;
+    limits.multiPV = multiPV;
+    int mateMoves = 0;
+    std::string token;
+    while (input >> token) {
+        if (token == "wtime") input >> limits.timeLeftMs[WHITE];
+        else if (token == "btime") input >> limits.timeLeftMs[BLACK];
+        else if (token == "winc") input >> limits.incrementMs[WHITE];
+        else if (token == "binc") input >> limits.incrementMs[BLACK];
+        else if (token == "movestogo") input >> limits.movesToGo;
+        else if (token == "depth") input >> limits.depth;
+        else if (token == "nodes") input >> limits.nodes;
+        else if (token == "movetime") input >> limits.moveTimeMs;
+        else if (token == "mate") input >> mateMoves;
+        else if (token == "infinite") limits.infinite = true;
+        else if (token == "ponder") limits.ponder = true;
+    }
+
+    // A book move needs no search; pondering and analysis always search
+    if (ownBook && !limits.ponder && !limits.infinite) {
+        BoardMove bookMove = book.pickMove(position);
+        if (!bookMove.isNone()) {
+            send("info string book move");
+            send("bestmove " + bookMove.toUci());
+            return;
+        }
+    }
+
+    // The stop flag is cleared here, on the input thread, so a "stop" that follows at once is kept
+    pool.clearStop();
+    if (mateMoves > 0) {
+        goMate(mateMoves, limits);
+        return;
+    }
+    Board root = position;
+    searchThread = std::thread([this, root, limits]() {
+        SearchResult result = pool.run(root, limits);
+        std::string line = "bestmove " + (result.bestMove.isNone() ? std::string("0000") : result.bestMove.toUci());
+        if (!result.ponderMove.isNone()) line += " ponder " + result.ponderMove.toUci();
+        send(line);
+    });
+}
+
+// "go mate" runs the proof-number solver instead of the alpha-beta search. When it
+// finds no mate, or is stopped first, an ordinary search still picks the move.
+void UciController::goMate(int moves, const SearchLimits& limits) {
+    mateSolver.clearStop();
+    Board root = position;
+    searchThread = std::thread([this, root, limits, moves]() {
+        MateSolver::Limits mateLimits;
+        mateLimits.maxMoves = moves;
+        mateLimits.maxNodes = limits.nodes;
+        mateLimits.moveTimeMs = limits.moveTimeMs;
+        mateLimits.shortest = true;
+        MateSolver::Result mate = mateSolver.solve(root, mateLimits);
+        if (mate.status == MateSolver::Status::Mate && !mate.line.empty()) {
+            std::ostringstream info;
+            info << "info depth " << 2 * mate.mateIn - 1 << " score mate " << mate.mateIn
+                 << " nodes " << mate.nodes << " time " << mate.timeMs << " pv";
+            for (BoardMove move : mate.line) info << ' ' << move.toUci();
+            send(info.str());
+            std::string line = "bestmove " + mate.line[0].toUci();
+            if (mate.line.size() > 1) line += " ponder " + mate.line[1].toUci();
+            send(line);
+            return;
+        }
+
+        send(mate.status == MateSolver::Status::NoMate
+             ? "info string No mate in " + std::to_string(moves)
+             : std::string("info string Mate search stopped"));
+        SearchLimits fallback = limits;
+        if (fallback.depth == 0) fallback.depth = 2 * moves;
+        SearchResult result = pool.run(root, fallback);
+        std::string line = "bestmove " + (result.bestMove.isNone() ? std::string("0000") : result.bestMove.toUci());
+        if (!result.ponderMove.isNone()) line += " ponder " + result.ponderMove.toUci();
+        send(line);
+    });
+}
+
+void UciController::handleSetOption(std::istringstream& input) {
+    std::string token, name, value;
+    input >> token; // "name"
+    while (input >> token && token != "value") name += (name.empty() ? "" : " ") + token;
+    while (input >> token) value += (value.empty() ? "" : " ") + token;
+
+    std::string key = toLower(name);
+    if (key == "hash") {
+        tt.resize(size_t(std::clamp(std::atoi(value.c_str()), 1, MAX_HASH_MB)));
+    } else if (key == "clear hash") {
+        tt.clear();
+        mateSolver.clear();
+        pool.clearHistory();
+    } else if (key == "threads") {
+        pool.setThreadCount(std::clamp(std::atoi(value.c_str()), 1, MAX_THREADS));
+    } else if (key == "multipv") {
+        multiPV = std::clamp(std::atoi(value.c_str()), 1, MAX_MULTIPV);
+    } else if (key == "ownbook") {
+        ownBook = toLower(value) == "true";
+    } else if (key == "bookfile") {
+        if (value.empty() || value == "<empty>") book.close();
+        else if (!book.open(QString::fromStdString(value))) send("info string Cannot open book: " + value);
+    } else if (key == "syzygypath") {
+        auto tablebases = std::make_shared<Tablebases>(QString::fromStdString(value));
+        send("info string Found " + std::to_string(tablebases->tableCount()) + " tablebases");
+        Tablebases::setCurrent(tablebases->tableCount() > 0 ? tablebases : nullptr);
+    } else if (key == "bitbasepath") {
+        auto bitbases = std::make_shared<Bitbases>(QString::fromStdString(value));
+        send("info string Found " + std::to_string(bitbases->tableCount()) + " bitbases");
+        Bitbases::setCurrent(bitbases->tableCount() > 0 ? bitbases : nullptr);
+    } else if (key == "ponder") {
+        // Nothing to set up: pondering is driven entirely by "go ponder" and "ponderhit"
+    } else {
+        for (const SearchToggle& toggle : SEARCH_TOGGLES) {
+            if (key == toLower(toggle.name)) {
+                SearchOptions options = pool.options();
+                options.*toggle.flag = toLower(value) == "true";
+                pool.setOptions(options);
+                return;
+            }
+        }
+        send("info string No such option: " + name);
+    }
+}
+
+void UciController::waitForSearch() {
+    // A GUI must not change the position or options mid-search; if it does, finish the search first
+    if (searchThread.joinable()) {
+        pool.stop();
+        mateSolver.stop();
+        searchThread.join();
+    }
+}
+
+void UciController::stopSearch() {
+    pool.stop();
+    mateSolver.stop();
+    if (searchThread.joinable()) searchThread.join();
+}
+
+std::string UciController::formatInfo(const SearchInfo& info) const {
+    std::ostringstream out;
+    out << "info depth " << info.depth << " seldepth " << info.selDepth << " multipv " << info.multiPv;
+    if (Search::isMateScore(info.score)) out << " score mate " << Search::mateInMoves(info.score);
+    else out << " score cp " << info.score;
+    out << " nodes " << info.nodes << " nps " << info.nps << " hashfull " << info.hashfull
+        << " tbhits " << info.tbHits << " time " << info.timeMs << " pv";
+    for (BoardMove move : info.pv) out << ' ' << move.toUci();
+    return out.str();
+}
@@ -0,0 +1,48 @@
+#ifndef UCI_CONTROLLER_H
+#define UCI_CONTROLLER_H
+
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include "engine/Bitbases.h"
+#include "engine/Board.h"
+#include "engine/MateSolver.h"
+#include "engine/OpeningBook.h"
+#include "engine/Search.h"
+#include "engine/SearchPool.h"
+#include "engine/Tablebases.h"
+#include "engine/TranspositionTable.h"
+
+// Universal Chess Interface front end. The input loop reads commands from stdin
+// while searches run on a thread of their own, so "stop" and "ponderhit" are acted
+// on as soon as they arrive.
+class UciController {
+private:
+    TranspositionTable tt;
+    SearchPool pool;
+    MateSolver mateSolver;
+    Board position;
+    int multiPV = 1;
+    OpeningBook book;
+    bool ownBook = false;
+    std::thread searchThread;
+    std::mutex outputMutex;
+
+    void send(const std::string& line);
+    void handleUci();
+    void handlePosition(std::istringstream& input);
+    void handleGo(std::istringstream& input);
+    void goMate(int moves, const SearchLimits& limits);
+    void handleSetOption(std::istringstream& input);
+    void waitForSearch();
+    void stopSearch();
+    std::string formatInfo(const SearchInfo& info) const;
+
+public:
+    UciController();
+    ~UciController();
+    void run();
+};
+
+#endif // UCI_CONTROLLER_H
@@ -9,8 +9,9 @@
 #include "model/pieces/Queen.h"
 #include "model/pieces/King.h"
 
-#include <sstream>
+#include <algorithm>
 #include <cctype>
+#include <cstring>
 #include <QDebug>
 
 Piece* FenUtils::createPieceFromChar(char typeChar) {
@@ -29,186 +30,305 @@ Piece* FenUtils::createPieceFromChar(char typeChar) {
     }
 }
 
-bool FenUtils::parseFen(const std::string& fen, ChessModel& model) {
-    model.clearBoard();
-    model.clearCapturedPieces(); 
-    model.whiteToMove = true;
-    for (int i = 0; i < 4; ++i) model.castlingRights[i] = false;
-    delete model.enPassantTarget;
-    model.enPassantTarget = nullptr;
+namespace {
+
+bool isFenSpace(char c) {
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
 
-    std::istringstream fenStream(fen);
-    std::string segment;
+void skipSpaces(std::string_view text, size_t& i) {
+    while (i < text.size() && isFenSpace(text[i])) ++i;
+}
+
+// A run of digits up to the next space, within limit
+bool readNumber(std::string_view text, size_t& i, int limit, int& value) {
+    const size_t start = i;
+    value = 0;
+    while (i < text.size() && text[i] >= '0' && text[i] <= '9') {
+        value = value * 10 + (text[i] - '0');
+        if (value > limit) return false;
+        ++i;
+    }
+    return i > start && (i == text.size() || isFenSpace(text[i]));
+}
 
-    if (!std::getline(fenStream, segment, ' ')) return false;
+} // namespace
+
+FenError FenUtils::parse(std::string_view fen, FenPosition& position, std::string_view* rest) {
+    size_t i = 0;
+    skipSpaces(fen, i);
+
+    // Piece placement, from a8 to h1
+    std::memset(position.squares, 0, sizeof(position.squares));
+    int kings[2] = { 0, 0 };
     int row = 7;
     int col = 0;
-    for (char c : segment) {
+    const char *p = fen.data() + i;
+    const char *end = fen.data() + fen.size();
+    for (; p < end && !isFenSpace(*p); ++p) {
+        const char c = *p;
+        if (unsigned(c - '1') < 8) {
+            col += c - '0';
+            if (col > 8) return FenError::RankLength;
+            continue;
+        }
         if (c == '/') {
-            if (col != 8) qWarning("FEN Parsing Warning: Row %d did not sum to 8 columns.", row + 1);
-            row--;
+            if (col != 8) return FenError::RankLength;
+            if (--row < 0) return FenError::RankCount;
             col = 0;
-            if (row < 0) return false;
-        } else if (std::isdigit(c)) {
-            int emptySquares = c - '0';
-            if (col + emptySquares > 8) return false;
-            col += emptySquares;
-        } else if (std::isalpha(c)) {
-            if (col >= 8) return false;
-            Piece* piece = createPieceFromChar(c);
-            if (piece) {
-                model.board[row][col] = piece;
-            } else {
-                qWarning("FEN Parsing Error: Invalid piece character '%c'", c);
-            }
-            col++;
-        } else {
-             qWarning("FEN Parsing Error: Invalid character '%c' in piece placement segment.", c);
-             return false;
+            continue;
         }
+        switch (c) {
+            case 'P': case 'p':
+                if (row == 0 || row == 7) return FenError::PawnOnBackRank;
+                break;
+            case 'K': kings[0]++; break;
+            case 'k': kings[1]++; break;
+            case 'N': case 'B': case 'R': case 'Q':
+            case 'n': case 'b': case 'r': case 'q':
+                break;
+            default:
+                return FenError::Placement;
+        }
+        if (col >= 8) return FenError::RankLength;
+        position.squares[row * 8 + col++] = c;
     }
-    if (row != 0 || col != 8) {
-        qWarning("FEN Parsing Warning: Did not end at row 0, col 8. Final pos: (%d,%d)", row, col);
+    i = size_t(p - fen.data());
+    if (row != 0) return FenError::RankCount;
+    if (col != 8) return FenError::RankLength;
+    if (kings[0] != 1 || kings[1] != 1) return FenError::KingCount;
+
+    // Active colour
+    skipSpaces(fen, i);
+    if (i + 1 > fen.size() || (fen[i] != 'w' && fen[i] != 'b')
+        || (i + 1 < fen.size() && !isFenSpace(fen[i + 1]))) {
+        return FenError::SideToMove;
     }
+    position.whiteToMove = fen[i++] == 'w';
 
-    if (!std::getline(fenStream, segment, ' ')) return false;
-    if (segment == "w") {
-        model.whiteToMove = true;
-    } else if (segment == "b") {
-        model.whiteToMove = false;
+    // Castling rights, in KQkq order
+    skipSpaces(fen, i);
+    for (bool& right : position.castlingRights) right = false;
+    if (i < fen.size() && fen[i] == '-') {
+        ++i;
     } else {
-        qWarning("FEN Parsing Error: Invalid active color '%s'", segment.c_str());
-        return false;
+        static const char RightLetters[] = "KQkq";
+        int next = 0;
+        const size_t start = i;
+        for (; i < fen.size() && !isFenSpace(fen[i]); ++i) {
+            while (next < 4 && RightLetters[next] != fen[i]) ++next;
+            if (next == 4) return FenError::Castling;
+            position.castlingRights[next++] = true;
+        }
+        if (i == start) return FenError::Castling;
     }
+    if (i < fen.size() && !isFenSpace(fen[i])) return FenError::Castling;
 
-    if (!std::getline(fenStream, segment, ' ')) return false;
-    if (segment != "-") {
-        for (char c : segment) {
-            switch (c) {
-                case 'K': model.castlingRights[0] = true; break;
-                case 'Q': model.castlingRights[1] = true; break;
-                case 'k': model.castlingRights[2] = true; break;
-                case 'q': model.castlingRights[3] = true; break;
-                default: qWarning("FEN Parsing Warning: Invalid castling character '%c'", c); break;
-            }
+    // En passant target: behind a pawn of the side that just moved, on an empty square
+    skipSpaces(fen, i);
+    position.enPassantSquare = -1;
+    if (i < fen.size() && fen[i] == '-') {
+        ++i;
+    } else {
+        if (i + 2 > fen.size() || fen[i] < 'a' || fen[i] > 'h') return FenError::EnPassant;
+        const int epCol = fen[i] - 'a';
+        const int epRow = fen[i + 1] - '1';
+        const int pawnRow = position.whiteToMove ? 4 : 3;
+        if (epRow != (position.whiteToMove ? 5 : 2)
+            || position.squares[pawnRow * 8 + epCol] != (position.whiteToMove ? 'p' : 'P')
+            || position.squares[epRow * 8 + epCol] != 0) {
+            return FenError::EnPassant;
         }
+        position.enPassantSquare = epRow * 8 + epCol;
+        i += 2;
     }
+    if (i < fen.size() && !isFenSpace(fen[i])) return FenError::EnPassant;
 
-    if (!std::getline(fenStream, segment, ' ')) return false;
-    if (segment != "-") {
-        if (segment.length() == 2 && segment[0] >= 'a' && segment[0] <= 'h' && segment[1] >= '1' && segment[1] <= '8') {
-            int epCol = segment[0] - 'a';
-            int epRow = segment[1] - '1';
-
-            if (!((model.whiteToMove && epRow == 5) || (!model.whiteToMove && epRow == 2))) {
-                qWarning("FEN Parsing Warning: En passant target square %s is inconsistent with side to move.", segment.c_str());
-            }
-
-            int pawnStartRow = model.whiteToMove ? epRow - 1 : epRow + 1;
-            int pawnEndRow = model.whiteToMove ? epRow + 1 : epRow - 1;
-            if (pawnStartRow >= 0 && pawnStartRow < 8 && pawnEndRow >=0 && pawnEndRow < 8) {
-                Piece* adjacentPawn = model.getPiece(pawnStartRow, epCol);
-                if (!adjacentPawn || adjacentPawn->type != 'P' || adjacentPawn->isWhite == model.whiteToMove) {
-                    qWarning("FEN Parsing Warning: No opponent pawn could have created the en passant target %s", segment.c_str());
-                }
-                if (model.getPiece(pawnEndRow, epCol) != nullptr) {
-                    qWarning("FEN Parsing Warning: Square behind en passant target %s is occupied.", segment.c_str());
-                }
-            }
-
-            delete model.enPassantTarget;
-            model.enPassantTarget = new Position(epRow, epCol);
-        } else {
-            qWarning("FEN Parsing Error: Invalid en passant target square format '%s'", segment.c_str());
+    // Move counters, when present
+    position.halfmoveClock = 0;
+    position.fullmoveNumber = 1;
+    skipSpaces(fen, i);
+    if (i < fen.size() && fen[i] >= '0' && fen[i] <= '9') {
+        if (!readNumber(fen, i, MAX_HALFMOVE_CLOCK, position.halfmoveClock)) return FenError::HalfmoveClock;
+        skipSpaces(fen, i);
+        if (i < fen.size() && (fen[i] >= '0' && fen[i] <= '9')) {
+            if (!readNumber(fen, i, MAX_FULLMOVE_NUMBER, position.fullmoveNumber)) return FenError::FullmoveNumber;
+            if (position.fullmoveNumber == 0) position.fullmoveNumber = 1;
+            skipSpaces(fen, i);
+        } else if (!rest) {
+            return FenError::FullmoveNumber;
         }
+    } else if (!rest && i < fen.size()) {
+        return FenError::HalfmoveClock;
     }
 
-    if (std::getline(fenStream, segment, ' ')) {
-        try {
-            std::stoi(segment);
-        } catch (...) {
-            qWarning("FEN Parsing Warning: Invalid halfmove clock value '%s'", segment.c_str());
-        }
-    } else {
-        qWarning("FEN Parsing Warning: Missing halfmove clock.");
+    if (rest) *rest = fen.substr(i);
+    else if (i != fen.size()) return FenError::TrailingText;
+    return FenError::None;
+}
+
+const char* FenUtils::errorMessage(FenError error) {
+    switch (error) {
+        case FenError::None: return "no error";
+        case FenError::Placement: return "invalid character in the piece placement";
+        case FenError::RankLength: return "a rank does not have eight squares";
+        case FenError::RankCount: return "the placement does not have eight ranks";
+        case FenError::KingCount: return "each side needs exactly one king";
+        case FenError::PawnOnBackRank: return "pawn on the first or eighth rank";
+        case FenError::SideToMove: return "the side to move is not 'w' or 'b'";
+        case FenError::Castling: return "invalid castling rights";
+        case FenError::EnPassant: return "invalid en passant square";
+        case FenError::HalfmoveClock: return "invalid halfmove clock";
+        case FenError::FullmoveNumber: return "invalid fullmove number";
+        case FenError::TrailingText: return "unexpected text after the fullmove number";
     }
+    return "unknown error";
+}
 
-    if (std::getline(fenStream, segment, ' ')) {
-        try {
-            std::stoi(segment);
-        } catch (...) {
-            qWarning("FEN Parsing Warning: Invalid fullmove number value '%s'", segment.c_str());
-        }
-    } else {
-        qWarning("FEN Parsing Warning: Missing fullmove number.");
+FenError FenUtils::parseFen(std::string_view fen, ChessModel& model) {
+    FenPosition position;
+    const FenError error = parse(fen, position);
+    if (error != FenError::None) return error;
+
+    model.clearBoard();
+    model.clearCapturedPieces();
+    for (int sq = 0; sq < 64; ++sq) {
+        if (position.squares[sq]) model.board[sq / 8][sq % 8] = createPieceFromChar(position.squares[sq]);
     }
+    model.whiteToMove = position.whiteToMove;
+    for (int i = 0; i < 4; ++i) model.castlingRights[i] = position.castlingRights[i];
+    delete model.enPassantTarget;
+    model.enPassantTarget = position.enPassantSquare < 0
+                          ? nullptr
+                          : new Position(position.enPassantSquare / 8, position.enPassantSquare % 8);
+    model.halfmoveClock = position.halfmoveClock;
+    model.fullmoveNumber = position.fullmoveNumber;
+    model.positionKeys.assign(1, model.computePositionKey());
 
     model.updateCurrentValidMoves();
-    return true;
+    return FenError::None;
 }
 
-std::string FenUtils::generateFen(const ChessModel& model) {
-    std::ostringstream fen;
+// Writes value in decimal at out and returns the position after it
+static char* writeNumber(char* out, int value) {
+    char digits[10];
+    int count = 0;
+    do {
+        digits[count++] = char('0' + value % 10);
+        value /= 10;
+    } while (value > 0);
+    while (count > 0) *out++ = digits[--count];
+    return out;
+}
 
+// The four position fields shared by FEN and EPD; out needs room for 81 characters
+static char* writeFields(const FenPosition& position, char* out) {
     for (int row = 7; row >= 0; --row) {
         int emptyCount = 0;
         for (int col = 0; col < 8; ++col) {
-            Piece* p = model.board[row][col];
-            if (p == nullptr) {
+            const char piece = position.squares[row * 8 + col];
+            if (piece == 0) {
                 emptyCount++;
-            } else {
-                if (emptyCount > 0) {
-                    fen << emptyCount;
-                    emptyCount = 0;
-                }
-                fen << (p->isWhite ? p->type : (char)std::tolower(p->type));
+                continue;
             }
+            if (emptyCount > 0) {
+                *out++ = char('0' + emptyCount);
+                emptyCount = 0;
+            }
+            *out++ = piece;
         }
-        if (emptyCount > 0) {
-            fen << emptyCount;
-        }
-        if (row > 0) {
-            fen << '/';
-        }
+        if (emptyCount > 0) *out++ = char('0' + emptyCount);
+        if (row > 0) *out++ = '/';
     }
 
-    fen << ' ' << (model.whiteToMove ? 'w' : 'b');
-
-    fen << ' ';
-    std::string castleStr = "";
-    if (model.castlingRights[0]) castleStr += 'K';
-    if (model.castlingRights[1]) castleStr += 'Q';
-    if (model.castlingRights[2]) castleStr += 'k';
-    if (model.castlingRights[3]) castleStr += 'q';
-    fen << (castleStr.empty() ? "-" : castleStr);
-
-    fen << ' ';
-    if (model.enPassantTarget != nullptr && model.enPassantTarget->isValid()) {
-        int epRow = model.enPassantTarget->row;
-        int epCol = model.enPassantTarget->col;
-        bool validEp = false;
-
-        if (!model.whiteToMove && epRow == 5) {
-            Piece* p1 = model.getPiece(4, epCol);
-            if (p1 && p1->type == 'P' && !p1->isWhite) validEp = true;
-        } else if (model.whiteToMove && epRow == 2) {
-            Piece* p1 = model.getPiece(3, epCol);
-            if (p1 && p1->type == 'P' && p1->isWhite) validEp = true;
-        }
+    *out++ = ' ';
+    *out++ = position.whiteToMove ? 'w' : 'b';
 
-        if (validEp) {
-            fen << (char)('a' + epCol) << (char)('1' + epRow);
-        } else {
-            qWarning("FEN Generation Warning: En passant target square (%d,%d) is invalid for current state. Writing '-' instead.", epRow, epCol);
-            fen << '-';
-        }
+    *out++ = ' ';
+    const char* castling = "KQkq";
+    char* castlingStart = out;
+    for (int i = 0; i < 4; ++i) {
+        if (position.castlingRights[i]) *out++ = castling[i];
+    }
+    if (out == castlingStart) *out++ = '-';
 
+    *out++ = ' ';
+    if (position.enPassantSquare >= 0) {
+        *out++ = char('a' + position.enPassantSquare % 8);
+        *out++ = char('1' + position.enPassantSquare / 8);
     } else {
-        fen << '-';
+        *out++ = '-';
     }
+    return out;
+}
 
-    fen << " 0";
-    fen << " 1";
+size_t FenUtils::write(const FenPosition& position, char (&out)[FEN_BUFFER_SIZE]) {
+    char* end = writeFields(position, out);
+    // Clamped so the record always fits the buffer
+    *end++ = ' ';
+    end = writeNumber(end, std::min(std::max(position.halfmoveClock, 0), MAX_HALFMOVE_CLOCK));
+    *end++ = ' ';
+    end = writeNumber(end, std::min(std::max(position.fullmoveNumber, 1), MAX_FULLMOVE_NUMBER));
+    *end = '\0';
+    return size_t(end - out);
+}
+
+size_t FenUtils::writeEpd(const FenPosition& position, std::string_view operations, char* out, size_t size) {
+    char fields[EPD_FIELDS_SIZE];
+    char* end = writeFields(position, fields);
+    end = std::copy_n(" hmvc ", 6, end);
+    end = writeNumber(end, std::min(std::max(position.halfmoveClock, 0), MAX_HALFMOVE_CLOCK));
+    end = std::copy_n("; fmvn ", 7, end);
+    end = writeNumber(end, std::min(std::max(position.fullmoveNumber, 1), MAX_FULLMOVE_NUMBER));
+    *end++ = ';';
 
-    return fen.str();
+    const size_t fieldsLength = size_t(end - fields);
+    const size_t length = fieldsLength + (operations.empty() ? 0 : 1 + operations.size());
+    if (length >= size) return 0;
+    std::memcpy(out, fields, fieldsLength);
+    if (!operations.empty()) {
+        out[fieldsLength] = ' ';
+        std::memcpy(out + fieldsLength + 1, operations.data(), operations.size());
+    }
+    out[length] = '\0';
+    return length;
+}
+
+void FenUtils::fromModel(const ChessModel& model, FenPosition& position) {
+    for (int row = 0; row < 8; ++row) {
+        for (int col = 0; col < 8; ++col) {
+            const Piece* p = model.board[row][col];
+            position.squares[row * 8 + col] = p == nullptr ? 0 : (p->isWhite ? p->type : char(std::tolower(p->type)));
+        }
+    }
+    position.whiteToMove = model.whiteToMove;
+    for (int i = 0; i < 4; ++i) position.castlingRights[i] = model.castlingRights[i];
+
+    // The model keeps the target after every double step; it belongs in the record only
+    // when the pawn that made it is still in front of it
+    position.enPassantSquare = -1;
+    const Position* target = model.enPassantTarget;
+    if (target != nullptr && target->isValid()) {
+        const bool blackToMove = !model.whiteToMove;
+        const int pawnRow = blackToMove ? 3 : 4;
+        const Piece* pawn = model.board[pawnRow][target->col];
+        if (target->row == (blackToMove ? 2 : 5) && pawn && pawn->type == 'P' && pawn->isWhite == blackToMove) {
+            position.enPassantSquare = target->row * 8 + target->col;
+        }
+    }
+
+    position.halfmoveClock = model.halfmoveClock;
+    position.fullmoveNumber = model.fullmoveNumber;
+}
+
+size_t FenUtils::writeFen(const ChessModel& model, char (&out)[FEN_BUFFER_SIZE]) {
+    FenPosition position;
+    fromModel(model, position);
+    return write(position, out);
+}
+
+std::string FenUtils::generateFen(const ChessModel& model) {
+    char fen[FEN_BUFFER_SIZE];
+    const size_t length = writeFen(model, fen);
+    return std::string(fen, length);
 }
@@ -1,18 +1,74 @@
 #ifndef FENUTILS_H
 #define FENUTILS_H
 
+#include <cstddef>
 #include <string>
+#include <string_view>
 
 class ChessModel;
 class Piece;
 
+enum class FenError {
+    None,
+    Placement,       // a character that is no piece, digit or '/'
+    RankLength,      // a rank that does not add up to eight squares
+    RankCount,       // not eight ranks
+    KingCount,       // not exactly one king of each colour
+    PawnOnBackRank,
+    SideToMove,
+    Castling,        // not "-" or some of "KQkq" in that order
+    EnPassant,       // malformed, or no pawn can just have moved past the square
+    HalfmoveClock,
+    FullmoveNumber,
+    TrailingText
+};
+
+// The fields of a FEN record, before they go into a ChessModel or a Board
+struct FenPosition {
+    char squares[64];        // FEN piece letter or 0, indexed row * 8 + col from a1
+    bool whiteToMove = true;
+    bool castlingRights[4];  // same order as ChessModel: K, Q, k, q
+    int enPassantSquare = -1;
+    int halfmoveClock = 0;
+    int fullmoveNumber = 1;
+};
+
 class FenUtils {
 public:
-    static bool parseFen(const std::string& fen, ChessModel& model);
+    // The longest record write() produces, with its terminating null: the counters are
+    // clamped to MAX_HALFMOVE_CLOCK and MAX_FULLMOVE_NUMBER
+    static constexpr size_t FEN_BUFFER_SIZE = 92;
+    static constexpr int MAX_HALFMOVE_CLOCK = 999;
+    static constexpr int MAX_FULLMOVE_NUMBER = 99999;
 
+    // Reads a FEN record in one pass without allocating. The move counters may be left
+    // out (they are then 0 and 1), and a fullmove number of 0 is read as 1. Counters above
+    // MAX_HALFMOVE_CLOCK and MAX_FULLMOVE_NUMBER are errors, so write() gives back the
+    // record that was read. With rest given, parsing stops after the fields and rest gets
+    // the remaining text, such as the operations of an EPD record; otherwise anything but
+    // whitespace is an error.
+    static FenError parse(std::string_view fen, FenPosition& position, std::string_view* rest = nullptr);
+    static const char* errorMessage(FenError error);
+
+    // Leaves the model untouched when the record is invalid
+    static FenError parseFen(std::string_view fen, ChessModel& model);
+
+    // Write a null-terminated record into out without allocating and return its length
+    static size_t write(const FenPosition& position, char (&out)[FEN_BUFFER_SIZE]);
+    static size_t writeFen(const ChessModel& model, char (&out)[FEN_BUFFER_SIZE]);
+    // An EPD record: the four position fields, the counters as hmvc and fmvn, then the
+    // given operations (such as "bm Nf3; id \"x\";"). Returns 0 if it does not fit in size.
+    static size_t writeEpd(const FenPosition& position, std::string_view operations, char* out, size_t size);
+
+    // The en passant square is only kept when the pawn that passed it is still there
+    static void fromModel(const ChessModel& model, FenPosition& position);
     static std::string generateFen(const ChessModel& model);
 
 private:
+    // The fields writeEpd() builds before the operations, at their longest: 81 bytes of
+    // position fields, then " hmvc 999; fmvn 99999;"
+    static constexpr size_t EPD_FIELDS_SIZE = 104;
+
     static Piece* createPieceFromChar(char typeChar);
 };
 
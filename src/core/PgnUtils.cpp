@@ -0,0 +1,199 @@
+#include "core/PgnUtils.h"
+
+namespace {
+
+bool isSpace(char c) { return c == ' ' || c == '\n' || c == '\r' || c == '\t' || c == '\f' || c == '\v'; }
+bool isDigit(char c) { return c >= '0' && c <= '9'; }
+
+std::string* tagField(PgnGame& game, std::string_view name) {
+    if (name == "Event") return &game.event;
+    if (name == "Site") return &game.site;
+    if (name == "Date") return &game.date;
+    if (name == "Round") return &game.round;
+    if (name == "White") return &game.white;
+    if (name == "Black") return &game.black;
+    if (name == "Result") return &game.result;
+    if (name == "FEN") return &game.fen;
+    return nullptr;
+}
+
+// Skips a variation, with the comments and variations inside it; i is at its '('
+bool skipVariation(std::string_view text, size_t& i) {
+    int depth = 0;
+    while (i < text.size()) {
+        const char c = text[i++];
+        if (c == '(') {
+            depth++;
+        } else if (c == ')') {
+            if (--depth == 0) return true;
+        } else if (c == '{') {
+            const size_t close = text.find('}', i);
+            if (close == std::string_view::npos) return false;
+            i = close + 1;
+        } else if (c == ';') {
+            const size_t eol = text.find('\n', i);
+            i = eol == std::string_view::npos ? text.size() : eol + 1;
+        }
+    }
+    return false;
+}
+
+} // namespace
+
+void PgnGame::clear() {
+    event.clear();
+    site.clear();
+    date.clear();
+    round.clear();
+    white.clear();
+    black.clear();
+    result.clear();
+    fen.clear();
+    moves.clear();
+    errorToken = std::string_view();
+    moveError = SanError::None;
+}
+
+bool PgnUtils::nextGame(std::string_view text, size_t& pos, bool atEnd, std::string_view& game) {
+    size_t i = pos;
+    while (i < text.size() && isSpace(text[i])) ++i;
+    if (i == text.size()) {
+        if (atEnd) pos = i;
+        return false;
+    }
+
+    // Tag lines after movetext start the next game; a '[' inside a comment does not
+    const size_t start = i;
+    bool inMovetext = false;
+    bool inComment = false;
+    while (i < text.size()) {
+        const size_t eol = text.find('\n', i);
+        const size_t lineEnd = eol == std::string_view::npos ? text.size() : eol;
+        if (!inComment && text[i] == '[') {
+            if (inMovetext) {
+                game = text.substr(start, i - start);
+                pos = i;
+                return true;
+            }
+        } else {
+            for (size_t j = i; j < lineEnd; ++j) {
+                const char c = text[j];
+                if (c == '{') inComment = true;
+                else if (c == '}') inComment = false;
+                else if (!isSpace(c)) inMovetext = true;
+            }
+        }
+        if (eol == std::string_view::npos) break;
+        i = eol + 1;
+    }
+    if (!atEnd) return false;
+    game = text.substr(start);
+    pos = text.size();
+    return true;
+}
+
+PgnError PgnUtils::parseGame(std::string_view text, PgnGame& game, Board& board) {
+    game.clear();
+    const size_t n = text.size();
+    size_t i = 0;
+
+    while (true) {
+        while (i < n && isSpace(text[i])) ++i;
+        if (i == n || text[i] != '[') break;
+        const size_t nameStart = ++i;
+        while (i < n && !isSpace(text[i]) && text[i] != '"' && text[i] != ']') ++i;
+        std::string* field = tagField(game, text.substr(nameStart, i - nameStart));
+        while (i < n && isSpace(text[i])) ++i;
+        if (i == n || text[i] != '"') return PgnError::Tag;
+        ++i;
+        while (i < n && text[i] != '"') {
+            if (text[i] == '\\' && i + 1 < n && (text[i + 1] == '"' || text[i + 1] == '\\')) ++i;
+            if (field) field->push_back(text[i]);
+            ++i;
+        }
+        if (i == n) return PgnError::Tag;
+        ++i;
+        while (i < n && isSpace(text[i])) ++i;
+        if (i == n || text[i] != ']') return PgnError::Tag;
+        ++i;
+    }
+
+    if (!board.setFromFen(game.fen.empty() ? std::string_view(Board::START_FEN) : std::string_view(game.fen))) {
+        return PgnError::Fen;
+    }
+
+    bool terminated = false;
+    while (i < n && !terminated) {
+        const char c = text[i];
+        if (isSpace(c)) {
+            ++i;
+        } else if (c == '{') {
+            const size_t close = text.find('}', i);
+            if (close == std::string_view::npos) return PgnError::Comment;
+            i = close + 1;
+        } else if (c == ';' || (c == '%' && (i == 0 || text[i - 1] == '\n'))) {
+            const size_t eol = text.find('\n', i);
+            i = eol == std::string_view::npos ? n : eol + 1;
+        } else if (c == '(') {
+            if (!skipVariation(text, i)) return PgnError::Comment;
+        } else if (c == ')') {
+            ++i; // the close of a variation that was never opened
+        } else if (c == '$') {
+            ++i;
+            while (i < n && isDigit(text[i])) ++i;
+        } else {
+            const size_t start = i;
+            while (i < n && !isSpace(text[i]) && text[i] != '{' && text[i] != ';' && text[i] != '(' && text[i] != ')') ++i;
+            std::string_view token = text.substr(start, i - start);
+            if (token == "1-0" || token == "0-1" || token == "1/2-1/2" || token == "*") {
+                if (game.result.empty()) game.result = std::string(token);
+                terminated = true;
+                continue;
+            }
+
+            // A move number, "12." or "12...", may be glued to the move; "0-0" is no number
+            size_t digits = 0;
+            while (digits < token.size() && isDigit(token[digits])) ++digits;
+            if (digits == token.size() || (digits > 0 && token[digits] == '.') || (digits == 0 && token[0] == '.')) {
+                while (digits < token.size() && token[digits] == '.') ++digits;
+                token.remove_prefix(digits);
+                if (token.empty()) continue;
+            }
+
+            BoardMove move;
+            const SanError error = San::parse(board, token, move);
+            if (error != SanError::None) {
+                game.errorToken = token;
+                game.moveError = error;
+                return PgnError::Move;
+            }
+            game.moves.push_back(move);
+            board.makeMove(move);
+        }
+    }
+    if (game.moves.empty() && !terminated) return PgnError::NoMoves;
+    return PgnError::None;
+}
+
+const char* PgnUtils::errorMessage(PgnError error) {
+    switch (error) {
+        case PgnError::None: return "no error";
+        case PgnError::Tag: return "malformed tag pair";
+        case PgnError::Fen: return "invalid FEN tag";
+        case PgnError::Move: return "illegal or malformed move";
+        case PgnError::Comment: return "unterminated comment or variation";
+        case PgnError::NoMoves: return "no moves and no result";
+    }
+    return "unknown error";
+}
+
+void PgnUtils::writeTag(std::string& out, std::string_view name, std::string_view value) {
+    out += '[';
+    out.append(name);
+    out += " \"";
+    for (const char c : value) {
+        if (c == '"' || c == '\\') out += '\\';
+        out += c;
+    }
+    out += "\"]\n";
+}
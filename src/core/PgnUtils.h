@@ -0,0 +1,56 @@
+#ifndef PGNUTILS_H
+#define PGNUTILS_H
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include "engine/Board.h"
+#include "engine/San.h"
+
+enum class PgnError {
+    None,
+    Tag,       // a tag pair that is not [Name "Value"]
+    Fen,       // a FEN tag that does not parse
+    Move,      // a move that is not legal in the position; see PgnGame::moveError
+    Comment,   // a comment or variation that is never closed
+    NoMoves    // neither a move nor a result
+};
+
+// One game of a PGN file: the Seven Tag Roster, the starting position and the moves
+struct PgnGame {
+    std::string event;
+    std::string site;
+    std::string date;
+    std::string round;
+    std::string white;
+    std::string black;
+    std::string result;
+    std::string fen;  // empty for the standard starting position
+    std::vector<BoardMove> moves;
+
+    // The token parsing stopped at, and why San rejected it
+    std::string_view errorToken;
+    SanError moveError = SanError::None;
+
+    // Keeps the capacity, so a worker can reuse one PgnGame for every game
+    void clear();
+};
+
+class PgnUtils {
+public:
+    // Finds the game starting at pos (skipping blank lines) and moves pos past it. A game
+    // ends where the tags of the next one begin. Without atEnd, a game that runs to the
+    // end of text may continue in the next chunk, so nothing is returned and pos stays.
+    static bool nextGame(std::string_view text, size_t& pos, bool atEnd, std::string_view& game);
+
+    // Reads the tags and the main line of one game, skipping comments, variations, NAGs
+    // and move numbers; every move is checked by San::parse on board, which is left at
+    // the final position
+    static PgnError parseGame(std::string_view text, PgnGame& game, Board& board);
+    static const char* errorMessage(PgnError error);
+
+    // Appends [name "value"] and a newline, escaping quotes and backslashes in value
+    static void writeTag(std::string& out, std::string_view name, std::string_view value);
+};
+
+#endif // PGNUTILS_H
@@ -11,9 +11,6 @@ class Utils {
 public:
     static std::string positionToString(const Position& pos);
     static std::string moveToSAN(const Move& move, const ChessModel& model);
-
-private:
-    static std::string getDisambiguation(const Move& move, const ChessModel& model);
 };
 
 #endif
@@ -0,0 +1,386 @@
+#include "engine/BitbaseGenerator.h"
+#include "engine/Board.h"
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <thread>
+
+namespace {
+
+Bitboard occupancy(const BitbasePosition& pos, int color = -1) {
+    Bitboard bb = 0;
+    for (int i = 0; i < pos.count; ++i) {
+        if (color < 0 || pieceColor(pos.pieces[i]) == color) bb |= squareBB(pos.squares[i]);
+    }
+    return bb;
+}
+
+bool isAttacked(const BitbasePosition& pos, int sq, Color by, Bitboard occupied) {
+    for (int i = 0; i < pos.count; ++i) {
+        if (pieceColor(pos.pieces[i]) != by) continue;
+        const PieceType type = pieceType(pos.pieces[i]);
+        const Bitboard attacks = type == PAWN ? Bitboards::pawnAttacks(by, pos.squares[i])
+                                              : Bitboards::attacks(type, pos.squares[i], occupied);
+        if (attacks & squareBB(sq)) return true;
+    }
+    return false;
+}
+
+bool isLegalPosition(const BitbasePosition& pos) {
+    const Bitboard occupied = occupancy(pos);
+    if (popCount(occupied) != pos.count) return false;
+    for (int i = 2; i < pos.count; ++i) {
+        if (pieceType(pos.pieces[i]) == PAWN && (squareBB(pos.squares[i]) & (Bitboards::RANK_1 | Bitboards::RANK_8))) {
+            return false;
+        }
+    }
+    // The side that just moved cannot be in check
+    return !isAttacked(pos, pos.squares[!pos.side], pos.side, occupied);
+}
+
+// Calls visit(next, changesMaterial) for every legal move until it returns false.
+// Kings stay in the first two slots; a capture closes the gap it leaves.
+template<typename Visit>
+void forEachMove(const BitbasePosition& pos, Visit visit) {
+    const Color us = pos.side;
+    const Bitboard occupied = occupancy(pos);
+    const Bitboard own = occupancy(pos, us);
+
+    for (int i = 0; i < pos.count; ++i) {
+        if (pieceColor(pos.pieces[i]) != us) continue;
+        const int from = pos.squares[i];
+        const PieceType type = pieceType(pos.pieces[i]);
+
+        Bitboard targets;
+        if (type == PAWN) {
+            const int forward = us == WHITE ? 8 : -8;
+            targets = Bitboards::pawnAttacks(us, from) & (occupied & ~own);
+            if (!(occupied & squareBB(from + forward))) {
+                targets |= squareBB(from + forward);
+                const int startRow = us == WHITE ? 1 : 6;
+                if (rowOf(from) == startRow && !(occupied & squareBB(from + 2 * forward))) {
+                    targets |= squareBB(from + 2 * forward);
+                }
+            }
+        } else {
+            targets = Bitboards::attacks(type, from, occupied) & ~own;
+        }
+
+        while (targets) {
+            const int to = popLsb(targets);
+            BitbasePosition next = pos;
+            int moved = i;
+            bool changesMaterial = false;
+            for (int j = 2; j < next.count; ++j) {
+                if (next.squares[j] != to) continue;
+                for (int k = j; k + 1 < next.count; ++k) {
+                    next.pieces[k] = next.pieces[k + 1];
+                    next.squares[k] = next.squares[k + 1];
+                }
+                next.count--;
+                if (j < moved) moved--;
+                changesMaterial = true;
+                break;
+            }
+            next.squares[moved] = to;
+            next.side = !us;
+
+            const Bitboard nextOccupied = occupancy(next);
+            if (isAttacked(next, next.squares[us], !us, nextOccupied)) continue;
+
+            if (type == PAWN && (rowOf(to) == 0 || rowOf(to) == 7)) {
+                for (PieceType promotion : { QUEEN, ROOK, BISHOP, KNIGHT }) {
+                    next.pieces[moved] = makePiece(us, promotion);
+                    if (!visit(next, true)) return;
+                }
+            } else if (!visit(next, changesMaterial)) {
+                return;
+            }
+        }
+    }
+}
+
+// Calls visit(previous) for every position that reaches pos by a quiet move of the
+// side that just moved. Captures and promotions come from bigger tables.
+template<typename Visit>
+void forEachUnmove(const BitbasePosition& pos, Visit visit) {
+    const Color them = !pos.side;
+    const Bitboard occupied = occupancy(pos);
+
+    for (int i = 0; i < pos.count; ++i) {
+        if (pieceColor(pos.pieces[i]) != them) continue;
+        const int to = pos.squares[i];
+        const PieceType type = pieceType(pos.pieces[i]);
+
+        Bitboard origins;
+        if (type == PAWN) {
+            const int back = them == WHITE ? -8 : 8;
+            const int row = rowOf(to);
+            origins = 0;
+            if (row != (them == WHITE ? 1 : 6) && !(occupied & squareBB(to + back))) {
+                origins |= squareBB(to + back);
+                if (row == (them == WHITE ? 3 : 4) && !(occupied & squareBB(to + 2 * back))) {
+                    origins |= squareBB(to + 2 * back);
+                }
+            }
+        } else {
+            origins = Bitboards::attacks(type, to, occupied) & ~occupied;
+        }
+
+        while (origins) {
+            BitbasePosition previous = pos;
+            previous.squares[i] = popLsb(origins);
+            previous.side = them;
+            visit(previous);
+        }
+    }
+}
+
+std::string materialName(const std::vector<int>& pieces) {
+    BitbasePosition pos;
+    pos.count = int(pieces.size());
+    for (int i = 0; i < pos.count; ++i) {
+        pos.pieces[i] = pieces[i];
+        pos.squares[i] = i;
+    }
+    return Bitbases::normalize(pos);
+}
+
+} // namespace
+
+BitbaseGenerator::BitbaseGenerator(int threads) : threads(std::max(1, threads)) {}
+
+bool BitbaseGenerator::generate(const std::string& name, const std::string& directory, const Progress& progress) {
+    const std::string canonical = Bitbases::canonicalName(name);
+    if (canonical.empty()) return false;
+    if (tables.count(canonical)) return true;
+
+    std::vector<int> pieces;
+    Bitbases::tablePieces(canonical, pieces);
+    for (size_t i = 2; i < pieces.size(); ++i) {
+        // Captures of this piece, and promotions when it is a pawn
+        std::vector<int> smaller = pieces;
+        smaller.erase(smaller.begin() + long(i));
+        if (smaller.size() > 2 && !generate(materialName(smaller), directory, progress)) return false;
+        if (pieceType(pieces[i]) != PAWN) continue;
+        for (PieceType promotion : { QUEEN, ROOK, BISHOP, KNIGHT }) {
+            std::vector<int> promoted = pieces;
+            promoted[i] = makePiece(pieceColor(pieces[i]), promotion);
+            if (!generate(materialName(promoted), directory, progress)) return false;
+        }
+    }
+    return build(canonical, directory, progress);
+}
+
+void BitbaseGenerator::parallelFor(uint64_t count, uint64_t grain,
+                                   const std::function<void(uint64_t, uint64_t, int)>& body) const {
+    std::atomic<uint64_t> next { 0 };
+    auto work = [&](int worker) {
+        while (true) {
+            const uint64_t begin = next.fetch_add(grain);
+            if (begin >= count) break;
+            body(begin, std::min(begin + grain, count), worker);
+        }
+    };
+    std::vector<std::thread> pool;
+    for (int worker = 1; worker < threads; ++worker) pool.emplace_back(work, worker);
+    work(0);
+    for (std::thread& thread : pool) thread.join();
+}
+
+BitbaseGenerator::Cell BitbaseGenerator::cell(const Table& table, uint64_t index) {
+    return Cell((table.cells[index >> 2].load(std::memory_order_relaxed) >> ((index & 3) * 2)) & 3);
+}
+
+bool BitbaseGenerator::trySet(const Table& table, uint64_t index, Cell value) {
+    std::atomic<uint8_t>& byte = table.cells[index >> 2];
+    const int shift = int(index & 3) * 2;
+    uint8_t old = byte.load(std::memory_order_relaxed);
+    while (((old >> shift) & 3) == UNKNOWN) {
+        if (byte.compare_exchange_weak(old, uint8_t(old | (value << shift)), std::memory_order_relaxed)) return true;
+    }
+    return false;
+}
+
+bool BitbaseGenerator::decode(const Table& table, uint64_t index, BitbasePosition& pos) const {
+    pos.count = int(table.pieces.size());
+    uint64_t rest = index;
+    for (int i = pos.count - 1; i >= 1; --i) {
+        pos.pieces[i] = table.pieces[size_t(i)];
+        pos.squares[i] = int(rest % 64);
+        rest /= 64;
+    }
+    const uint64_t kingSquares = table.size / 2 / (uint64_t(1) << (6 * (pos.count - 1)));
+    pos.pieces[0] = table.pieces[0];
+    pos.squares[0] = squareOf(int(rest % kingSquares) / 4, int(rest % kingSquares) % 4);
+    pos.side = Color(rest / kingSquares);
+    // Mirror images and swapped identical pieces have an index of their own elsewhere
+    return isLegalPosition(pos) && Bitbases::index(pos) == index;
+}
+
+BitbaseGenerator::Cell BitbaseGenerator::resultAfter(const Table& table, const BitbasePosition& pos,
+                                                     bool changesMaterial) const {
+    if (!changesMaterial) return cell(table, Bitbases::index(pos));
+    if (pos.count == 2) return DRAW;
+    BitbasePosition normalized = pos;
+    auto found = tables.find(Bitbases::normalize(normalized));
+    if (found == tables.end()) return DRAW; // generate() makes the smaller tables first
+    const Cell result = cell(found->second, Bitbases::index(normalized));
+    return result == UNKNOWN ? DRAW : result;
+}
+
+bool BitbaseGenerator::build(const std::string& name, const std::string& directory, const Progress& progress) {
+    const auto start = std::chrono::steady_clock::now();
+    Table& table = tables[name];
+    Bitbases::tablePieces(name, table.pieces);
+    table.size = Bitbases::tableSize(name);
+    table.cells.reset(new std::atomic<uint8_t>[(table.size + 3) / 4]());
+
+    Stats stats;
+    stats.name = name;
+    std::vector<std::vector<uint32_t>> found(static_cast<size_t>(threads));
+
+    // Mates, stalemates, and positions whose every in-table move is gone or decided
+    // by a capture or promotion
+    parallelFor(table.size, 1 << 14, [&](uint64_t begin, uint64_t end, int worker) {
+        BitbasePosition pos;
+        for (uint64_t index = begin; index < end; ++index) {
+            if (!decode(table, index, pos)) {
+                trySet(table, index, DRAW);
+                continue;
+            }
+            bool anyMove = false;
+            bool inTable = false;
+            bool winning = false;
+            bool allExitsLose = true;
+            forEachMove(pos, [&](const BitbasePosition& next, bool changesMaterial) {
+                anyMove = true;
+                if (!changesMaterial) {
+                    inTable = true;
+                    return true;
+                }
+                const Cell after = resultAfter(table, next, true);
+                if (after == LOSS) winning = true;
+                if (after != WIN) allExitsLose = false;
+                return !winning;
+            });
+
+            Cell result = UNKNOWN;
+            if (!anyMove) result = isAttacked(pos, pos.squares[pos.side], !pos.side, occupancy(pos)) ? LOSS : DRAW;
+            else if (winning) result = WIN;
+            else if (!inTable) result = allExitsLose ? LOSS : DRAW;
+            if (result == UNKNOWN) continue;
+            trySet(table, index, result);
+            if (result != DRAW) found[size_t(worker)].push_back(uint32_t(index));
+        }
+    });
+
+    std::vector<uint32_t> frontier;
+    while (true) {
+        frontier.clear();
+        for (std::vector<uint32_t>& list : found) {
+            frontier.insert(frontier.end(), list.begin(), list.end());
+            list.clear();
+        }
+        if (frontier.empty()) break;
+        stats.passes++;
+
+        parallelFor(frontier.size(), 1024, [&](uint64_t begin, uint64_t end, int worker) {
+            BitbasePosition pos;
+            for (uint64_t n = begin; n < end; ++n) {
+                const uint64_t index = frontier[n];
+                decode(table, index, pos);
+                const Cell settled = cell(table, index);
+                forEachUnmove(pos, [&](const BitbasePosition& previous) {
+                    const uint64_t previousIndex = Bitbases::index(previous);
+                    if (cell(table, previousIndex) != UNKNOWN) return;
+                    if (settled == LOSS) {
+                        if (trySet(table, previousIndex, WIN)) found[size_t(worker)].push_back(uint32_t(previousIndex));
+                        return;
+                    }
+                    // A loss only once every move leads to a win for the opponent
+                    bool lost = true;
+                    forEachMove(previous, [&](const BitbasePosition& next, bool changesMaterial) {
+                        lost = resultAfter(table, next, changesMaterial) == WIN;
+                        return lost;
+                    });
+                    if (lost && trySet(table, previousIndex, LOSS)) found[size_t(worker)].push_back(uint32_t(previousIndex));
+                });
+            }
+        });
+    }
+
+    const std::string path = directory + "/" + name + ".bb";
+    if (!writeTable(path, name, table, stats)) return false;
+    stats.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    if (progress) progress(stats);
+    return true;
+}
+
+// Illegal and duplicate indices are never probed, so they join whatever run they are
+// in; the table is then run-length coded block by block (see Bitbases::lookup).
+bool BitbaseGenerator::writeTable(const std::string& path, const std::string& name, const Table& table,
+                                  Stats& stats) const {
+    const uint32_t blockCount = uint32_t((table.size + Bitbases::BLOCK_POSITIONS - 1) / Bitbases::BLOCK_POSITIONS);
+    std::vector<uint32_t> offsets;
+    offsets.reserve(blockCount + 1);
+    std::string data;
+
+    auto writeRun = [&](int value, uint32_t length) {
+        const uint32_t extra = length - 1;
+        data += char((value << 6) | (extra >= 32 ? 0x20 : 0) | (extra & 0x1F));
+        for (uint32_t rest = extra >> 5; rest > 0; rest >>= 7) {
+            data += char((rest & 0x7F) | (rest >= 0x80 ? 0x80 : 0));
+        }
+    };
+
+    BitbasePosition pos;
+    for (uint32_t block = 0; block < blockCount; ++block) {
+        offsets.push_back(uint32_t(data.size()));
+        const uint64_t begin = uint64_t(block) * Bitbases::BLOCK_POSITIONS;
+        const uint64_t end = std::min<uint64_t>(begin + Bitbases::BLOCK_POSITIONS, table.size);
+        int runValue = -1;
+        uint32_t runLength = 0;
+        for (uint64_t index = begin; index < end; ++index) {
+            int value = -1;
+            if (decode(table, index, pos)) {
+                const Cell result = cell(table, index);
+                value = result == WIN ? int(BitbaseResult::Win)
+                      : result == LOSS ? int(BitbaseResult::Loss) : int(BitbaseResult::Draw);
+                stats.positions++;
+                stats.wins += result == WIN;
+                stats.losses += result == LOSS;
+                stats.draws += result != WIN && result != LOSS;
+            }
+            if (value >= 0 && runValue >= 0 && value != runValue) {
+                writeRun(runValue, runLength);
+                runLength = 0;
+            }
+            if (value >= 0) runValue = value;
+            runLength++;
+        }
+        writeRun(std::max(runValue, 0), runLength);
+    }
+    offsets.push_back(uint32_t(data.size()));
+
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    if (!out) return false;
+    auto put32 = [&](uint32_t value) {
+        for (int i = 0; i < 4; ++i) out.put(char(value >> (8 * i)));
+    };
+    char header[16] = { 'C', 'Q', 'B', 'B' };
+    out.write(header, 4);
+    put32(Bitbases::FILE_VERSION);
+    std::copy(name.begin(), name.end(), header + 8);
+    out.write(header + 8, 8);
+    for (int i = 0; i < 8; ++i) out.put(char(table.size >> (8 * i)));
+    put32(Bitbases::BLOCK_POSITIONS);
+    put32(blockCount);
+    for (uint32_t offset : offsets) put32(offset);
+    out.write(data.data(), std::streamsize(data.size()));
+    out.close();
+
+    stats.fileBytes = Bitbases::HEADER_SIZE + 4 * uint64_t(offsets.size()) + data.size();
+    return bool(out);
+}
@@ -0,0 +1,68 @@
+#ifndef BITBASEGENERATOR_H
+#define BITBASEGENERATOR_H
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "engine/Bitbases.h"
+
+// Builds the win/draw/loss tables that Bitbases probes, by retrograde analysis.
+//
+// Every index of a table holds two bits: unknown, win, loss, or draw/illegal. A first
+// pass settles mates, stalemates and the positions decided by a capture or promotion
+// into a smaller table. After that only the positions settled in the previous pass are
+// visited: their predecessors, found by un-making moves, are wins when the settled
+// position is lost, and are checked for a loss (every move wins for the opponent)
+// when it is won. What is still unknown when nothing changes is a draw.
+//
+// Both kinds of pass are split over the worker threads. A result only ever goes from
+// unknown to known, so the threads set them with a compare-and-swap on the shared
+// byte and a value one thread misses is picked up in the next pass.
+class BitbaseGenerator {
+public:
+    struct Stats {
+        std::string name;
+        uint64_t positions = 0; // legal positions in the table
+        uint64_t wins = 0;      // for the side to move
+        uint64_t draws = 0;
+        uint64_t losses = 0;
+        int passes = 0;
+        uint64_t fileBytes = 0;
+        double seconds = 0;
+    };
+    using Progress = std::function<void(const Stats&)>;
+
+    explicit BitbaseGenerator(int threads);
+
+    // Generates the table and, first, every smaller one a capture or promotion leads
+    // to. Tables this generator has made before are not made again.
+    bool generate(const std::string& name, const std::string& directory, const Progress& progress = nullptr);
+
+private:
+    struct Table {
+        std::vector<int> pieces;
+        uint64_t size = 0;
+        std::unique_ptr<std::atomic<uint8_t>[]> cells;
+    };
+
+    enum Cell : uint8_t { UNKNOWN = 0, WIN = 1, LOSS = 2, DRAW = 3 };
+
+    int threads;
+    std::unordered_map<std::string, Table> tables;
+
+    bool build(const std::string& name, const std::string& directory, const Progress& progress);
+    void parallelFor(uint64_t count, uint64_t grain, const std::function<void(uint64_t, uint64_t, int)>& body) const;
+    bool decode(const Table& table, uint64_t index, BitbasePosition& pos) const;
+    // Result for the side to move in a position reached by a move, in this table or a smaller one
+    Cell resultAfter(const Table& table, const BitbasePosition& pos, bool changesMaterial) const;
+    bool writeTable(const std::string& path, const std::string& name, const Table& table, Stats& stats) const;
+
+    static Cell cell(const Table& table, uint64_t index);
+    static bool trySet(const Table& table, uint64_t index, Cell value);
+};
+
+#endif // BITBASEGENERATOR_H
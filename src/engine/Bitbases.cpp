@@ -0,0 +1,253 @@
+#include "engine/Bitbases.h"
+#include "engine/Board.h"
+
+#include <QDebug>
+#include <QtEndian>
+#include <algorithm>
+#include <cstring>
+
+namespace {
+
+const char PieceLetters[] = "PNBRQK";
+
+std::shared_ptr<Bitbases> currentSet;
+
+// Stronger means more pieces, then better pieces; types are sorted strongest first
+bool isStronger(const std::vector<int>& a, const std::vector<int>& b) {
+    if (a.size() != b.size()) return a.size() > b.size();
+    return std::lexicographical_compare(b.begin(), b.end(), a.begin(), a.end());
+}
+
+} // namespace
+
+Bitbases::Bitbases(const QString& directory) {
+    if (directory.isEmpty() || directory == "<empty>") return;
+    for (const std::string& name : allTables()) {
+        const QString path = directory + "/" + QString::fromStdString(name) + ".bb";
+        if (!QFile::exists(path)) continue;
+        Table table;
+        if (mapTable(path, name, table)) tables.emplace(name, std::move(table));
+    }
+}
+
+std::shared_ptr<Bitbases> Bitbases::current() {
+    return std::atomic_load(&currentSet);
+}
+
+void Bitbases::setCurrent(std::shared_ptr<Bitbases> bitbases) {
+    std::atomic_store(&currentSet, std::move(bitbases));
+}
+
+std::vector<std::string> Bitbases::allTables() {
+    std::vector<std::string> names;
+    for (int p1 = QUEEN; p1 >= PAWN; --p1) {
+        names.push_back(std::string("K") + PieceLetters[p1] + "K");
+    }
+    for (int p1 = QUEEN; p1 >= PAWN; --p1) {
+        for (int p2 = p1; p2 >= PAWN; --p2) {
+            names.push_back(std::string("K") + PieceLetters[p1] + PieceLetters[p2] + "K");
+            names.push_back(std::string("K") + PieceLetters[p1] + "K" + PieceLetters[p2]);
+        }
+    }
+    return names;
+}
+
+std::string Bitbases::canonicalName(const std::string& name) {
+    if (name.size() < 3 || name[0] != 'K') return std::string();
+    BitbasePosition pos;
+    pos.pieces[0] = makePiece(WHITE, KING);
+    pos.count = 1;
+    Color color = WHITE;
+    for (size_t i = 1; i < name.size(); ++i) {
+        const char *found = std::strchr(PieceLetters, name[i]);
+        if (!found || name[i] == '\0') return std::string();
+        const PieceType type = PieceType(found - PieceLetters);
+        if (type == KING) {
+            if (color == BLACK) return std::string();
+            color = BLACK;
+        }
+        if (pos.count == MAX_PIECES) return std::string();
+        pos.pieces[pos.count] = makePiece(color, type);
+        pos.squares[pos.count] = pos.count;
+        pos.count++;
+    }
+    if (color != BLACK || pos.count < 3) return std::string();
+    // normalize() expects the kings first
+    std::swap(pos.pieces[1], *std::find(pos.pieces, pos.pieces + pos.count, makePiece(BLACK, KING)));
+    return normalize(pos);
+}
+
+std::string Bitbases::normalize(BitbasePosition& pos) {
+    struct Placed {
+        int type;
+        int square;
+    };
+    std::vector<Placed> own[2];
+    for (int i = 2; i < pos.count; ++i) {
+        own[pieceColor(pos.pieces[i])].push_back({ pieceType(pos.pieces[i]), pos.squares[i] });
+    }
+    for (std::vector<Placed>& list : own) {
+        std::stable_sort(list.begin(), list.end(), [](const Placed& a, const Placed& b) { return a.type > b.type; });
+    }
+
+    std::vector<int> types[2];
+    for (Color c : { WHITE, BLACK }) {
+        for (const Placed& placed : own[c]) types[c].push_back(placed.type);
+    }
+    int kings[2] = { pos.squares[0], pos.squares[1] };
+    if (isStronger(types[BLACK], types[WHITE])) {
+        // Swap the colours: mirror the ranks so the pawns keep their direction
+        std::swap(own[WHITE], own[BLACK]);
+        std::swap(types[WHITE], types[BLACK]);
+        std::swap(kings[WHITE], kings[BLACK]);
+        kings[WHITE] ^= 56;
+        kings[BLACK] ^= 56;
+        for (std::vector<Placed>& list : own) {
+            for (Placed& placed : list) placed.square ^= 56;
+        }
+        pos.side = !pos.side;
+    }
+
+    std::string name;
+    int n = 0;
+    for (Color c : { WHITE, BLACK }) {
+        pos.pieces[n] = makePiece(c, KING);
+        pos.squares[n++] = kings[c];
+    }
+    for (Color c : { WHITE, BLACK }) {
+        name += 'K';
+        for (const Placed& placed : own[c]) {
+            pos.pieces[n] = makePiece(c, PieceType(placed.type));
+            pos.squares[n++] = placed.square;
+            name += PieceLetters[placed.type];
+        }
+    }
+    return name;
+}
+
+uint64_t Bitbases::index(const BitbasePosition& pos) {
+    bool hasPawns = false;
+    for (int i = 2; i < pos.count; ++i) hasPawns |= pieceType(pos.pieces[i]) == PAWN;
+
+    // Bring the white king onto files a-d, and without pawns onto ranks 1-4 as well
+    int flip = colOf(pos.squares[0]) > 3 ? 7 : 0;
+    if (!hasPawns && rowOf(pos.squares[0]) > 3) flip ^= 56;
+    int sq[4] = {};
+    for (int i = 0; i < pos.count; ++i) sq[i] = pos.squares[i] ^ flip;
+    // Identical pieces are indexed in square order
+    if (pos.count == 4 && pos.pieces[2] == pos.pieces[3] && sq[2] > sq[3]) std::swap(sq[2], sq[3]);
+
+    uint64_t idx = uint64_t(pos.side) * (hasPawns ? 32 : 16) + rowOf(sq[0]) * 4 + colOf(sq[0]);
+    for (int i = 1; i < pos.count; ++i) idx = idx * 64 + uint64_t(sq[i]);
+    return idx;
+}
+
+bool Bitbases::tablePieces(const std::string& name, std::vector<int>& pieces) {
+    if (name.empty() || canonicalName(name) != name) return false;
+    pieces.clear();
+    pieces.push_back(makePiece(WHITE, KING));
+    pieces.push_back(makePiece(BLACK, KING));
+    Color color = WHITE;
+    for (size_t i = 1; i < name.size(); ++i) {
+        const PieceType type = PieceType(std::strchr(PieceLetters, name[i]) - PieceLetters);
+        if (type == KING) color = BLACK;
+        else pieces.push_back(makePiece(color, type));
+    }
+    return true;
+}
+
+uint64_t Bitbases::tableSize(const std::string& name) {
+    std::vector<int> pieces;
+    if (!tablePieces(name, pieces)) return 0;
+    bool hasPawns = false;
+    for (int piece : pieces) hasPawns |= pieceType(piece) == PAWN;
+    uint64_t size = 2 * (hasPawns ? 32 : 16);
+    for (size_t i = 1; i < pieces.size(); ++i) size *= 64;
+    return size;
+}
+
+bool Bitbases::mapTable(const QString& path, const std::string& name, Table& table) {
+    table.file = std::make_unique<QFile>(path);
+    if (!table.file->open(QIODevice::ReadOnly)) return false;
+    const qint64 size = table.file->size();
+    const uchar *data = size >= HEADER_SIZE ? table.file->map(0, size) : nullptr;
+    table.file->close(); // the mapping outlives the descriptor
+
+    bool ok = data && std::memcmp(data, "CQBB", 4) == 0
+           && qFromLittleEndian<quint32>(data + 4) == FILE_VERSION
+           && std::strncmp(reinterpret_cast<const char*>(data + 8), name.c_str(), 8) == 0
+           && qFromLittleEndian<quint32>(data + 24) == BLOCK_POSITIONS;
+    if (ok) {
+        table.positions = qFromLittleEndian<quint64>(data + 16);
+        table.blockCount = qFromLittleEndian<quint32>(data + 28);
+        const qint64 dataStart = HEADER_SIZE + 4 * (qint64(table.blockCount) + 1);
+        ok = table.positions == tableSize(name)
+          && table.blockCount == (table.positions + BLOCK_POSITIONS - 1) / BLOCK_POSITIONS
+          && dataStart <= size
+          && qFromLittleEndian<quint32>(data + dataStart - 4) <= quint64(size - dataStart);
+    }
+    if (!ok) {
+        qWarning() << "Bitbases: corrupt table" << path;
+        if (data) table.file->unmap(const_cast<uchar*>(data));
+        return false;
+    }
+    table.data = data;
+    return true;
+}
+
+// Walks the runs of the block holding the index. A run is one byte with the result in
+// the top two bits and the low five bits of (length - 1); bit 5 says the rest of the
+// length follows as a little-endian base-128 number.
+BitbaseResult Bitbases::lookup(const Table& table, uint64_t index) {
+    const uchar *offsets = table.data + HEADER_SIZE;
+    const uchar *blocks = offsets + 4 * (size_t(table.blockCount) + 1);
+    const uint32_t block = uint32_t(index / BLOCK_POSITIONS);
+    const uchar *p = blocks + qFromLittleEndian<quint32>(offsets + 4 * block);
+    const uchar *end = blocks + qFromLittleEndian<quint32>(offsets + 4 * (block + 1));
+
+    uint32_t remaining = uint32_t(index % BLOCK_POSITIONS);
+    while (p < end) {
+        const uchar head = *p++;
+        uint32_t length = head & 0x1F;
+        if (head & 0x20) {
+            for (int shift = 5; p < end; shift += 7) {
+                const uchar next = *p++;
+                length |= uint32_t(next & 0x7F) << shift;
+                if (!(next & 0x80)) break;
+            }
+        }
+        if (remaining <= length) return BitbaseResult(std::min(head >> 6, 2));
+        remaining -= length + 1;
+    }
+    return BitbaseResult::Draw;
+}
+
+bool Bitbases::probe(const Board& board, BitbaseResult& result) const {
+    Bitboard occupied = board.occupied();
+    if (tables.empty() || popCount(occupied) > MAX_PIECES
+        || board.castlingRights() != 0 || board.enPassantSquare() != NO_SQUARE) {
+        return false;
+    }
+
+    BitbasePosition pos;
+    pos.side = board.sideToMove();
+    for (Color c : { WHITE, BLACK }) {
+        pos.pieces[pos.count] = makePiece(c, KING);
+        pos.squares[pos.count++] = board.kingSquare(c);
+    }
+    occupied &= ~board.pieces(KING);
+    while (occupied) {
+        const int sq = popLsb(occupied);
+        pos.pieces[pos.count] = board.pieceAt(sq);
+        pos.squares[pos.count++] = sq;
+    }
+    if (pos.count == 2) {
+        result = BitbaseResult::Draw;
+        return true;
+    }
+
+    auto found = tables.find(normalize(pos));
+    if (found == tables.end()) return false;
+    result = lookup(found->second, index(pos));
+    return true;
+}
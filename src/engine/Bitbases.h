@@ -0,0 +1,83 @@
+#ifndef BITBASES_H
+#define BITBASES_H
+
+#include <QFile>
+#include <QString>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "engine/Bitboards.h"
+
+class Board;
+
+// Win/draw/loss for the side to move, as stored in the tables (two bits each)
+enum class BitbaseResult : uint8_t { Draw = 0, Win = 1, Loss = 2 };
+
+// A position of at most four pieces, kings first, in the form the tables index it
+struct BitbasePosition {
+    Color side = WHITE;
+    int count = 0;
+    int pieces[4] = {};  // piece codes
+    int squares[4] = {};
+};
+
+// Our own win/draw/loss bitbases for the endings with three and four pieces, made
+// by BitbaseGenerator.
+//
+// A table covers one material with white as the stronger side; positions where
+// black is stronger are probed with the colours swapped. The index is perfect over
+// its domain: the side to move, then the squares of the kings and the other pieces,
+// with the white king mirrored into files a-d (and ranks 1-4 without pawns). Castling
+// and en passant are not covered.
+//
+// A file is a header, an offset per block of BLOCK_POSITIONS results and the blocks,
+// each run-length coded on its own so a probe decodes at most one block. The files
+// are memory-mapped when the set is loaded.
+class Bitbases {
+public:
+    static constexpr int MAX_PIECES = 4;
+    static constexpr uint32_t BLOCK_POSITIONS = 4096;
+    static constexpr uint32_t FILE_VERSION = 1;
+    static constexpr int HEADER_SIZE = 32;
+
+    explicit Bitbases(const QString& directory);
+    Bitbases(const Bitbases&) = delete;
+    Bitbases& operator=(const Bitbases&) = delete;
+
+    size_t tableCount() const { return tables.size(); }
+    // False when the position is not covered or its table is missing
+    bool probe(const Board& board, BitbaseResult& result) const;
+
+    // Every table with three or four pieces, named like "KQKR"
+    static std::vector<std::string> allTables();
+    // Canonical name of a material such as "KRKQ" (which becomes "KQKR"); empty if invalid
+    static std::string canonicalName(const std::string& name);
+    // Swaps colours when black is the stronger side and sorts the pieces into table
+    // order. Returns the table name.
+    static std::string normalize(BitbasePosition& pos);
+    // Index of a normalized position in its table
+    static uint64_t index(const BitbasePosition& pos);
+    static uint64_t tableSize(const std::string& name);
+    // The pieces of a table in index order, kings first; false for a bad name
+    static bool tablePieces(const std::string& name, std::vector<int>& pieces);
+
+    static std::shared_ptr<Bitbases> current();
+    static void setCurrent(std::shared_ptr<Bitbases> bitbases);
+
+private:
+    struct Table {
+        std::unique_ptr<QFile> file;
+        const uchar *data = nullptr;
+        uint64_t positions = 0;
+        uint32_t blockCount = 0;
+    };
+
+    std::unordered_map<std::string, Table> tables;
+
+    bool mapTable(const QString& path, const std::string& name, Table& table);
+    static BitbaseResult lookup(const Table& table, uint64_t index);
+};
+
+#endif // BITBASES_H
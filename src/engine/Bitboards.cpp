@@ -0,0 +1,153 @@
+#include "engine/Bitboards.h"
+
+// All tables are built at compile time, so they are usable from any static initializer.
+namespace {
+
+using SquareTable = std::array<Bitboard, 64>;
+using PairTable = std::array<std::array<Bitboard, 64>, 64>;
+
+constexpr int DirectionSteps[8][2] = {
+    { 1, 0 }, { -1, 0 }, { 0, 1 }, { 0, -1 }, { 1, 1 }, { 1, -1 }, { -1, 1 }, { -1, -1 }
+};
+
+constexpr bool onBoard(int row, int col) {
+    return row >= 0 && row < 8 && col >= 0 && col < 8;
+}
+
+constexpr SquareTable makeLeaperTable(const int (&offsets)[8][2]) {
+    SquareTable table{};
+    for (int sq = 0; sq < 64; ++sq) {
+        for (const auto& offset : offsets) {
+            int row = rowOf(sq) + offset[0];
+            int col = colOf(sq) + offset[1];
+            if (onBoard(row, col)) table[sq] |= squareBB(squareOf(row, col));
+        }
+    }
+    return table;
+}
+
+constexpr int KnightOffsets[8][2] = {
+    { -2, -1 }, { -2, 1 }, { -1, -2 }, { -1, 2 }, { 1, -2 }, { 1, 2 }, { 2, -1 }, { 2, 1 }
+};
+
+constexpr std::array<SquareTable, 2> makePawnAttacks() {
+    std::array<SquareTable, 2> table{};
+    for (int sq = 0; sq < 64; ++sq) {
+        for (int side = 0; side < 2; ++side) {
+            int row = rowOf(sq) + (side == WHITE ? 1 : -1);
+            for (int dc : { -1, 1 }) {
+                int col = colOf(sq) + dc;
+                if (onBoard(row, col)) table[side][sq] |= squareBB(squareOf(row, col));
+            }
+        }
+    }
+    return table;
+}
+
+constexpr std::array<SquareTable, 8> makeRays() {
+    std::array<SquareTable, 8> rays{};
+    for (int dir = 0; dir < 8; ++dir) {
+        for (int sq = 0; sq < 64; ++sq) {
+            int row = rowOf(sq) + DirectionSteps[dir][0];
+            int col = colOf(sq) + DirectionSteps[dir][1];
+            while (onBoard(row, col)) {
+                rays[dir][sq] |= squareBB(squareOf(row, col));
+                row += DirectionSteps[dir][0];
+                col += DirectionSteps[dir][1];
+            }
+        }
+    }
+    return rays;
+}
+
+constexpr std::array<SquareTable, 8> RayTable = makeRays();
+
+constexpr PairTable makeBetween() {
+    PairTable table{};
+    for (int a = 0; a < 64; ++a) {
+        for (int dir = 0; dir < 8; ++dir) {
+            Bitboard path = 0;
+            int row = rowOf(a) + DirectionSteps[dir][0];
+            int col = colOf(a) + DirectionSteps[dir][1];
+            while (onBoard(row, col)) {
+                int b = squareOf(row, col);
+                table[a][b] = path;
+                path |= squareBB(b);
+                row += DirectionSteps[dir][0];
+                col += DirectionSteps[dir][1];
+            }
+        }
+    }
+    return table;
+}
+
+constexpr int OppositeDirections[4][2] = { { 0, 1 }, { 2, 3 }, { 4, 7 }, { 5, 6 } };
+
+constexpr PairTable makeLine() {
+    PairTable table{};
+    for (int a = 0; a < 64; ++a) {
+        for (const auto& pair : OppositeDirections) {
+            Bitboard targets = RayTable[pair[0]][a] | RayTable[pair[1]][a];
+            for (int b = 0; b < 64; ++b) {
+                if (targets & squareBB(b)) table[a][b] = targets | squareBB(a);
+            }
+        }
+    }
+    return table;
+}
+
+} // namespace
+
+const std::array<Bitboards::SquareTable, 2> Bitboards::PawnAttacks = makePawnAttacks();
+const Bitboards::SquareTable Bitboards::KnightAttacks = makeLeaperTable(KnightOffsets);
+const Bitboards::SquareTable Bitboards::KingAttacks = makeLeaperTable(DirectionSteps);
+const std::array<Bitboards::SquareTable, 8> Bitboards::Rays = RayTable;
+const Bitboards::PairTable Bitboards::Between = makeBetween();
+const Bitboards::PairTable Bitboards::Line = makeLine();
+
+Bitboard Bitboards::bishopAttacks(int sq, Bitboard occupied) {
+    Bitboard result = 0;
+    // Positive directions: first blocker is the lowest set bit
+    for (Direction dir : { NORTH_EAST, NORTH_WEST }) {
+        Bitboard attacks = Rays[dir][sq];
+        Bitboard blockers = attacks & occupied;
+        if (blockers) attacks ^= Rays[dir][lsb(blockers)];
+        result |= attacks;
+    }
+    // Negative directions: first blocker is the highest set bit
+    for (Direction dir : { SOUTH_EAST, SOUTH_WEST }) {
+        Bitboard attacks = Rays[dir][sq];
+        Bitboard blockers = attacks & occupied;
+        if (blockers) attacks ^= Rays[dir][msb(blockers)];
+        result |= attacks;
+    }
+    return result;
+}
+
+Bitboard Bitboards::rookAttacks(int sq, Bitboard occupied) {
+    Bitboard result = 0;
+    for (Direction dir : { NORTH, EAST }) {
+        Bitboard attacks = Rays[dir][sq];
+        Bitboard blockers = attacks & occupied;
+        if (blockers) attacks ^= Rays[dir][lsb(blockers)];
+        result |= attacks;
+    }
+    for (Direction dir : { SOUTH, WEST }) {
+        Bitboard attacks = Rays[dir][sq];
+        Bitboard blockers = attacks & occupied;
+        if (blockers) attacks ^= Rays[dir][msb(blockers)];
+        result |= attacks;
+    }
+    return result;
+}
+
+Bitboard Bitboards::attacks(PieceType type, int sq, Bitboard occupied) {
+    switch (type) {
+        case KNIGHT: return knightAttacks(sq);
+        case BISHOP: return bishopAttacks(sq, occupied);
+        case ROOK:   return rookAttacks(sq, occupied);
+        case QUEEN:  return queenAttacks(sq, occupied);
+        case KING:   return kingAttacks(sq);
+        default:     return 0;
+    }
+}
@@ -0,0 +1,74 @@
+#ifndef BITBOARDS_H
+#define BITBOARDS_H
+
+#include <array>
+#include <cstdint>
+
+// Squares are numbered rank * 8 + file, so a1 = 0 and h8 = 63.
+// This matches Position(row, col) with row = rank and col = file.
+using Bitboard = uint64_t;
+
+enum Color : uint8_t { WHITE = 0, BLACK = 1 };
+enum PieceType : uint8_t { PAWN = 0, KNIGHT, BISHOP, ROOK, QUEEN, KING, NO_PIECE_TYPE };
+
+constexpr int NO_SQUARE = 64;
+
+inline constexpr Color operator!(Color c) { return c == WHITE ? BLACK : WHITE; }
+
+inline constexpr int squareOf(int row, int col) { return row * 8 + col; }
+inline constexpr int rowOf(int sq) { return sq >> 3; }
+inline constexpr int colOf(int sq) { return sq & 7; }
+inline constexpr Bitboard squareBB(int sq) { return Bitboard(1) << sq; }
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+inline int lsb(Bitboard b) { unsigned long i; _BitScanForward64(&i, b); return int(i); }
+inline int msb(Bitboard b) { unsigned long i; _BitScanReverse64(&i, b); return int(i); }
+inline int popCount(Bitboard b) { return int(__popcnt64(b)); }
+#else
+inline int lsb(Bitboard b) { return __builtin_ctzll(b); }
+inline int msb(Bitboard b) { return 63 - __builtin_clzll(b); }
+inline int popCount(Bitboard b) { return __builtin_popcountll(b); }
+#endif
+inline int popLsb(Bitboard& b) { int sq = lsb(b); b &= b - 1; return sq; }
+
+class Bitboards {
+public:
+    enum Direction { NORTH, SOUTH, EAST, WEST, NORTH_EAST, NORTH_WEST, SOUTH_EAST, SOUTH_WEST };
+
+    static constexpr Bitboard FILE_A = 0x0101010101010101ULL;
+    static constexpr Bitboard FILE_H = FILE_A << 7;
+    static constexpr Bitboard RANK_1 = 0xFFULL;
+    static constexpr Bitboard RANK_2 = RANK_1 << 8;
+    static constexpr Bitboard RANK_7 = RANK_1 << 48;
+    static constexpr Bitboard RANK_8 = RANK_1 << 56;
+
+    static Bitboard pawnAttacks(Color c, int sq) { return PawnAttacks[c][sq]; }
+    static Bitboard knightAttacks(int sq) { return KnightAttacks[sq]; }
+    static Bitboard kingAttacks(int sq) { return KingAttacks[sq]; }
+    static Bitboard bishopAttacks(int sq, Bitboard occupied);
+    static Bitboard rookAttacks(int sq, Bitboard occupied);
+    static Bitboard queenAttacks(int sq, Bitboard occupied) {
+        return bishopAttacks(sq, occupied) | rookAttacks(sq, occupied);
+    }
+    static Bitboard attacks(PieceType type, int sq, Bitboard occupied);
+
+    // Squares strictly between two aligned squares (empty if not on a line)
+    static Bitboard between(int a, int b) { return Between[a][b]; }
+    // Full line through two aligned squares (empty if not on a line)
+    static Bitboard line(int a, int b) { return Line[a][b]; }
+    static Bitboard ray(Direction dir, int sq) { return Rays[dir][sq]; }
+
+private:
+    using SquareTable = std::array<Bitboard, 64>;
+    using PairTable = std::array<std::array<Bitboard, 64>, 64>;
+
+    static const std::array<SquareTable, 2> PawnAttacks;
+    static const SquareTable KnightAttacks;
+    static const SquareTable KingAttacks;
+    static const std::array<SquareTable, 8> Rays;
+    static const PairTable Between;
+    static const PairTable Line;
+};
+
+#endif // BITBOARDS_H
@@ -0,0 +1,508 @@
+#include "engine/Board.h"
+#include "engine/Zobrist.h"
+#include "core/FenUtils.h"
+#include "model/Move.h"
+
+#include <cctype>
+
+namespace {
+
+// Rights that survive a move touching each square
+constexpr std::array<uint8_t, 64> makeCastlingMasks() {
+    std::array<uint8_t, 64> masks{};
+    for (auto& m : masks) m = 0xF;
+    masks[0] &= ~WHITE_QUEENSIDE;
+    masks[7] &= ~WHITE_KINGSIDE;
+    masks[4] &= ~(WHITE_KINGSIDE | WHITE_QUEENSIDE);
+    masks[56] &= ~BLACK_QUEENSIDE;
+    masks[63] &= ~BLACK_KINGSIDE;
+    masks[60] &= ~(BLACK_KINGSIDE | BLACK_QUEENSIDE);
+    return masks;
+}
+
+constexpr std::array<uint8_t, 64> CastlingMasks = makeCastlingMasks();
+
+const char PieceChars[] = "PNBRQKpnbrqk";
+
+} // namespace
+
+Board::Board() {
+    setFromFen(START_FEN);
+}
+
+void Board::clear() {
+    for (auto& byColor : pieceBB)
+        for (Bitboard& bb : byColor) bb = 0;
+    colorBB[WHITE] = colorBB[BLACK] = 0;
+    for (uint8_t& sq : squares) sq = NO_PIECE;
+    side = WHITE;
+    castling = 0;
+    epSquare = NO_SQUARE;
+    halfmoves = 0;
+    fullmoves = 1;
+    hashKey = 0;
+    checkersBB = 0;
+    pinnedBB = 0;
+    history.clear();
+    history.reserve(512);
+}
+
+bool Board::setFromFen(std::string_view fen) {
+    FenPosition fields;
+    if (FenUtils::parse(fen, fields) != FenError::None) return false;
+    setFromPosition(fields);
+    return true;
+}
+
+void Board::setFromPosition(const FenPosition& fields) {
+    clear();
+
+    for (int sq = 0; sq < 64; ++sq) {
+        if (fields.squares[sq]) {
+            putPiece(int(std::char_traits<char>::find(PieceChars, 12, fields.squares[sq]) - PieceChars), sq);
+        }
+    }
+    side = fields.whiteToMove ? WHITE : BLACK;
+
+    // Drop rights whose king or rook is not on its home square
+    const int rightSquares[4][2] = { { 4, 7 }, { 4, 0 }, { 60, 63 }, { 60, 56 } };
+    for (int i = 0; i < 4; ++i) {
+        Color c = i < 2 ? WHITE : BLACK;
+        if (fields.castlingRights[i] && squares[rightSquares[i][0]] == makePiece(c, KING)
+            && squares[rightSquares[i][1]] == makePiece(c, ROOK)) {
+            castling |= 1 << i;
+        }
+    }
+
+    // Only keep the target when a pawn can actually capture, so equal positions hash equally
+    if (fields.enPassantSquare >= 0
+        && (Bitboards::pawnAttacks(!side, fields.enPassantSquare) & pieceBB[side][PAWN])) {
+        epSquare = uint8_t(fields.enPassantSquare);
+    }
+
+    halfmoves = fields.halfmoveClock;
+    fullmoves = fields.fullmoveNumber;
+
+    hashKey = computeKey();
+    updateCheckInfo();
+}
+
+size_t Board::writeFen(char (&out)[FenUtils::FEN_BUFFER_SIZE]) const {
+    FenPosition fields;
+    for (int sq = 0; sq < 64; ++sq) {
+        fields.squares[sq] = squares[sq] == NO_PIECE ? 0 : PieceChars[squares[sq]];
+    }
+    fields.whiteToMove = side == WHITE;
+    for (int i = 0; i < 4; ++i) fields.castlingRights[i] = castling & (1 << i);
+    fields.enPassantSquare = epSquare == NO_SQUARE ? -1 : epSquare;
+    fields.halfmoveClock = halfmoves;
+    fields.fullmoveNumber = fullmoves;
+    return FenUtils::write(fields, out);
+}
+
+std::string Board::toFen() const {
+    char fen[FenUtils::FEN_BUFFER_SIZE];
+    const size_t length = writeFen(fen);
+    return std::string(fen, length);
+}
+
+uint64_t Board::computeKey() const {
+    uint64_t key = 0;
+    for (int sq = 0; sq < 64; ++sq) {
+        if (squares[sq] != NO_PIECE) key ^= Zobrist::piece(squares[sq], sq);
+    }
+    key ^= Zobrist::castling(castling);
+    if (epSquare != NO_SQUARE) key ^= Zobrist::enPassant(colOf(epSquare));
+    if (side == BLACK) key ^= Zobrist::side();
+    return key;
+}
+
+void Board::putPiece(int piece, int sq) {
+    Bitboard bb = squareBB(sq);
+    pieceBB[pieceColor(piece)][pieceType(piece)] |= bb;
+    colorBB[pieceColor(piece)] |= bb;
+    squares[sq] = uint8_t(piece);
+    hashKey ^= Zobrist::piece(piece, sq);
+}
+
+void Board::removePiece(int sq) {
+    int piece = squares[sq];
+    Bitboard bb = squareBB(sq);
+    pieceBB[pieceColor(piece)][pieceType(piece)] ^= bb;
+    colorBB[pieceColor(piece)] ^= bb;
+    squares[sq] = NO_PIECE;
+    hashKey ^= Zobrist::piece(piece, sq);
+}
+
+void Board::movePiece(int from, int to) {
+    int piece = squares[from];
+    Bitboard fromTo = squareBB(from) | squareBB(to);
+    pieceBB[pieceColor(piece)][pieceType(piece)] ^= fromTo;
+    colorBB[pieceColor(piece)] ^= fromTo;
+    squares[from] = NO_PIECE;
+    squares[to] = uint8_t(piece);
+    hashKey ^= Zobrist::piece(piece, from) ^ Zobrist::piece(piece, to);
+}
+
+Bitboard Board::attackersTo(int sq, Bitboard occ) const {
+    return (Bitboards::pawnAttacks(BLACK, sq) & pieceBB[WHITE][PAWN])
+         | (Bitboards::pawnAttacks(WHITE, sq) & pieceBB[BLACK][PAWN])
+         | (Bitboards::knightAttacks(sq) & pieces(KNIGHT))
+         | (Bitboards::kingAttacks(sq) & pieces(KING))
+         | (Bitboards::bishopAttacks(sq, occ) & (pieces(BISHOP) | pieces(QUEEN)))
+         | (Bitboards::rookAttacks(sq, occ) & (pieces(ROOK) | pieces(QUEEN)));
+}
+
+bool Board::isSquareAttacked(int sq, Color by) const {
+    Bitboard occ = occupied();
+    return (Bitboards::pawnAttacks(!by, sq) & pieceBB[by][PAWN])
+        || (Bitboards::knightAttacks(sq) & pieceBB[by][KNIGHT])
+        || (Bitboards::kingAttacks(sq) & pieceBB[by][KING])
+        || (Bitboards::bishopAttacks(sq, occ) & (pieceBB[by][BISHOP] | pieceBB[by][QUEEN]))
+        || (Bitboards::rookAttacks(sq, occ) & (pieceBB[by][ROOK] | pieceBB[by][QUEEN]));
+}
+
+void Board::updateCheckInfo() {
+    Color them = !side;
+    int king = kingSquare(side);
+    checkersBB = attackersTo(king, occupied()) & colorBB[them];
+
+    // A piece of ours is pinned if it is the only piece between our king and an enemy slider
+    pinnedBB = 0;
+    Bitboard snipers = (Bitboards::rookAttacks(king, 0) & (pieceBB[them][ROOK] | pieceBB[them][QUEEN]))
+                     | (Bitboards::bishopAttacks(king, 0) & (pieceBB[them][BISHOP] | pieceBB[them][QUEEN]));
+    Bitboard occ = occupied();
+    while (snipers) {
+        int sniper = popLsb(snipers);
+        Bitboard blockers = Bitboards::between(king, sniper) & occ;
+        if (blockers && !(blockers & (blockers - 1))) pinnedBB |= blockers & colorBB[side];
+    }
+}
+
+void Board::pushUndo(BoardMove move) {
+    history.push_back({ move, uint8_t(NO_PIECE), castling, epSquare, uint16_t(halfmoves), hashKey, checkersBB, pinnedBB });
+}
+
+void Board::makeMove(BoardMove move) {
+    pushUndo(move);
+    UndoInfo& undo = history.back();
+
+    const Color us = side;
+    const int from = move.from();
+    const int to = move.to();
+    const int piece = squares[from];
+
+    hashKey ^= Zobrist::side();
+    if (epSquare != NO_SQUARE) {
+        hashKey ^= Zobrist::enPassant(colOf(epSquare));
+        epSquare = NO_SQUARE;
+    }
+    halfmoves++;
+
+    if (move.isEnPassant()) {
+        int capturedSq = us == WHITE ? to - 8 : to + 8;
+        undo.captured = squares[capturedSq];
+        removePiece(capturedSq);
+        halfmoves = 0;
+    } else if (move.isCapture()) {
+        undo.captured = squares[to];
+        removePiece(to);
+        halfmoves = 0;
+    }
+
+    movePiece(from, to);
+
+    if (pieceType(piece) == PAWN) {
+        halfmoves = 0;
+        if (move.isPromotion()) {
+            removePiece(to);
+            putPiece(makePiece(us, move.promotionType()), to);
+        } else if (move.flag() == BoardMove::DOUBLE_PUSH) {
+            int ep = us == WHITE ? from + 8 : from - 8;
+            if (Bitboards::pawnAttacks(us, ep) & pieceBB[!us][PAWN]) {
+                epSquare = uint8_t(ep);
+                hashKey ^= Zobrist::enPassant(colOf(ep));
+            }
+        }
+    } else if (move.isCastle()) {
+        if (move.flag() == BoardMove::KING_CASTLE) movePiece(from + 3, from + 1);
+        else movePiece(from - 4, from - 1);
+    }
+
+    uint8_t newRights = castling & CastlingMasks[from] & CastlingMasks[to];
+    if (newRights != castling) {
+        hashKey ^= Zobrist::castling(castling) ^ Zobrist::castling(newRights);
+        castling = newRights;
+    }
+
+    if (us == BLACK) fullmoves++;
+    side = !us;
+    updateCheckInfo();
+}
+
+void Board::unmakeMove() {
+    const UndoInfo undo = history.back();
+    history.pop_back();
+
+    side = !side;
+    const Color us = side;
+    const BoardMove move = undo.move;
+    const int from = move.from();
+    const int to = move.to();
+
+    if (move.isPromotion()) {
+        removePiece(to);
+        putPiece(makePiece(us, PAWN), to);
+    }
+    movePiece(to, from);
+
+    if (move.isEnPassant()) {
+        putPiece(undo.captured, us == WHITE ? to - 8 : to + 8);
+    } else if (undo.captured != NO_PIECE) {
+        putPiece(undo.captured, to);
+    }
+
+    if (move.isCastle()) {
+        if (move.flag() == BoardMove::KING_CASTLE) movePiece(from + 1, from + 3);
+        else movePiece(from - 1, from - 4);
+    }
+
+    if (us == BLACK) fullmoves--;
+    castling = undo.castling;
+    epSquare = undo.epSquare;
+    halfmoves = undo.halfmoves;
+    hashKey = undo.key;
+    checkersBB = undo.checkers;
+    pinnedBB = undo.pinned;
+}
+
+void Board::makeNullMove() {
+    pushUndo(BoardMove::none());
+    hashKey ^= Zobrist::side();
+    if (epSquare != NO_SQUARE) {
+        hashKey ^= Zobrist::enPassant(colOf(epSquare));
+        epSquare = NO_SQUARE;
+    }
+    halfmoves++;
+    side = !side;
+    updateCheckInfo();
+}
+
+void Board::unmakeNullMove() {
+    const UndoInfo& undo = history.back();
+    side = !side;
+    epSquare = undo.epSquare;
+    halfmoves = undo.halfmoves;
+    hashKey = undo.key;
+    checkersBB = undo.checkers;
+    pinnedBB = undo.pinned;
+    history.pop_back();
+}
+
+void Board::generatePawnMoves(MoveList& list, bool capturesOnly) const {
+    const Color us = side;
+    const Color them = !us;
+    const int up = us == WHITE ? 8 : -8;
+    const Bitboard promotionRank = us == WHITE ? Bitboards::RANK_8 : Bitboards::RANK_1;
+    const Bitboard doubleRank = us == WHITE ? (Bitboards::RANK_1 << 24) : (Bitboards::RANK_1 << 32);
+    const Bitboard empty = ~occupied();
+    const Bitboard enemies = colorBB[them];
+
+    Bitboard pawns = pieceBB[us][PAWN];
+    while (pawns) {
+        int from = popLsb(pawns);
+        int forward = from + up;
+
+        Bitboard captures = Bitboards::pawnAttacks(us, from) & enemies;
+        while (captures) {
+            int to = popLsb(captures);
+            if (squareBB(to) & promotionRank) {
+                for (int p = QUEEN; p >= KNIGHT; --p)
+                    list.add(BoardMove(from, to, BoardMove::PROMOTION_CAPTURE + p - KNIGHT));
+            } else {
+                list.add(BoardMove(from, to, BoardMove::CAPTURE));
+            }
+        }
+        if (epSquare != NO_SQUARE && (Bitboards::pawnAttacks(us, from) & squareBB(epSquare))) {
+            list.add(BoardMove(from, epSquare, BoardMove::EN_PASSANT));
+        }
+
+        if (!(squareBB(forward) & empty)) continue;
+        if (squareBB(forward) & promotionRank) {
+            // Queen promotions count as tactical moves; underpromotions only in full generation
+            list.add(BoardMove(from, forward, BoardMove::PROMOTION + QUEEN - KNIGHT));
+            if (!capturesOnly) {
+                for (int p = ROOK; p >= KNIGHT; --p)
+                    list.add(BoardMove(from, forward, BoardMove::PROMOTION + p - KNIGHT));
+            }
+            continue;
+        }
+        if (capturesOnly) continue;
+        list.add(BoardMove(from, forward, BoardMove::QUIET));
+        int twoUp = forward + up;
+        if ((squareBB(twoUp) & doubleRank & empty)) {
+            list.add(BoardMove(from, twoUp, BoardMove::DOUBLE_PUSH));
+        }
+    }
+}
+
+void Board::generatePieceMoves(MoveList& list, Bitboard targets) const {
+    const Color us = side;
+    const Bitboard occ = occupied();
+    const Bitboard enemies = colorBB[!us];
+    for (int type = KNIGHT; type <= KING; ++type) {
+        Bitboard bb = pieceBB[us][type];
+        while (bb) {
+            int from = popLsb(bb);
+            Bitboard moves = Bitboards::attacks(PieceType(type), from, occ) & targets;
+            while (moves) {
+                int to = popLsb(moves);
+                list.add(BoardMove(from, to, (squareBB(to) & enemies) ? BoardMove::CAPTURE : BoardMove::QUIET));
+            }
+        }
+    }
+}
+
+void Board::generateCastling(MoveList& list) const {
+    if (checkersBB) return;
+    const Color us = side;
+    const Color them = !us;
+    const int king = us == WHITE ? 4 : 60;
+    const uint8_t kingside = us == WHITE ? WHITE_KINGSIDE : BLACK_KINGSIDE;
+    const uint8_t queenside = us == WHITE ? WHITE_QUEENSIDE : BLACK_QUEENSIDE;
+    const Bitboard occ = occupied();
+
+    if ((castling & kingside) && !(occ & (squareBB(king + 1) | squareBB(king + 2)))
+        && !isSquareAttacked(king + 1, them) && !isSquareAttacked(king + 2, them)) {
+        list.add(BoardMove(king, king + 2, BoardMove::KING_CASTLE));
+    }
+    if ((castling & queenside) && !(occ & (squareBB(king - 1) | squareBB(king - 2) | squareBB(king - 3)))
+        && !isSquareAttacked(king - 1, them) && !isSquareAttacked(king - 2, them)) {
+        list.add(BoardMove(king, king - 2, BoardMove::QUEEN_CASTLE));
+    }
+}
+
+void Board::generateMoves(MoveList& list) const {
+    generatePawnMoves(list, false);
+    generatePieceMoves(list, ~colorBB[side]);
+    generateCastling(list);
+}
+
+void Board::generateCaptures(MoveList& list) const {
+    generatePawnMoves(list, true);
+    generatePieceMoves(list, colorBB[!side]);
+}
+
+void Board::generateLegalMoves(MoveList& list) const {
+    MoveList pseudo;
+    generateMoves(pseudo);
+    for (BoardMove move : pseudo) {
+        if (isLegal(move)) list.add(move);
+    }
+}
+
+bool Board::isLegal(BoardMove move) const {
+    const Color us = side;
+    const int from = move.from();
+    const int to = move.to();
+    const int king = kingSquare(us);
+
+    if (from == king) {
+        // Castling squares were already checked during generation
+        if (move.isCastle()) return true;
+        Bitboard occ = occupied() ^ squareBB(from);
+        return !(attackersTo(to, occ) & colorBB[!us]);
+    }
+
+    if (move.isEnPassant()) {
+        // Two pieces leave the king's lines at once, so test the resulting occupancy directly
+        int capturedSq = us == WHITE ? to - 8 : to + 8;
+        Bitboard occ = (occupied() ^ squareBB(from) ^ squareBB(capturedSq)) | squareBB(to);
+        return !(attackersTo(king, occ) & colorBB[!us] & ~squareBB(capturedSq));
+    }
+
+    if ((pinnedBB & squareBB(from)) && !(Bitboards::line(king, from) & squareBB(to))) return false;
+
+    if (checkersBB) {
+        if (checkersBB & (checkersBB - 1)) return false;
+        int checker = lsb(checkersBB);
+        return (Bitboards::between(king, checker) | squareBB(checker)) & squareBB(to);
+    }
+    return true;
+}
+
+bool Board::givesCheck(BoardMove move) const {
+    const Color us = side;
+    const int theirKing = kingSquare(!us);
+    const int from = move.from();
+    const int to = move.to();
+    PieceType moved = move.isPromotion() ? move.promotionType() : pieceType(squares[from]);
+
+    Bitboard occ = (occupied() ^ squareBB(from)) | squareBB(to);
+    if (move.isEnPassant()) occ ^= squareBB(us == WHITE ? to - 8 : to + 8);
+
+    // Direct check from the moved piece
+    if (moved == PAWN) {
+        if (Bitboards::pawnAttacks(us, to) & squareBB(theirKing)) return true;
+    } else if (moved != KING && (Bitboards::attacks(moved, to, occ) & squareBB(theirKing))) {
+        return true;
+    }
+
+    // Discovered checks (including the rook after castling)
+    Bitboard bishops = (pieceBB[us][BISHOP] | pieceBB[us][QUEEN]) & ~squareBB(from);
+    Bitboard rooks = (pieceBB[us][ROOK] | pieceBB[us][QUEEN]) & ~squareBB(from);
+    if (move.isCastle()) {
+        int rookFrom = move.flag() == BoardMove::KING_CASTLE ? from + 3 : from - 4;
+        int rookTo = move.flag() == BoardMove::KING_CASTLE ? from + 1 : from - 1;
+        occ ^= squareBB(rookFrom) | squareBB(rookTo);
+        rooks = (rooks & ~squareBB(rookFrom)) | squareBB(rookTo);
+    }
+    return (Bitboards::bishopAttacks(theirKing, occ) & bishops)
+        || (Bitboards::rookAttacks(theirKing, occ) & rooks);
+}
+
+bool Board::isRepetition() const {
+    int n = int(history.size());
+    int limit = std::min(halfmoves, n);
+    for (int i = 4; i <= limit; i += 2) {
+        if (history[n - i].key == hashKey) return true;
+    }
+    return false;
+}
+
+bool Board::hasInsufficientMaterial() const {
+    if (pieces(PAWN) | pieces(ROOK) | pieces(QUEEN)) return false;
+    // Lone minor piece on either side cannot mate
+    return popCount(pieces(KNIGHT) | pieces(BISHOP)) <= 1;
+}
+
+bool Board::hasNonPawnMaterial(Color c) const {
+    return (pieceBB[c][KNIGHT] | pieceBB[c][BISHOP] | pieceBB[c][ROOK] | pieceBB[c][QUEEN]) != 0;
+}
+
+BoardMove Board::parseUciMove(const std::string& uci) const {
+    if (uci.length() < 4) return BoardMove::none();
+    int from = squareOf(uci[1] - '1', uci[0] - 'a');
+    int to = squareOf(uci[3] - '1', uci[2] - 'a');
+    char promo = uci.length() > 4 ? char(std::tolower(static_cast<unsigned char>(uci[4]))) : 0;
+
+    MoveList legal;
+    generateLegalMoves(legal);
+    for (BoardMove move : legal) {
+        if (move.from() != from || move.to() != to) continue;
+        if (move.isPromotion() && "nbrq"[move.promotionType() - KNIGHT] != promo) continue;
+        return move;
+    }
+    return BoardMove::none();
+}
+
+BoardMove Board::fromModelMove(const Move& move) const {
+    // ChessModel always promotes to a queen
+    std::string uci = { char('a' + move.from.col), char('1' + move.from.row),
+                        char('a' + move.to.col), char('1' + move.to.row), 'q' };
+    return parseUciMove(uci);
+}
+
+Move Board::toModelMove(BoardMove move) {
+    return Move(Position(rowOf(move.from()), colOf(move.from())), Position(rowOf(move.to()), colOf(move.to())));
+}
@@ -0,0 +1,123 @@
+#ifndef BOARD_H
+#define BOARD_H
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "core/FenUtils.h"
+#include "engine/Bitboards.h"
+#include "engine/BoardMove.h"
+
+class Move;
+
+// Piece codes used by the board: color * 6 + type, NO_PIECE for empty squares.
+constexpr int NO_PIECE = 12;
+inline constexpr int makePiece(Color c, PieceType t) { return c * 6 + t; }
+inline constexpr Color pieceColor(int piece) { return piece < 6 ? WHITE : BLACK; }
+inline constexpr PieceType pieceType(int piece) { return PieceType(piece % 6); }
+
+// Castling right bits
+enum CastlingRight : uint8_t {
+    WHITE_KINGSIDE = 1,
+    WHITE_QUEENSIDE = 2,
+    BLACK_KINGSIDE = 4,
+    BLACK_QUEENSIDE = 8
+};
+
+// Bitboard position with incremental hashing and make/unmake, used by the engine.
+// Unlike ChessModel it owns no heap objects, so it can be copied freely between threads.
+class Board {
+public:
+    static constexpr const char* START_FEN = "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1";
+
+    Board();
+
+    bool setFromFen(std::string_view fen);
+    // For fields already read by FenUtils::parse, such as those of an EPD record
+    void setFromPosition(const FenPosition& fields);
+    std::string toFen() const;
+    // Null-terminated, without allocating; returns the length
+    size_t writeFen(char (&out)[FenUtils::FEN_BUFFER_SIZE]) const;
+
+    Color sideToMove() const { return side; }
+    int pieceAt(int sq) const { return squares[sq]; }
+    Bitboard pieces(Color c, PieceType t) const { return pieceBB[c][t]; }
+    Bitboard pieces(Color c) const { return colorBB[c]; }
+    Bitboard pieces(PieceType t) const { return pieceBB[WHITE][t] | pieceBB[BLACK][t]; }
+    Bitboard occupied() const { return colorBB[WHITE] | colorBB[BLACK]; }
+    int kingSquare(Color c) const { return lsb(pieceBB[c][KING]); }
+    int castlingRights() const { return castling; }
+    int enPassantSquare() const { return epSquare; }
+    int halfmoveClock() const { return halfmoves; }
+    int fullmoveNumber() const { return fullmoves; }
+    uint64_t key() const { return hashKey; }
+    int gamePly() const { return int(history.size()); }
+
+    // Move generation. generateMoves is pseudo-legal: filter with isLegal().
+    void generateMoves(MoveList& list) const;
+    void generateCaptures(MoveList& list) const;
+    void generateLegalMoves(MoveList& list) const;
+    bool isLegal(BoardMove move) const;
+
+    void makeMove(BoardMove move);
+    void unmakeMove();
+    void makeNullMove();
+    void unmakeNullMove();
+    BoardMove lastMove() const { return history.empty() ? BoardMove::none() : history.back().move; }
+
+    bool inCheck() const { return checkersBB != 0; }
+    Bitboard checkers() const { return checkersBB; }
+    Bitboard attackersTo(int sq, Bitboard occ) const;
+    bool isSquareAttacked(int sq, Color by) const;
+    bool givesCheck(BoardMove move) const;
+
+    bool isRepetition() const;
+    bool isFiftyMoveDraw() const { return halfmoves >= 100; }
+    bool hasInsufficientMaterial() const;
+    bool hasNonPawnMaterial(Color c) const;
+
+    // Conversions between engine moves and the GUI/model representations
+    BoardMove parseUciMove(const std::string& uci) const;
+    BoardMove fromModelMove(const Move& move) const;
+    static Move toModelMove(BoardMove move);
+
+private:
+    struct UndoInfo {
+        BoardMove move;
+        uint8_t captured;
+        uint8_t castling;
+        uint8_t epSquare;
+        uint16_t halfmoves;
+        uint64_t key;
+        Bitboard checkers;
+        Bitboard pinned;
+    };
+
+    Bitboard pieceBB[2][6];
+    Bitboard colorBB[2];
+    uint8_t squares[64];
+    Color side;
+    uint8_t castling;
+    uint8_t epSquare;
+    int halfmoves;
+    int fullmoves;
+    uint64_t hashKey;
+    Bitboard checkersBB;
+    Bitboard pinnedBB;
+    std::vector<UndoInfo> history;
+
+    void clear();
+    void putPiece(int piece, int sq);
+    void removePiece(int sq);
+    void movePiece(int from, int to);
+    void updateCheckInfo();
+    void pushUndo(BoardMove move);
+    uint64_t computeKey() const;
+
+    void generatePawnMoves(MoveList& list, bool capturesOnly) const;
+    void generatePieceMoves(MoveList& list, Bitboard targets) const;
+    void generateCastling(MoveList& list) const;
+};
+
+#endif // BOARD_H
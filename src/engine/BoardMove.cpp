@@ -0,0 +1,12 @@
+#include "engine/BoardMove.h"
+
+std::string BoardMove::toUci() const {
+    if (isNone()) return "0000";
+    std::string uci;
+    uci += char('a' + colOf(from()));
+    uci += char('1' + rowOf(from()));
+    uci += char('a' + colOf(to()));
+    uci += char('1' + rowOf(to()));
+    if (isPromotion()) uci += "nbrq"[promotionType() - KNIGHT];
+    return uci;
+}
@@ -0,0 +1,70 @@
+#ifndef BOARDMOVE_H
+#define BOARDMOVE_H
+
+#include <cstdint>
+#include <string>
+#include "engine/Bitboards.h"
+
+// Compact 16-bit move used by the engine: 6 bits from, 6 bits to, 4 bits flags.
+class BoardMove {
+public:
+    enum Flag : uint8_t {
+        QUIET = 0,
+        DOUBLE_PUSH = 1,
+        KING_CASTLE = 2,
+        QUEEN_CASTLE = 3,
+        CAPTURE = 4,
+        EN_PASSANT = 5,
+        PROMOTION = 8,         // + (piece - KNIGHT), i.e. 8..11 = N, B, R, Q
+        PROMOTION_CAPTURE = 12 // + (piece - KNIGHT), i.e. 12..15
+    };
+
+    constexpr BoardMove() : data(0) {}
+    constexpr BoardMove(int from, int to, int flag = QUIET)
+        : data(uint16_t(from | (to << 6) | (flag << 12))) {}
+
+    static constexpr BoardMove fromRaw(uint16_t raw) { BoardMove m; m.data = raw; return m; }
+    static constexpr BoardMove none() { return BoardMove(); }
+
+    constexpr int from() const { return data & 0x3F; }
+    constexpr int to() const { return (data >> 6) & 0x3F; }
+    constexpr int flag() const { return data >> 12; }
+    constexpr uint16_t raw() const { return data; }
+
+    constexpr bool isNone() const { return data == 0; }
+    constexpr bool isCapture() const { return (flag() & CAPTURE) != 0; }
+    constexpr bool isPromotion() const { return (flag() & PROMOTION) != 0; }
+    constexpr bool isCastle() const { return flag() == KING_CASTLE || flag() == QUEEN_CASTLE; }
+    constexpr bool isEnPassant() const { return flag() == EN_PASSANT; }
+    constexpr bool isQuiet() const { return !isCapture() && !isPromotion(); }
+    constexpr PieceType promotionType() const {
+        return isPromotion() ? PieceType(KNIGHT + (flag() & 3)) : NO_PIECE_TYPE;
+    }
+
+    constexpr bool operator==(const BoardMove& other) const { return data == other.data; }
+    constexpr bool operator!=(const BoardMove& other) const { return data != other.data; }
+
+    // Long algebraic notation as used by UCI, e.g. "e2e4" or "e7e8q"
+    std::string toUci() const;
+
+private:
+    uint16_t data;
+};
+
+// Fixed-capacity move container; no position has more than 218 legal moves.
+struct MoveList {
+    BoardMove moves[256];
+    int count = 0;
+
+    void add(BoardMove move) { moves[count++] = move; }
+    int size() const { return count; }
+    bool empty() const { return count == 0; }
+    BoardMove& operator[](int i) { return moves[i]; }
+    const BoardMove& operator[](int i) const { return moves[i]; }
+    BoardMove* begin() { return moves; }
+    BoardMove* end() { return moves + count; }
+    const BoardMove* begin() const { return moves; }
+    const BoardMove* end() const { return moves + count; }
+};
+
+#endif // BOARDMOVE_H
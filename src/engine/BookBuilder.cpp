@@ -0,0 +1,240 @@
+#include "engine/BookBuilder.h"
+#include "engine/Board.h"
+#include "engine/OpeningBook.h"
+
+#include <algorithm>
+#include <fstream>
+#include <queue>
+
+BookBuilder::BookBuilder(const Settings& settings) : settings(settings) {
+    this->settings.threads = std::max(1, settings.threads);
+    pendingBatch.reserve(BATCH_GAMES);
+    states.resize(size_t(this->settings.threads));
+    for (WorkerState& state : states) {
+        workers.emplace_back([this, &state] { workerLoop(state); });
+    }
+}
+
+BookBuilder::~BookBuilder() {
+    closeQueue();
+    for (std::thread& worker : workers) {
+        if (worker.joinable()) worker.join();
+    }
+}
+
+void BookBuilder::addGame(Result result, const std::string& packedMoves, const std::string& startFen) {
+    pendingBatch.push_back({ result, packedMoves, startFen });
+    if (pendingBatch.size() >= BATCH_GAMES) {
+        pushBatch(std::move(pendingBatch));
+        pendingBatch = Batch();
+        pendingBatch.reserve(BATCH_GAMES);
+    }
+}
+
+void BookBuilder::pushBatch(Batch&& batch) {
+    if (batch.empty()) return;
+    std::unique_lock<std::mutex> lock(queueMutex);
+    // Bounded, so a fast reader cannot pile the whole database up in memory
+    queueNotFull.wait(lock, [this] { return queue.size() < 4 * workers.size(); });
+    queue.push_back(std::move(batch));
+    queueNotEmpty.notify_one();
+}
+
+void BookBuilder::closeQueue() {
+    std::lock_guard<std::mutex> lock(queueMutex);
+    closed = true;
+    queueNotEmpty.notify_all();
+}
+
+void BookBuilder::workerLoop(WorkerState& state) {
+    Board board;
+    state.buffer.reserve(BUFFER_ENTRIES);
+    while (true) {
+        Batch batch;
+        {
+            std::unique_lock<std::mutex> lock(queueMutex);
+            queueNotEmpty.wait(lock, [this] { return closed || !queue.empty(); });
+            if (queue.empty()) break;
+            batch = std::move(queue.front());
+            queue.pop_front();
+            queueNotFull.notify_one();
+        }
+        for (const Game& game : batch) replayGame(board, game, state);
+    }
+    flushBuffer(state);
+}
+
+void BookBuilder::replayGame(Board& board, const Game& game, WorkerState& state) const {
+    const int plies = std::min<int>(int(game.packedMoves.size() / 2), settings.maxPlies);
+    state.games++;
+    if (!board.setFromFen(game.startFen.empty() ? std::string_view(Board::START_FEN) : std::string_view(game.startFen))) {
+        state.skippedMoves += uint64_t(plies);
+        return;
+    }
+
+    for (int ply = 0; ply < plies; ++ply) {
+        const int from = uint8_t(game.packedMoves[2 * ply]);
+        const int to = uint8_t(game.packedMoves[2 * ply + 1]);
+
+        // Match from/to against the pseudo-legal moves; promotions are always to a queen
+        BoardMove played = BoardMove::none();
+        MoveList moves;
+        board.generateMoves(moves);
+        for (BoardMove move : moves) {
+            if (move.from() == from && move.to() == to
+                && (!move.isPromotion() || move.promotionType() == QUEEN)) {
+                played = move;
+                break;
+            }
+        }
+        if (played.isNone() || !board.isLegal(played)) {
+            // The rest of the game cannot be trusted
+            state.skippedMoves += uint64_t(plies - ply);
+            break;
+        }
+
+        uint32_t score = 1;
+        if (game.result != Result::Draw) {
+            const Color winner = game.result == Result::WhiteWins ? WHITE : BLACK;
+            score = board.sideToMove() == winner ? 2 : 0;
+        }
+        state.buffer.push_back({ OpeningBook::key(board), OpeningBook::encodeMove(played), score, 1 });
+        if (state.buffer.size() >= BUFFER_ENTRIES) flushBuffer(state);
+
+        board.makeMove(played);
+    }
+}
+
+void BookBuilder::flushBuffer(WorkerState& state) const {
+    if (state.buffer.empty()) return;
+    sortAndCombine(state.buffer);
+    state.runs.push_back(std::move(state.buffer));
+    state.buffer = Run();
+    state.buffer.reserve(BUFFER_ENTRIES);
+
+    // Merge while the newest run has caught up with the one below it, so the runs
+    // shrink geometrically and every entry is merged only O(log n) times
+    while (state.runs.size() >= 2 && state.runs[state.runs.size() - 2].size() <= 2 * state.runs.back().size()) {
+        Run merged = mergeRuns(state.runs[state.runs.size() - 2], state.runs.back());
+        state.runs.pop_back();
+        state.runs.back() = std::move(merged);
+    }
+}
+
+void BookBuilder::sortAndCombine(Run& run) {
+    std::sort(run.begin(), run.end(), [](const Entry& a, const Entry& b) {
+        return a.key != b.key ? a.key < b.key : a.move < b.move;
+    });
+    size_t out = 0;
+    for (size_t i = 0; i < run.size(); ++i) {
+        if (out > 0 && run[out - 1].key == run[i].key && run[out - 1].move == run[i].move) {
+            run[out - 1].score += run[i].score;
+            run[out - 1].games += run[i].games;
+        } else {
+            run[out++] = run[i];
+        }
+    }
+    run.resize(out);
+}
+
+BookBuilder::Run BookBuilder::mergeRuns(const Run& a, const Run& b) {
+    Run merged;
+    merged.reserve(a.size() + b.size());
+    size_t i = 0, j = 0;
+    while (i < a.size() || j < b.size()) {
+        const Entry *next;
+        if (j == b.size()) next = &a[i++];
+        else if (i == a.size()) next = &b[j++];
+        else if (a[i].key != b[j].key ? a[i].key < b[j].key : a[i].move <= b[j].move) next = &a[i++];
+        else next = &b[j++];
+
+        if (!merged.empty() && merged.back().key == next->key && merged.back().move == next->move) {
+            merged.back().score += next->score;
+            merged.back().games += next->games;
+        } else {
+            merged.push_back(*next);
+        }
+    }
+    return merged;
+}
+
+bool BookBuilder::finish(const std::string& path) {
+    if (!pendingBatch.empty()) pushBatch(std::move(pendingBatch));
+    pendingBatch = Batch();
+    closeQueue();
+    for (std::thread& worker : workers) {
+        if (worker.joinable()) worker.join();
+    }
+    for (const WorkerState& state : states) {
+        totals.games += state.games;
+        totals.skippedMoves += state.skippedMoves;
+    }
+    return writeBook(path);
+}
+
+bool BookBuilder::writeBook(const std::string& path) {
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    if (!out) return false;
+
+    // Min-heap over the head of every run from every worker
+    struct Cursor {
+        const Run *run;
+        size_t index;
+    };
+    auto later = [](const Cursor& a, const Cursor& b) {
+        const Entry& x = (*a.run)[a.index];
+        const Entry& y = (*b.run)[b.index];
+        return x.key != y.key ? x.key > y.key : x.move > y.move;
+    };
+    std::priority_queue<Cursor, std::vector<Cursor>, decltype(later)> heap(later);
+    for (const WorkerState& state : states) {
+        for (const Run& run : state.runs) {
+            if (!run.empty()) heap.push({ &run, 0 });
+        }
+    }
+
+    std::vector<Entry> group; // the moves of one position, combined across runs
+    auto writeGroup = [&]() {
+        uint32_t maxScore = 0;
+        for (const Entry& entry : group) {
+            if (entry.games >= uint32_t(settings.minGames)) maxScore = std::max(maxScore, entry.score);
+        }
+        bool written = false;
+        for (const Entry& entry : group) {
+            if (entry.games < uint32_t(settings.minGames)) continue;
+            // Weights are 16 bits: scale the position down when its best move overflows
+            uint64_t weight = maxScore > 0xFFFF ? uint64_t(entry.score) * 0xFFFF / maxScore : entry.score;
+            if (weight == 0) continue;
+
+            unsigned char bytes[OpeningBook::ENTRY_SIZE] = {};
+            for (int i = 0; i < 8; ++i) bytes[i] = uint8_t(entry.key >> (56 - 8 * i));
+            bytes[8] = uint8_t(entry.move >> 8);
+            bytes[9] = uint8_t(entry.move);
+            bytes[10] = uint8_t(weight >> 8);
+            bytes[11] = uint8_t(weight);
+            out.write(reinterpret_cast<const char*>(bytes), sizeof(bytes));
+            totals.entries++;
+            written = true;
+        }
+        if (written) totals.positions++;
+        group.clear();
+    };
+
+    while (!heap.empty()) {
+        Cursor cursor = heap.top();
+        heap.pop();
+        const Entry& entry = (*cursor.run)[cursor.index];
+        if (!group.empty() && group.back().key != entry.key) writeGroup();
+        if (!group.empty() && group.back().move == entry.move) {
+            group.back().score += entry.score;
+            group.back().games += entry.games;
+        } else {
+            group.push_back(entry);
+        }
+        if (++cursor.index < cursor.run->size()) heap.push(cursor);
+    }
+    writeGroup();
+
+    out.close();
+    return bool(out);
+}
@@ -0,0 +1,102 @@
+#ifndef BOOKBUILDER_H
+#define BOOKBUILDER_H
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+class Board;
+
+// Builds a Polyglot opening book from finished games.
+//
+// Games are handed over with addGame() in batches to a pool of worker threads. Each
+// worker replays its games on a private Board and records one (position key, move)
+// entry per ply, scored the way Polyglot's own builder does it: two points for a move
+// by the side that went on to win, one for a draw, none for a loss. Entries are
+// sorted and summed in bounded chunks, and the chunks are merged in size order so a
+// worker holds only a few sorted runs at any time. finish() merges the runs of all
+// workers in one pass and writes the book, which needs no sort afterwards.
+class BookBuilder {
+public:
+    enum class Result { WhiteWins, BlackWins, Draw };
+
+    struct Settings {
+        int maxPlies = 30;   // plies of each game that go into the book
+        int minGames = 1;    // moves played in fewer games are left out
+        int threads = 1;
+    };
+
+    struct Stats {
+        uint64_t games = 0;
+        uint64_t skippedMoves = 0; // plies that did not replay (illegal or corrupt)
+        uint64_t positions = 0;    // distinct keys written
+        uint64_t entries = 0;      // entries written
+    };
+
+    explicit BookBuilder(const Settings& settings);
+    ~BookBuilder();
+
+    // packedMoves holds two bytes per ply, from and to square (row * 8 + col);
+    // promotions are to a queen, as ChessModel plays them. The game starts from startFen,
+    // or from the standard position when it is empty.
+    void addGame(Result result, const std::string& packedMoves, const std::string& startFen = std::string());
+
+    // Waits for the workers, merges their runs and writes the book
+    bool finish(const std::string& path);
+    const Stats& stats() const { return totals; }
+
+private:
+    struct Entry {
+        uint64_t key;
+        uint16_t move;
+        uint32_t score;
+        uint32_t games;
+    };
+    using Run = std::vector<Entry>;
+
+    struct Game {
+        Result result;
+        std::string packedMoves;
+        std::string startFen;
+    };
+    using Batch = std::vector<Game>;
+
+    struct WorkerState {
+        std::vector<Run> runs;
+        Run buffer;
+        uint64_t games = 0;
+        uint64_t skippedMoves = 0;
+    };
+
+    static constexpr size_t BATCH_GAMES = 256;
+    static constexpr size_t BUFFER_ENTRIES = 1 << 20;
+
+    Settings settings;
+    Stats totals;
+    Batch pendingBatch;
+
+    std::mutex queueMutex;
+    std::condition_variable queueNotEmpty;
+    std::condition_variable queueNotFull;
+    std::deque<Batch> queue;
+    bool closed = false;
+
+    std::vector<WorkerState> states;
+    std::vector<std::thread> workers;
+
+    void pushBatch(Batch&& batch);
+    void closeQueue();
+    void workerLoop(WorkerState& state);
+    void replayGame(Board& board, const Game& game, WorkerState& state) const;
+    void flushBuffer(WorkerState& state) const;
+
+    static void sortAndCombine(Run& run);
+    static Run mergeRuns(const Run& a, const Run& b);
+    bool writeBook(const std::string& path);
+};
+
+#endif // BOOKBUILDER_H
@@ -0,0 +1,40 @@
+#ifndef CHESSENGINE_H
+#define CHESSENGINE_H
+
+#include <QObject>
+#include <QString>
+#include "engine/Board.h"
+#include "engine/Search.h"
+
+// Common interface of the engines the GUI can drive: the built-in engine on its own
+// thread (EngineController) and external UCI programs (ExternalEngine). All calls are
+// made on the GUI thread and never block; results arrive through the signals.
+class ChessEngine : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit ChessEngine(QObject *parent = nullptr) : QObject(parent) {}
+    virtual ~ChessEngine() = default;
+
+    virtual QString name() const = 0;
+
+    // Starts a search on a snapshot of the position, cancelling any search in progress
+    virtual quint64 startSearch(const Board& position, const SearchLimits& limits) = 0;
+    // Ends the current search early; its best move is still reported
+    virtual void stop() = 0;
+    // Ends the current search and discards its result
+    virtual void cancel() = 0;
+    // The expected move was played: the running ponder search becomes a normal timed search
+    virtual void ponderHit() = 0;
+    virtual void clearHash() = 0;
+
+    virtual bool isSearching() const = 0;
+
+signals:
+    void searchInfo(const SearchInfo& info);
+    void bestMoveFound(const SearchResult& result);
+    void engineError(const QString& message);
+};
+
+#endif // CHESSENGINE_H
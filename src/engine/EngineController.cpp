@@ -0,0 +1,88 @@
+#include "engine/EngineController.h"
+#include "engine/EngineWorker.h"
+
+#include <QDebug>
+
+EngineController::EngineController(QObject *parent)
+    : ChessEngine(parent)
+{
+    qRegisterMetaType<SearchInfo>();
+    qRegisterMetaType<SearchResult>();
+
+    worker = new EngineWorker();
+    worker->moveToThread(&workerThread);
+    connect(&workerThread, &QThread::finished, worker, &QObject::deleteLater);
+    connect(worker, &EngineWorker::searchInfo, this, &EngineController::onWorkerInfo, Qt::QueuedConnection);
+    connect(worker, &EngineWorker::searchFinished, this, &EngineController::onWorkerFinished, Qt::QueuedConnection);
+    workerThread.setObjectName("EngineThread");
+    workerThread.start();
+}
+
+EngineController::~EngineController()
+{
+    cancel();
+    workerThread.quit();
+    workerThread.wait();
+}
+
+QString EngineController::name() const
+{
+    return tr("Built-in engine");
+}
+
+quint64 EngineController::startSearch(const Board& position, const SearchLimits& limits)
+{
+    quint64 searchId = nextSearchId++;
+    activeSearchId = searchId;
+    searching = true;
+
+    // Mark the new id first so a search that has not started yet is skipped, then abort the running one
+    worker->setLatestSearchId(searchId);
+    worker->abort();
+    QMetaObject::invokeMethod(worker, [w = worker, searchId, position, limits]() {
+        w->search(searchId, position, limits);
+    }, Qt::QueuedConnection);
+    return searchId;
+}
+
+void EngineController::stop()
+{
+    if (searching) worker->abort();
+}
+
+void EngineController::ponderHit()
+{
+    if (searching) worker->ponderHit();
+}
+
+void EngineController::cancel()
+{
+    if (!searching) return;
+    activeSearchId = 0;
+    searching = false;
+    // Retire the id too, so a search that is still queued is skipped rather than started
+    worker->setLatestSearchId(nextSearchId++);
+    worker->abort();
+}
+
+void EngineController::clearHash()
+{
+    QMetaObject::invokeMethod(worker, &EngineWorker::clearHash, Qt::QueuedConnection);
+}
+
+void EngineController::onWorkerInfo(quint64 searchId, const SearchInfo& info)
+{
+    if (searchId != activeSearchId) return;
+    emit searchInfo(info);
+}
+
+void EngineController::onWorkerFinished(quint64 searchId, const SearchResult& result)
+{
+    if (searchId != activeSearchId) {
+        qDebug() << "Discarding stale engine result for search" << searchId;
+        return;
+    }
+    searching = false;
+    activeSearchId = 0;
+    emit bestMoveFound(result);
+}
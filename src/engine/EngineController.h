@@ -0,0 +1,41 @@
+#ifndef ENGINECONTROLLER_H
+#define ENGINECONTROLLER_H
+
+#include <QThread>
+#include "engine/ChessEngine.h"
+
+class EngineWorker;
+
+// GUI-thread front end of the built-in engine. Owns the engine thread and makes sure
+// only results of the most recent search are delivered.
+class EngineController : public ChessEngine
+{
+    Q_OBJECT
+
+public:
+    explicit EngineController(QObject *parent = nullptr);
+    ~EngineController() override;
+
+    QString name() const override;
+    quint64 startSearch(const Board& position, const SearchLimits& limits) override;
+    void stop() override;
+    void cancel() override;
+    void ponderHit() override;
+    void clearHash() override;
+
+    bool isSearching() const override { return searching; }
+    quint64 currentSearchId() const { return activeSearchId; }
+
+private slots:
+    void onWorkerInfo(quint64 searchId, const SearchInfo& info);
+    void onWorkerFinished(quint64 searchId, const SearchResult& result);
+
+private:
+    QThread workerThread;
+    EngineWorker *worker = nullptr;
+    quint64 nextSearchId = 1;
+    quint64 activeSearchId = 0;
+    bool searching = false;
+};
+
+#endif // ENGINECONTROLLER_H
@@ -0,0 +1,42 @@
+#include "engine/EngineWorker.h"
+
+#include <QDebug>
+
+EngineWorker::EngineWorker(QObject *parent)
+    : QObject(parent), tt(64), engineSearch(tt)
+{
+}
+
+void EngineWorker::abort() {
+    engineSearch.stop();
+}
+
+void EngineWorker::ponderHit() {
+    engineSearch.ponderHit();
+}
+
+void EngineWorker::search(quint64 searchId, const Board& position, const SearchLimits& limits) {
+    // Clear the stop flag before the staleness check: an abort that lands in between is
+    // always preceded by a newer search id, so the check below still catches it
+    engineSearch.clearStop();
+    // A newer request is already queued behind this one, or this one was cancelled
+    if (searchId < latestSearchId.load()) {
+        emit searchFinished(searchId, SearchResult());
+        return;
+    }
+
+    engineSearch.setInfoCallback([this, searchId](const SearchInfo& info) {
+        emit searchInfo(searchId, info);
+    });
+    SearchResult result = engineSearch.run(position, limits);
+    engineSearch.setInfoCallback(nullptr);
+
+    qDebug() << "Engine search" << searchId << "finished:" << QString::fromStdString(result.bestMove.toUci())
+             << "score" << result.score << "depth" << result.depth << "nodes" << result.nodes;
+    emit searchFinished(searchId, result);
+}
+
+void EngineWorker::clearHash() {
+    tt.clear();
+    engineSearch.clearHistory();
+}
@@ -0,0 +1,42 @@
+#ifndef ENGINEWORKER_H
+#define ENGINEWORKER_H
+
+#include <QObject>
+#include <QMetaType>
+#include <atomic>
+#include "engine/Board.h"
+#include "engine/Search.h"
+#include "engine/TranspositionTable.h"
+
+Q_DECLARE_METATYPE(SearchInfo)
+Q_DECLARE_METATYPE(SearchResult)
+
+// Runs searches on the engine thread. Lives in its own QThread and is driven by
+// EngineController; results come back to the GUI thread through queued signals.
+class EngineWorker : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit EngineWorker(QObject *parent = nullptr);
+
+    // Thread-safe: called from the GUI thread while a search is running
+    void abort();
+    void ponderHit();
+    void setLatestSearchId(quint64 searchId) { latestSearchId.store(searchId); }
+
+public slots:
+    void search(quint64 searchId, const Board& position, const SearchLimits& limits);
+    void clearHash();
+
+signals:
+    void searchInfo(quint64 searchId, const SearchInfo& info);
+    void searchFinished(quint64 searchId, const SearchResult& result);
+
+private:
+    TranspositionTable tt;
+    Search engineSearch;
+    std::atomic<quint64> latestSearchId { 0 };
+};
+
+#endif // ENGINEWORKER_H
@@ -0,0 +1,272 @@
+#include "engine/EpdSuite.h"
+#include "engine/Board.h"
+#include "engine/San.h"
+#include "engine/Search.h"
+#include "engine/TranspositionTable.h"
+
+#include <QFile>
+#include <QDebug>
+#include <algorithm>
+#include <atomic>
+#include <charconv>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+namespace {
+
+bool isSpace(char c) { return c == ' ' || c == '\t' || c == '\r' || c == '\n'; }
+
+template <typename T>
+bool readNumber(std::string_view text, T& value) {
+    const char* end = text.data() + text.size();
+    const auto [ptr, ec] = std::from_chars(text.data(), end, value);
+    return ec == std::errc() && ptr == end;
+}
+
+bool contains(const std::vector<BoardMove>& moves, BoardMove move) {
+    return std::find(moves.begin(), moves.end(), move) != moves.end();
+}
+
+void addFailure(std::string& failure, const std::string& text) {
+    if (!failure.empty()) failure += "; ";
+    failure += text;
+}
+
+EpdSuite::Result checkRecord(const EpdRecord& record, const EpdSuite::Settings& settings,
+                             TranspositionTable& tt, Search& search) {
+    EpdSuite::Result result;
+    const auto start = std::chrono::steady_clock::now();
+    Board board;
+    board.setFromPosition(record.position);
+
+    if (!record.bestMoves.empty() || !record.avoidMoves.empty() || record.mateIn > 0) {
+        MoveList legal;
+        board.generateLegalMoves(legal);
+        if (legal.empty()) {
+            addFailure(result.failure, "no legal move to search");
+        } else {
+            // Every position starts from an empty table, so results do not depend on
+            // which thread searched what before
+            SearchLimits limits;
+            limits.depth = settings.depth;
+            if (settings.depth == 0) limits.moveTimeMs = settings.moveTimeMs;
+            tt.clear();
+            search.clearHistory();
+            search.clearStop();
+            const SearchResult searched = search.run(board, limits);
+            result.searched = true;
+            result.bestMove = searched.bestMove;
+            result.score = searched.score;
+            result.depth = searched.depth;
+            result.nodes += searched.nodes;
+
+            char san[San::SAN_BUFFER_SIZE];
+            San::write(board, searched.bestMove, san);
+            if (!record.bestMoves.empty() && !contains(record.bestMoves, searched.bestMove)) {
+                addFailure(result.failure, std::string("bm, played ") + san);
+            }
+            if (contains(record.avoidMoves, searched.bestMove)) {
+                addFailure(result.failure, std::string("am, played ") + san);
+            }
+            if (record.mateIn > 0) {
+                const int mateIn = Search::isMateScore(searched.score) ? Search::mateInMoves(searched.score) : 0;
+                if (mateIn <= 0 || mateIn > record.mateIn) {
+                    addFailure(result.failure, "dm " + std::to_string(record.mateIn) + ", found "
+                               + (mateIn > 0 ? "mate in " + std::to_string(mateIn) : std::string("no mate")));
+                }
+            }
+        }
+    }
+
+    for (const auto& [depth, expected] : record.perftCounts) {
+        if (settings.maxPerftDepth > 0 && depth > settings.maxPerftDepth) continue;
+        const uint64_t counted = EpdSuite::perft(board, depth);
+        result.nodes += counted;
+        if (counted != expected) {
+            addFailure(result.failure, "D" + std::to_string(depth) + " " + std::to_string(counted)
+                       + " instead of " + std::to_string(expected));
+        }
+    }
+
+    result.timeMs = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+    result.passed = result.failure.empty();
+    return result;
+}
+
+} // namespace
+
+bool EpdSuite::load(const std::string& path) {
+    QFile file(QString::fromStdString(path));
+    if (!file.open(QIODevice::ReadOnly)) {
+        qWarning() << "EpdSuite: cannot open" << QString::fromStdString(path) << file.errorString();
+        return false;
+    }
+    const qint64 size = file.size();
+    if (size == 0) {
+        parse(std::string_view());
+        return true;
+    }
+    const uchar* data = file.map(0, size);
+    if (!data) {
+        qWarning() << "EpdSuite: cannot map" << QString::fromStdString(path) << file.errorString();
+        return false;
+    }
+    parse(std::string_view(reinterpret_cast<const char*>(data), size_t(size)));
+    file.unmap(const_cast<uchar*>(data));
+    return true;
+}
+
+void EpdSuite::parse(std::string_view text) {
+    suite.clear();
+    parseErrors.clear();
+    size_t lineNumber = 0;
+    size_t pos = 0;
+    while (pos < text.size()) {
+        const size_t eol = text.find('\n', pos);
+        std::string_view line = text.substr(pos, eol == std::string_view::npos ? std::string_view::npos : eol - pos);
+        pos = eol == std::string_view::npos ? text.size() : eol + 1;
+        lineNumber++;
+
+        while (!line.empty() && isSpace(line.front())) line.remove_prefix(1);
+        if (line.empty() || line.front() == '#') continue;
+
+        EpdRecord record;
+        std::string error;
+        if (!parseRecord(line, record, error)) {
+            parseErrors.push_back("line " + std::to_string(lineNumber) + ": " + error);
+        } else if (record.bestMoves.empty() && record.avoidMoves.empty() && record.mateIn == 0
+                   && record.perftCounts.empty()) {
+            parseErrors.push_back("line " + std::to_string(lineNumber) + ": no bm, am, dm or D<n> operation");
+        } else {
+            suite.push_back(std::move(record));
+        }
+    }
+}
+
+bool EpdSuite::parseRecord(std::string_view line, EpdRecord& record, std::string& error) {
+    record = EpdRecord();
+    std::string_view operations;
+    const FenError fenError = FenUtils::parse(line, record.position, &operations);
+    if (fenError != FenError::None) {
+        error = FenUtils::errorMessage(fenError);
+        return false;
+    }
+    Board board;
+    board.setFromPosition(record.position);
+
+    // Each operation is an opcode and its operands up to a ';' outside quotes
+    std::vector<std::string_view> operands;
+    size_t i = 0;
+    const size_t n = operations.size();
+    while (i < n) {
+        while (i < n && (isSpace(operations[i]) || operations[i] == ';')) ++i;
+        if (i == n) break;
+        const size_t opcodeStart = i;
+        while (i < n && !isSpace(operations[i]) && operations[i] != ';') ++i;
+        const std::string_view opcode = operations.substr(opcodeStart, i - opcodeStart);
+
+        operands.clear();
+        while (i < n && operations[i] != ';') {
+            if (isSpace(operations[i])) {
+                ++i;
+            } else if (operations[i] == '"') {
+                const size_t close = operations.find('"', i + 1);
+                if (close == std::string_view::npos) {
+                    error = "unterminated string";
+                    return false;
+                }
+                operands.push_back(operations.substr(i + 1, close - i - 1));
+                i = close + 1;
+            } else {
+                const size_t start = i;
+                while (i < n && !isSpace(operations[i]) && operations[i] != ';') ++i;
+                operands.push_back(operations.substr(start, i - start));
+            }
+        }
+
+        if (opcode == "bm" || opcode == "am") {
+            std::vector<BoardMove>& moves = opcode == "bm" ? record.bestMoves : record.avoidMoves;
+            for (std::string_view token : operands) {
+                BoardMove move;
+                const SanError sanError = San::parse(board, token, move);
+                if (sanError != SanError::None) {
+                    error = std::string(opcode) + " " + std::string(token) + ": " + San::errorMessage(sanError);
+                    return false;
+                }
+                moves.push_back(move);
+            }
+        } else if (opcode == "dm") {
+            if (operands.size() != 1 || !readNumber(operands[0], record.mateIn) || record.mateIn <= 0) {
+                error = "malformed dm";
+                return false;
+            }
+        } else if (opcode.size() > 1 && opcode[0] == 'D') {
+            int depth = 0;
+            uint64_t count = 0;
+            if (!readNumber(opcode.substr(1), depth) || depth <= 0 || operands.size() != 1
+                || !readNumber(operands[0], count)) {
+                error = "malformed " + std::string(opcode);
+                return false;
+            }
+            record.perftCounts.emplace_back(depth, count);
+        } else if (opcode == "id" && !operands.empty()) {
+            record.id = std::string(operands[0]);
+        } else if (opcode == "hmvc" && operands.size() == 1) {
+            readNumber(operands[0], record.position.halfmoveClock);
+        } else if (opcode == "fmvn" && operands.size() == 1) {
+            readNumber(operands[0], record.position.fullmoveNumber);
+        }
+    }
+    return true;
+}
+
+void EpdSuite::run(const Settings& settings, const ResultCallback& callback) const {
+    std::vector<Result> results(suite.size());
+    std::vector<char> finished(suite.size(), 0);
+    std::mutex mutex;
+    std::condition_variable resultReady;
+    std::atomic<size_t> next { 0 };
+
+    auto work = [&] {
+        TranspositionTable tt(settings.hashMb);
+        Search search(tt);
+        while (true) {
+            const size_t index = next.fetch_add(1);
+            if (index >= suite.size()) break;
+            Result result = checkRecord(suite[index], settings, tt, search);
+            std::lock_guard<std::mutex> lock(mutex);
+            results[index] = std::move(result);
+            finished[index] = 1;
+            resultReady.notify_one();
+        }
+    };
+    const int threads = int(std::min(size_t(std::max(1, settings.threads)), std::max<size_t>(1, suite.size())));
+    std::vector<std::thread> pool;
+    for (int i = 0; i < threads; ++i) pool.emplace_back(work);
+
+    for (size_t index = 0; index < suite.size(); ++index) {
+        Result result;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            resultReady.wait(lock, [&] { return finished[index] != 0; });
+            result = std::move(results[index]);
+        }
+        if (callback) callback(index, suite[index], result);
+    }
+    for (std::thread& thread : pool) thread.join();
+}
+
+uint64_t EpdSuite::perft(Board& board, int depth) {
+    MoveList moves;
+    board.generateLegalMoves(moves);
+    if (depth <= 1) return depth == 1 ? uint64_t(moves.size()) : 1;
+    uint64_t nodes = 0;
+    for (BoardMove move : moves) {
+        board.makeMove(move);
+        nodes += perft(board, depth - 1);
+        board.unmakeMove();
+    }
+    return nodes;
+}
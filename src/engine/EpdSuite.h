@@ -0,0 +1,75 @@
+#ifndef EPDSUITE_H
+#define EPDSUITE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+#include "core/FenUtils.h"
+#include "engine/BoardMove.h"
+
+class Board;
+
+// One position of an EPD test suite and the operations that can be checked
+struct EpdRecord {
+    std::string id;
+    FenPosition position;
+    std::vector<BoardMove> bestMoves;                  // bm: the search must play one of these
+    std::vector<BoardMove> avoidMoves;                 // am: ... and none of these
+    int mateIn = 0;                                    // dm: the search must find a mate this fast
+    std::vector<std::pair<int, uint64_t>> perftCounts; // D<n>: leaf nodes at depth n
+};
+
+// Runs EPD test suites: bm, am and dm operations against the search, D1, D2, ... perft
+// counts against the move generator.
+//
+// load() maps the file and reads every record straight from the mapping, with
+// FenUtils::parse for the position and San::parse for the moves. run() hands the
+// positions to a pool of threads, each with its own Search and hash table, which take
+// the next position as soon as they finish one. Results still come back in file order.
+class EpdSuite {
+public:
+    struct Settings {
+        int threads = 1;
+        int depth = 0;             // search depth per position
+        int64_t moveTimeMs = 1000; // search time per position, when there is no depth
+        int maxPerftDepth = 0;     // D<n> above this depth are not counted; 0 counts all
+        size_t hashMb = 16;        // per thread
+    };
+
+    struct Result {
+        bool passed = false;
+        bool searched = false;
+        BoardMove bestMove;
+        int score = 0;
+        int depth = 0;
+        uint64_t nodes = 0;       // searched and counted by perft
+        int64_t timeMs = 0;
+        std::string failure;      // which operation failed, and how
+    };
+    // Called from the thread that called run(), once per record, in record order
+    using ResultCallback = std::function<void(size_t index, const EpdRecord& record, const Result& result)>;
+
+    bool load(const std::string& path);
+    // Text already in memory; one record per line
+    void parse(std::string_view text);
+    const std::vector<EpdRecord>& records() const { return suite; }
+    // "line <n>: <reason>" for every line that was skipped
+    const std::vector<std::string>& errors() const { return parseErrors; }
+
+    void run(const Settings& settings, const ResultCallback& callback) const;
+
+    // False with the reason when the position or one of the moves does not parse.
+    // Unknown opcodes are ignored, hmvc and fmvn set the move counters.
+    static bool parseRecord(std::string_view line, EpdRecord& record, std::string& error);
+    static uint64_t perft(Board& board, int depth);
+
+private:
+    std::vector<EpdRecord> suite;
+    std::vector<std::string> parseErrors;
+};
+
+#endif // EPDSUITE_H
@@ -0,0 +1,137 @@
+#include "engine/Evaluation.h"
+#include "engine/Bitbases.h"
+#include "engine/Board.h"
+
+#include <cstdlib>
+
+namespace {
+
+// Piece-square tables from White's point of view, listed from a8 to h1 as they appear on a diagram.
+const int PawnTable[64] = {
+     0,  0,  0,  0,  0,  0,  0,  0,
+    50, 50, 50, 50, 50, 50, 50, 50,
+    10, 10, 20, 30, 30, 20, 10, 10,
+     5,  5, 10, 25, 25, 10,  5,  5,
+     0,  0,  0, 20, 20,  0,  0,  0,
+     5, -5,-10,  0,  0,-10, -5,  5,
+     5, 10, 10,-20,-20, 10, 10,  5,
+     0,  0,  0,  0,  0,  0,  0,  0
+};
+
+const int KnightTable[64] = {
+    -50,-40,-30,-30,-30,-30,-40,-50,
+    -40,-20,  0,  0,  0,  0,-20,-40,
+    -30,  0, 10, 15, 15, 10,  0,-30,
+    -30,  5, 15, 20, 20, 15,  5,-30,
+    -30,  0, 15, 20, 20, 15,  0,-30,
+    -30,  5, 10, 15, 15, 10,  5,-30,
+    -40,-20,  0,  5,  5,  0,-20,-40,
+    -50,-40,-30,-30,-30,-30,-40,-50
+};
+
+const int BishopTable[64] = {
+    -20,-10,-10,-10,-10,-10,-10,-20,
+    -10,  0,  0,  0,  0,  0,  0,-10,
+    -10,  0,  5, 10, 10,  5,  0,-10,
+    -10,  5,  5, 10, 10,  5,  5,-10,
+    -10,  0, 10, 10, 10, 10,  0,-10,
+    -10, 10, 10, 10, 10, 10, 10,-10,
+    -10,  5,  0,  0,  0,  0,  5,-10,
+    -20,-10,-10,-10,-10,-10,-10,-20
+};
+
+const int RookTable[64] = {
+      0,  0,  0,  0,  0,  0,  0,  0,
+      5, 10, 10, 10, 10, 10, 10,  5,
+     -5,  0,  0,  0,  0,  0,  0, -5,
+     -5,  0,  0,  0,  0,  0,  0, -5,
+     -5,  0,  0,  0,  0,  0,  0, -5,
+     -5,  0,  0,  0,  0,  0,  0, -5,
+     -5,  0,  0,  0,  0,  0,  0, -5,
+      0,  0,  0,  5,  5,  0,  0,  0
+};
+
+const int QueenTable[64] = {
+    -20,-10,-10, -5, -5,-10,-10,-20,
+    -10,  0,  0,  0,  0,  0,  0,-10,
+    -10,  0,  5,  5,  5,  5,  0,-10,
+     -5,  0,  5,  5,  5,  5,  0, -5,
+      0,  0,  5,  5,  5,  5,  0, -5,
+    -10,  5,  5,  5,  5,  5,  0,-10,
+    -10,  0,  5,  0,  0,  0,  0,-10,
+    -20,-10,-10, -5, -5,-10,-10,-20
+};
+
+const int KingMiddlegameTable[64] = {
+    -30,-40,-40,-50,-50,-40,-40,-30,
+    -30,-40,-40,-50,-50,-40,-40,-30,
+    -30,-40,-40,-50,-50,-40,-40,-30,
+    -30,-40,-40,-50,-50,-40,-40,-30,
+    -20,-30,-30,-40,-40,-30,-30,-20,
+    -10,-20,-20,-20,-20,-20,-20,-10,
+     20, 20,  0,  0,  0,  0, 20, 20,
+     20, 30, 10,  0,  0, 10, 30, 20
+};
+
+const int KingEndgameTable[64] = {
+    -50,-40,-30,-20,-20,-30,-40,-50,
+    -30,-20,-10,  0,  0,-10,-20,-30,
+    -30,-10, 20, 30, 30, 20,-10,-30,
+    -30,-10, 30, 40, 40, 30,-10,-30,
+    -30,-10, 30, 40, 40, 30,-10,-30,
+    -30,-10, 20, 30, 30, 20,-10,-30,
+    -30,-30,  0,  0,  0,  0,-30,-30,
+    -50,-30,-30,-30,-30,-30,-30,-50
+};
+
+const int* const PieceTables[5] = { PawnTable, KnightTable, BishopTable, RookTable, QueenTable };
+
+// Game phase weights; 24 is the full starting material
+const int PhaseWeights[6] = { 0, 1, 1, 2, 4, 0 };
+constexpr int MaxPhase = 24;
+constexpr int BishopPairBonus = 30;
+constexpr int Tempo = 10;
+
+inline int tableIndex(Color c, int sq) {
+    return c == WHITE ? squareOf(7 - rowOf(sq), colOf(sq)) : sq;
+}
+
+} // namespace
+
+int Evaluation::evaluate(const Board& board) {
+    int score[2] = { 0, 0 };
+    int phase = 0;
+
+    for (Color c : { WHITE, BLACK }) {
+        for (int type = PAWN; type <= QUEEN; ++type) {
+            Bitboard bb = board.pieces(c, PieceType(type));
+            phase += PhaseWeights[type] * popCount(bb);
+            while (bb) {
+                int sq = popLsb(bb);
+                score[c] += PieceValues[type] + PieceTables[type][tableIndex(c, sq)];
+            }
+        }
+        if (popCount(board.pieces(c, BISHOP)) >= 2) score[c] += BishopPairBonus;
+    }
+    if (phase > MaxPhase) phase = MaxPhase;
+
+    // King placement is tapered between middlegame safety and endgame activity
+    int king[2] = { 0, 0 };
+    for (Color c : { WHITE, BLACK }) {
+        int index = tableIndex(c, board.kingSquare(c));
+        king[c] = (KingMiddlegameTable[index] * phase + KingEndgameTable[index] * (MaxPhase - phase)) / MaxPhase;
+    }
+
+    int total = (score[WHITE] + king[WHITE]) - (score[BLACK] + king[BLACK]);
+    return (board.sideToMove() == WHITE ? total : -total) + Tempo;
+}
+
+int Evaluation::evaluate(const Board& board, const Bitbases *bitbases) {
+    BitbaseResult result;
+    if (!bitbases || popCount(board.occupied()) > Bitbases::MAX_PIECES || !bitbases->probe(board, result)) {
+        return evaluate(board);
+    }
+    if (result == BitbaseResult::Draw) return 0;
+    const int score = KnownWin + std::abs(evaluate(board));
+    return result == BitbaseResult::Win ? score : -score;
+}
@@ -0,0 +1,24 @@
+#ifndef EVALUATION_H
+#define EVALUATION_H
+
+#include "engine/Bitboards.h"
+
+class Bitbases;
+class Board;
+
+class Evaluation {
+public:
+    static constexpr int PieceValues[7] = { 100, 320, 330, 500, 900, 0, 0 };
+
+    // Static evaluation in centipawns from the side to move's point of view
+    static int evaluate(const Board& board);
+    // The same, settled by the bitbases where they cover the position: draws are 0 and
+    // known wins keep the static score on top of KnownWin, so the search still makes progress
+    static int evaluate(const Board& board, const Bitbases *bitbases);
+
+    static constexpr int KnownWin = 2000;
+
+    static int pieceValue(PieceType type) { return PieceValues[type]; }
+};
+
+#endif // EVALUATION_H
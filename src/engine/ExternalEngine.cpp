@@ -0,0 +1,285 @@
+#include "engine/ExternalEngine.h"
+
+#include <QCoreApplication>
+#include <QFileInfo>
+#include <QTimer>
+#include <QDebug>
+
+ExternalEngine::ExternalEngine(const QString& program, const QStringList& arguments, QObject *parent)
+    : ChessEngine(parent), program(program), arguments(arguments)
+{
+    process = new QProcess(this);
+    process->setProcessChannelMode(QProcess::SeparateChannels);
+    connect(process, &QProcess::readyReadStandardOutput, this, &ExternalEngine::readOutput);
+    connect(process, &QProcess::errorOccurred, this, &ExternalEngine::handleProcessError);
+    connect(process, &QProcess::finished, this, &ExternalEngine::handleProcessFinished);
+
+    // Started from the event loop so that a failure to start reaches the caller's connections
+    QMetaObject::invokeMethod(this, &ExternalEngine::startProcess, Qt::QueuedConnection);
+}
+
+void ExternalEngine::startProcess()
+{
+    process->start(program, arguments);
+    send("uci");
+}
+
+ExternalEngine::~ExternalEngine()
+{
+    disconnect(process, nullptr, this, nullptr);
+    if (process->state() == QProcess::NotRunning) return; // deleted with this object
+
+    if (engineBusy) send("stop");
+    send("quit");
+    // Waiting here would freeze the GUI on an engine that hangs, so the process outlives
+    // this object. Under the application it is still killed when the application exits.
+    QProcess *exiting = process;
+    exiting->setParent(QCoreApplication::instance());
+    connect(exiting, &QProcess::finished, exiting, &QObject::deleteLater);
+    QTimer::singleShot(QUIT_TIMEOUT_MS, exiting, [exiting] {
+        if (exiting->state() != QProcess::NotRunning) exiting->kill();
+    });
+}
+
+QString ExternalEngine::name() const
+{
+    return engineName.isEmpty() ? QFileInfo(program).completeBaseName() : engineName;
+}
+
+void ExternalEngine::send(const QString& command)
+{
+    if (process->state() == QProcess::NotRunning) return;
+    process->write(command.toUtf8() + '\n');
+}
+
+quint64 ExternalEngine::startSearch(const Board& position, const SearchLimits& limits)
+{
+    quint64 searchId = nextSearchId++;
+    activeSearchId = searchId;
+    pending = PendingSearch{ searchId, position, limits };
+
+    // The running search has to report its best move before the engine takes a new one
+    if (engineBusy) {
+        if (!stopSent) {
+            send("stop");
+            stopSent = true;
+        }
+        return searchId;
+    }
+    dispatchPending();
+    return searchId;
+}
+
+void ExternalEngine::stop()
+{
+    if (engineBusy && runningSearchId == activeSearchId && !stopSent) {
+        send("stop");
+        stopSent = true;
+    }
+}
+
+void ExternalEngine::cancel()
+{
+    activeSearchId = 0;
+    pending.reset();
+    if (engineBusy && !stopSent) {
+        send("stop");
+        stopSent = true;
+    }
+}
+
+void ExternalEngine::ponderHit()
+{
+    if (pending && pending->searchId == activeSearchId) {
+        // Not sent yet: start it as a normal search instead
+        pending->limits.ponder = false;
+    } else if (engineBusy && runningSearchId == activeSearchId && !stopSent) {
+        send("ponderhit");
+    }
+}
+
+void ExternalEngine::clearHash()
+{
+    newGamePending = true;
+    dispatchPending();
+}
+
+bool ExternalEngine::isSearching() const
+{
+    if (activeSearchId == 0) return false;
+    return (pending && pending->searchId == activeSearchId) || (engineBusy && runningSearchId == activeSearchId);
+}
+
+void ExternalEngine::dispatchPending()
+{
+    if (!ready || engineBusy) return;
+    if (newGamePending) {
+        send("ucinewgame");
+        newGamePending = false;
+    }
+    if (!pending) return;
+    PendingSearch search = *pending;
+    pending.reset();
+    if (search.searchId != activeSearchId) return;
+
+    int multiPV = qMax(1, search.limits.multiPV);
+    if (multiPV != engineMultiPV) {
+        send(QString("setoption name MultiPV value %1").arg(multiPV));
+        engineMultiPV = multiPV;
+    }
+    send("position fen " + QString::fromStdString(search.position.toFen()));
+    send(goCommand(search.limits));
+
+    runningSearchId = search.searchId;
+    searchPosition = search.position;
+    runningResult = SearchResult();
+    engineBusy = true;
+    stopSent = false;
+}
+
+QString ExternalEngine::goCommand(const SearchLimits& limits) const
+{
+    QStringList go { "go" };
+    if (limits.ponder) go << "ponder";
+    if (limits.infinite) go << "infinite";
+    if (limits.depth > 0) go << "depth" << QString::number(limits.depth);
+    if (limits.nodes > 0) go << "nodes" << QString::number(limits.nodes);
+    if (limits.moveTimeMs > 0) go << "movetime" << QString::number(limits.moveTimeMs);
+    if (limits.timeLeftMs[WHITE] > 0 || limits.timeLeftMs[BLACK] > 0) {
+        go << "wtime" << QString::number(limits.timeLeftMs[WHITE])
+           << "btime" << QString::number(limits.timeLeftMs[BLACK])
+           << "winc" << QString::number(limits.incrementMs[WHITE])
+           << "binc" << QString::number(limits.incrementMs[BLACK]);
+        if (limits.movesToGo > 0) go << "movestogo" << QString::number(limits.movesToGo);
+    }
+    return go.join(' ');
+}
+
+void ExternalEngine::readOutput()
+{
+    while (process->canReadLine()) {
+        QString line = QString::fromUtf8(process->readLine()).trimmed();
+        if (!line.isEmpty()) handleLine(line);
+    }
+}
+
+void ExternalEngine::handleLine(const QString& line)
+{
+    QStringList tokens = line.split(' ', Qt::SkipEmptyParts);
+    const QString& command = tokens.first();
+    if (command == "info") {
+        parseInfo(tokens);
+    } else if (command == "bestmove") {
+        parseBestMove(tokens);
+    } else if (command == "id" && tokens.size() > 2 && tokens[1] == "name") {
+        engineName = tokens.mid(2).join(' ');
+    } else if (command == "uciok") {
+        ready = true;
+        qDebug() << "External engine ready:" << name();
+        dispatchPending();
+    }
+}
+
+int ExternalEngine::scoreFromMate(int movesToMate)
+{
+    // Inverse of Search::mateInMoves
+    return movesToMate > 0 ? Search::MATE_SCORE - (2 * movesToMate - 1) : -Search::MATE_SCORE + 2 * -movesToMate;
+}
+
+void ExternalEngine::parseInfo(const QStringList& tokens)
+{
+    if (runningSearchId == 0 || runningSearchId != activeSearchId) return;
+
+    SearchInfo info;
+    bool hasScore = false;
+    for (int i = 1; i < tokens.size(); ++i) {
+        const QString& key = tokens[i];
+        bool hasValue = i + 1 < tokens.size();
+        if (key == "string") {
+            return;
+        } else if (key == "depth" && hasValue) {
+            info.depth = tokens[++i].toInt();
+        } else if (key == "seldepth" && hasValue) {
+            info.selDepth = tokens[++i].toInt();
+        } else if (key == "multipv" && hasValue) {
+            info.multiPv = tokens[++i].toInt();
+        } else if (key == "score" && i + 2 < tokens.size()) {
+            QString kind = tokens[++i];
+            int value = tokens[++i].toInt();
+            info.score = kind == "mate" ? scoreFromMate(value) : value;
+            hasScore = true;
+        } else if (key == "nodes" && hasValue) {
+            info.nodes = tokens[++i].toULongLong();
+        } else if (key == "nps" && hasValue) {
+            info.nps = tokens[++i].toULongLong();
+        } else if (key == "hashfull" && hasValue) {
+            info.hashfull = tokens[++i].toInt();
+        } else if (key == "time" && hasValue) {
+            info.timeMs = tokens[++i].toLongLong();
+        } else if (key == "pv") {
+            // Keep the longest legal prefix; a broken PV must not reach the GUI
+            Board board = searchPosition;
+            for (++i; i < tokens.size(); ++i) {
+                BoardMove move = board.parseUciMove(tokens[i].toStdString());
+                if (move.isNone()) break;
+                info.pv.push_back(move);
+                board.makeMove(move);
+            }
+        }
+    }
+
+    runningResult.nodes = qMax(runningResult.nodes, info.nodes);
+    // Lines about the current move or bare node counts carry no score or PV
+    if (!hasScore || info.pv.empty()) return;
+    if (info.multiPv == 1) {
+        runningResult.depth = info.depth;
+        runningResult.score = info.score;
+    }
+    emit searchInfo(info);
+}
+
+void ExternalEngine::parseBestMove(const QStringList& tokens)
+{
+    quint64 searchId = runningSearchId;
+    engineBusy = false;
+    stopSent = false;
+    runningSearchId = 0;
+
+    if (searchId != 0 && searchId == activeSearchId) {
+        activeSearchId = 0;
+        SearchResult result = runningResult;
+        if (tokens.size() > 1) {
+            result.bestMove = searchPosition.parseUciMove(tokens[1].toStdString());
+            if (!result.bestMove.isNone() && tokens.size() > 3 && tokens[2] == "ponder") {
+                Board afterBest = searchPosition;
+                afterBest.makeMove(result.bestMove);
+                result.ponderMove = afterBest.parseUciMove(tokens[3].toStdString());
+            }
+        }
+        if (result.bestMove.isNone()) {
+            qWarning() << "External engine sent an illegal best move:" << tokens.join(' ');
+        }
+        emit bestMoveFound(result);
+    }
+    dispatchPending();
+}
+
+void ExternalEngine::handleProcessError(QProcess::ProcessError error)
+{
+    qWarning() << "External engine" << program << "error" << error << process->errorString();
+    if (error == QProcess::FailedToStart || error == QProcess::Crashed) {
+        ready = engineBusy = false;
+        pending.reset();
+        activeSearchId = runningSearchId = 0;
+        emit engineError(tr("Engine \"%1\": %2").arg(name(), process->errorString()));
+    }
+}
+
+void ExternalEngine::handleProcessFinished(int exitCode, QProcess::ExitStatus exitStatus)
+{
+    if (exitStatus == QProcess::CrashExit) return; // reported through errorOccurred
+    ready = engineBusy = false;
+    pending.reset();
+    activeSearchId = runningSearchId = 0;
+    emit engineError(tr("Engine \"%1\" exited with code %2.").arg(name()).arg(exitCode));
+}
@@ -0,0 +1,73 @@
+#ifndef EXTERNALENGINE_H
+#define EXTERNALENGINE_H
+
+#include <QProcess>
+#include <QStringList>
+#include <optional>
+#include "engine/ChessEngine.h"
+
+// Drives a UCI engine program as a subprocess. Commands are written to its stdin and
+// its output is parsed line by line as it arrives, so the GUI thread never waits on it.
+// A new search is only sent once the engine has answered the previous one with
+// "bestmove", as the protocol requires.
+class ExternalEngine : public ChessEngine
+{
+    Q_OBJECT
+
+public:
+    explicit ExternalEngine(const QString& program, const QStringList& arguments = QStringList(), QObject *parent = nullptr);
+    // Sends "quit" and returns at once; the process is killed if it has not exited
+    // QUIT_TIMEOUT_MS later, and deleted when it has
+    ~ExternalEngine() override;
+
+    QString name() const override;
+    quint64 startSearch(const Board& position, const SearchLimits& limits) override;
+    void stop() override;
+    void cancel() override;
+    void ponderHit() override;
+    void clearHash() override;
+
+    bool isSearching() const override;
+
+private slots:
+    void readOutput();
+    void handleProcessError(QProcess::ProcessError error);
+    void handleProcessFinished(int exitCode, QProcess::ExitStatus exitStatus);
+
+private:
+    struct PendingSearch {
+        quint64 searchId = 0;
+        Board position;
+        SearchLimits limits;
+    };
+
+    static constexpr int QUIT_TIMEOUT_MS = 1000;
+
+    QProcess *process = nullptr;
+    QString program;
+    QStringList arguments;
+    QString engineName;
+    bool ready = false;          // "uciok" received
+    bool engineBusy = false;     // a "go" is outstanding until its "bestmove"
+    bool stopSent = false;
+    bool newGamePending = false;
+    int engineMultiPV = 1;
+
+    std::optional<PendingSearch> pending;
+    quint64 nextSearchId = 1;
+    quint64 activeSearchId = 0;  // the search whose output is delivered
+    quint64 runningSearchId = 0; // the search the engine is working on
+    Board searchPosition;
+    SearchResult runningResult;  // depth, score and nodes of the running search so far
+
+    void startProcess();
+    void send(const QString& command);
+    void dispatchPending();
+    void handleLine(const QString& line);
+    void parseInfo(const QStringList& tokens);
+    void parseBestMove(const QStringList& tokens);
+    QString goCommand(const SearchLimits& limits) const;
+    static int scoreFromMate(int movesToMate);
+};
+
+#endif // EXTERNALENGINE_H
@@ -0,0 +1,178 @@
+#include "engine/GameCodec.h"
+
+#include <QDebug>
+#include <algorithm>
+#include <cstring>
+
+namespace {
+
+const char ARCHIVE_MAGIC[4] = { 'C', 'Q', 'G', 'A' };
+const uint8_t ARCHIVE_VERSION = 1;
+const uint8_t FLAG_FEN = 4;
+const char* const RESULTS[4] = { "*", "1-0", "0-1", "1/2-1/2" };
+
+uint8_t resultCode(std::string_view result) {
+    for (uint8_t code = 1; code < 4; ++code) {
+        if (result == RESULTS[code]) return code;
+    }
+    return 0;
+}
+
+} // namespace
+
+size_t GameCodec::encode(Board& board, const BoardMove* moves, size_t count, std::string& out) {
+    for (size_t ply = 0; ply < count; ++ply) {
+        const BoardMove move = moves[ply];
+        MoveList legal;
+        board.generateLegalMoves(legal);
+        int index = 0;
+        bool found = false;
+        for (BoardMove candidate : legal) {
+            if (candidate.raw() < move.raw()) index++;
+            else if (candidate == move) found = true;
+        }
+        if (!found) return ply;
+        out += char(index);
+        board.makeMove(move);
+    }
+    return count;
+}
+
+bool GameCodec::decode(Board& board, std::string_view bytes, std::vector<BoardMove>& moves) {
+    for (const char byte : bytes) {
+        const int index = uint8_t(byte);
+        MoveList legal;
+        board.generateLegalMoves(legal);
+        if (index >= legal.size()) return false;
+        std::nth_element(legal.begin(), legal.begin() + index, legal.end(),
+                         [](BoardMove a, BoardMove b) { return a.raw() < b.raw(); });
+        const BoardMove move = legal[index];
+        moves.push_back(move);
+        board.makeMove(move);
+    }
+    return true;
+}
+
+GameArchiveWriter::~GameArchiveWriter() {
+    close();
+}
+
+bool GameArchiveWriter::open(const std::string& path) {
+    close();
+    file.open(path, std::ios::binary | std::ios::trunc);
+    if (!file) return false;
+    bytes = 0;
+    buffer.clear();
+    buffer.reserve(WRITE_BUFFER_BYTES + 512);
+    buffer.append(ARCHIVE_MAGIC, sizeof(ARCHIVE_MAGIC));
+    buffer += char(ARCHIVE_VERSION);
+    return true;
+}
+
+bool GameArchiveWriter::add(std::string_view result, std::string_view fen, std::string_view encodedMoves) {
+    if (!file.is_open() || fen.size() > 255) return false;
+    buffer += char(resultCode(result) | (fen.empty() ? 0 : FLAG_FEN));
+    if (!fen.empty()) {
+        buffer += char(fen.size());
+        buffer.append(fen);
+    }
+    for (uint64_t plies = encodedMoves.size(); ; plies >>= 7) {
+        if (plies < 0x80) {
+            buffer += char(plies);
+            break;
+        }
+        buffer += char((plies & 0x7F) | 0x80);
+    }
+    buffer.append(encodedMoves);
+    return buffer.size() < WRITE_BUFFER_BYTES || flush();
+}
+
+bool GameArchiveWriter::close() {
+    if (!file.is_open()) return true;
+    const bool ok = flush();
+    file.close();
+    return ok && !file.fail();
+}
+
+bool GameArchiveWriter::flush() {
+    file.write(buffer.data(), std::streamsize(buffer.size()));
+    bytes += buffer.size();
+    buffer.clear();
+    return bool(file);
+}
+
+GameArchiveReader::~GameArchiveReader() {
+    close();
+}
+
+bool GameArchiveReader::open(const QString& path) {
+    close();
+    file.setFileName(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        qWarning() << "GameArchive: cannot open" << path << file.errorString();
+        return false;
+    }
+    const qint64 fileSize = file.size();
+    if (fileSize < qint64(sizeof(ARCHIVE_MAGIC) + 1)) {
+        qWarning() << "GameArchive:" << path << "is not a game archive";
+        file.close();
+        return false;
+    }
+    data = file.map(0, fileSize);
+    if (!data) {
+        qWarning() << "GameArchive: cannot map" << path << file.errorString();
+        file.close();
+        return false;
+    }
+    if (std::memcmp(data, ARCHIVE_MAGIC, sizeof(ARCHIVE_MAGIC)) != 0 || data[sizeof(ARCHIVE_MAGIC)] != ARCHIVE_VERSION) {
+        qWarning() << "GameArchive:" << path << "is not a game archive of version" << ARCHIVE_VERSION;
+        close();
+        return false;
+    }
+    size = size_t(fileSize);
+    pos = sizeof(ARCHIVE_MAGIC) + 1;
+    return true;
+}
+
+void GameArchiveReader::close() {
+    if (data) file.unmap(const_cast<uchar*>(data));
+    data = nullptr;
+    size = 0;
+    pos = 0;
+    truncated = false;
+    if (file.isOpen()) file.close();
+}
+
+bool GameArchiveReader::next(Game& game) {
+    if (!data || pos >= size) return false;
+    const char* text = reinterpret_cast<const char*>(data);
+    size_t i = pos;
+    const uint8_t flags = data[i++];
+    game.result = RESULTS[flags & 3];
+    game.fen = std::string_view();
+    if (flags & FLAG_FEN) {
+        if (i >= size || i + 1 + data[i] > size) {
+            truncated = true;
+            return false;
+        }
+        game.fen = std::string_view(text + i + 1, data[i]);
+        i += 1 + data[i];
+    }
+    uint64_t plies = 0;
+    for (int shift = 0; ; shift += 7) {
+        if (i >= size || shift > 56) {
+            truncated = true;
+            return false;
+        }
+        const uint8_t byte = data[i++];
+        plies |= uint64_t(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) break;
+    }
+    if (plies > size - i) {
+        truncated = true;
+        return false;
+    }
+    game.moves = std::string_view(text + i, size_t(plies));
+    pos = i + size_t(plies);
+    return true;
+}
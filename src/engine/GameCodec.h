@@ -0,0 +1,78 @@
+#ifndef GAMECODEC_H
+#define GAMECODEC_H
+
+#include <QFile>
+#include <QString>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "engine/Board.h"
+
+// Games as one byte per ply: the index of the move among the legal moves of its
+// position, ordered by their 16-bit encoding. The order depends only on the position,
+// not on the move generator, and no position has more than 218 legal moves. Finding
+// the index, and the move for an index, is a pass over the legal moves without sorting.
+class GameCodec {
+public:
+    // Both play the board forward through the moves. encode() appends one byte per move
+    // to out and returns how many moves it encoded, stopping before the first one that
+    // is not legal. decode() appends the moves and is false at a byte that is no legal
+    // move's index, with the board at the position before it.
+    static size_t encode(Board& board, const BoardMove* moves, size_t count, std::string& out);
+    static bool decode(Board& board, std::string_view bytes, std::vector<BoardMove>& moves);
+};
+
+// A file of encoded games: the magic "CQGA" and a version byte, then for each game a
+// flags byte (the result in the low two bits, 4 when a FEN follows), the FEN as a length
+// byte and the text, the ply count as a LEB128 varint and the encoded plies.
+class GameArchiveWriter {
+public:
+    ~GameArchiveWriter();
+
+    bool open(const std::string& path);
+    // result is "1-0", "0-1", "1/2-1/2" or anything else for an unfinished game; an
+    // empty fen is the standard starting position
+    bool add(std::string_view result, std::string_view fen, std::string_view encodedMoves);
+    bool close();
+    uint64_t bytesWritten() const { return bytes; }
+
+private:
+    static constexpr size_t WRITE_BUFFER_BYTES = 1 << 16;
+
+    std::ofstream file;
+    std::string buffer;
+    uint64_t bytes = 0;
+
+    bool flush();
+};
+
+// Reads an archive through a memory mapping; the views in Game point into it
+class GameArchiveReader {
+public:
+    struct Game {
+        std::string_view result;
+        std::string_view fen;    // empty for the standard starting position
+        std::string_view moves;  // for GameCodec::decode
+    };
+
+    GameArchiveReader() = default;
+    ~GameArchiveReader();
+
+    bool open(const QString& path);
+    void close();
+    // False at the end of the archive, or at a game cut short (then failed() is true)
+    bool next(Game& game);
+    bool failed() const { return truncated; }
+
+private:
+    QFile file;
+    const uchar *data = nullptr;
+    size_t size = 0;
+    size_t pos = 0;
+    bool truncated = false;
+};
+
+#endif // GAMECODEC_H
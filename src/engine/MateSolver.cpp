@@ -0,0 +1,262 @@
+#include "engine/MateSolver.h"
+
+#include <algorithm>
+
+MateSolver::MateSolver(size_t megabytes) {
+    resize(megabytes);
+}
+
+void MateSolver::resize(size_t mb) {
+    if (mb < 1) mb = 1;
+    // A power of two, so the bucket index is a mask
+    size_t count = BUCKET_SIZE;
+    while (count * 2 * sizeof(Entry) <= mb * 1024 * 1024) count *= 2;
+    entryCount = count;
+    table.clear();
+    table.shrink_to_fit();
+}
+
+void MateSolver::clear() {
+    std::fill(table.begin(), table.end(), Entry());
+}
+
+// The same position is a different node for every number of attacker moves left,
+// and for the other side attacking
+uint64_t MateSolver::nodeKey(int movesLeft) const {
+    uint64_t key = board.key() ^ (uint64_t(movesLeft + 1) * 0x9E3779B97F4A7C15ULL);
+    return attacker == WHITE ? key : key ^ 0xD1B54A32D192ED03ULL;
+}
+
+bool MateSolver::lookup(uint64_t key, Numbers& numbers) const {
+    const Entry *bucket = &table[key & (entryCount - BUCKET_SIZE)];
+    for (int i = 0; i < BUCKET_SIZE; ++i) {
+        if (bucket[i].key == key) {
+            numbers.phi = bucket[i].phi;
+            numbers.delta = bucket[i].delta;
+            numbers.distance = bucket[i].distance;
+            return true;
+        }
+    }
+    return false;
+}
+
+void MateSolver::store(uint64_t key, const Numbers& numbers, uint64_t work) {
+    // Settled entries are the last to go, then the ones that took the most work
+    auto keepValue = [](const Entry& e) {
+        if (e.key == 0) return uint64_t(0);
+        return uint64_t(e.work) + (e.phi == 0 || e.delta == 0 ? uint64_t(UINT32_MAX) + 1 : 0);
+    };
+    Entry *bucket = &table[key & (entryCount - BUCKET_SIZE)];
+    Entry *slot = bucket;
+    for (int i = 0; i < BUCKET_SIZE; ++i) {
+        if (bucket[i].key == key) {
+            slot = &bucket[i];
+            break;
+        }
+        if (keepValue(bucket[i]) < keepValue(*slot)) slot = &bucket[i];
+    }
+    slot->key = key;
+    slot->phi = numbers.phi;
+    slot->delta = numbers.delta;
+    slot->work = uint32_t(std::min<uint64_t>(work, UINT32_MAX));
+    slot->distance = uint16_t(numbers.distance);
+}
+
+void MateSolver::checkLimits() {
+    if (stopRequested.load(std::memory_order_relaxed)
+        || (limits.maxNodes > 0 && nodes >= limits.maxNodes)
+        || (limits.moveTimeMs > 0
+            && std::chrono::duration_cast<std::chrono::milliseconds>(Clock::now() - startTime).count() >= limits.moveTimeMs)) {
+        aborted = true;
+    }
+}
+
+MateSolver::Result MateSolver::solve(const Board& position, const Limits& searchLimits) {
+    if (table.size() != entryCount) table.assign(entryCount, Entry());
+    board = position;
+    attacker = position.sideToMove();
+    limits = searchLimits;
+    startTime = Clock::now();
+    nodes = 0;
+    aborted = false;
+
+    Result result;
+    Numbers root;
+    if (prove(limits.maxMoves, root)) {
+        // The proof already follows the quickest mates it found; a shorter one that it
+        // missed has to be proven with fewer moves allowed
+        int provenWith = limits.maxMoves;
+        result.status = Status::Mate;
+        result.mateIn = (root.distance + 1) / 2;
+        while (limits.shortest && result.mateIn > 1 && prove(result.mateIn - 1, root)) {
+            provenWith = result.mateIn - 1;
+            result.mateIn = (root.distance + 1) / 2;
+        }
+        // A limit hit while shortening still leaves a proven mate; its line is mostly in
+        // the table already
+        const bool interrupted = aborted;
+        aborted = false;
+        buildLine(provenWith, result.line);
+        if (aborted) result.line.clear();
+        aborted |= interrupted;
+    } else if (!aborted) {
+        result.status = Status::NoMate;
+    }
+    result.nodes = nodes;
+    result.timeMs = std::chrono::duration_cast<std::chrono::milliseconds>(Clock::now() - startTime).count();
+    return result;
+}
+
+bool MateSolver::prove(int movesLeft, Numbers& numbers) {
+    const uint64_t key = nodeKey(movesLeft);
+    if (!lookup(key, numbers) || (numbers.phi != 0 && numbers.delta != 0)) {
+        mid(movesLeft, INF, INF);
+        if (aborted || !lookup(key, numbers)) return false;
+    }
+    // Proven for the attacker: phi is 0 on its own move, delta on the defender's
+    return board.sideToMove() == attacker ? numbers.phi == 0 : numbers.delta == 0;
+}
+
+// Multiple iterative deepening: expands the current node until its proof or disproof
+// number reaches the threshold. With phi/delta taken from the side to move, a node's
+// phi is the smallest delta of its children and its delta the sum of their phis.
+void MateSolver::mid(int movesLeft, uint32_t thresholdPhi, uint32_t thresholdDelta) {
+    if ((++nodes & 1023) == 0) checkLimits();
+    if (aborted) return;
+
+    const uint64_t key = nodeKey(movesLeft);
+    const uint64_t nodesBefore = nodes;
+    const bool attacking = board.sideToMove() == attacker;
+    Numbers won;
+    won.phi = 0;
+    won.delta = INF;
+    Numbers lost;
+    lost.phi = INF;
+    lost.delta = 0;
+
+    MoveList moves;
+    board.generateLegalMoves(moves);
+    if (moves.empty()) {
+        // Mate loses for whoever is to move; stalemate only saves the defender
+        store(key, attacking || board.inCheck() ? lost : won, 1);
+        return;
+    }
+    if (!attacking && movesLeft == 0) {
+        store(key, won, 1); // the defender survives the last attacking move
+        return;
+    }
+
+    // With one move left only a check can mate
+    MoveList children;
+    for (BoardMove move : moves) {
+        if (!attacking || movesLeft > 1 || board.givesCheck(move)) children.add(move);
+    }
+    if (children.empty()) {
+        store(key, lost, 1);
+        return;
+    }
+
+    // Unexplored replies to an attacking move start with one proof number per legal
+    // reply, so forcing moves are tried first (df-pn+); replies to a defence start at 1
+    const int childMovesLeft = attacking ? movesLeft - 1 : movesLeft;
+    uint64_t childKeys[256];
+    uint32_t initialDelta[256];
+    for (int i = 0; i < children.size(); ++i) {
+        board.makeMove(children[i]);
+        childKeys[i] = nodeKey(childMovesLeft);
+        initialDelta[i] = 1;
+        Numbers child;
+        if (attacking && !lookup(childKeys[i], child)) {
+            MoveList replies;
+            board.generateLegalMoves(replies);
+            if (replies.empty()) store(childKeys[i], board.inCheck() ? lost : won, 1);
+            initialDelta[i] = uint32_t(std::max(1, replies.size()));
+        }
+        board.unmakeMove();
+    }
+
+    while (true) {
+        Numbers node;
+        node.phi = INF;
+        uint64_t deltaSum = 0;
+        bool settled = false;
+        int best = 0;
+        uint32_t bestPhi = 1;
+        uint32_t secondDelta = INF;
+        int quickestWin = INF;
+        int slowestLoss = 0;
+        for (int i = 0; i < children.size(); ++i) {
+            Numbers child;
+            child.delta = initialDelta[i];
+            lookup(childKeys[i], child);
+            deltaSum += child.phi;
+            settled |= child.phi >= INF;
+            if (child.delta == 0) quickestWin = std::min(quickestWin, child.distance + 1);
+            slowestLoss = std::max(slowestLoss, child.distance + 1);
+            if (child.delta < node.phi) {
+                secondDelta = node.phi;
+                node.phi = child.delta;
+                best = i;
+                bestPhi = child.phi;
+            } else if (child.delta < secondDelta) {
+                secondDelta = child.delta;
+            }
+        }
+        // Only a child that fails for its mover settles the node; a large sum is not a proof
+        node.delta = settled ? INF : uint32_t(std::min<uint64_t>(deltaSum, INF - 1));
+        // The attacker mates by its quickest proven move, the defender by its slowest reply
+        if (node.phi == 0) node.distance = quickestWin;
+        else if (node.delta == 0) node.distance = slowestLoss;
+
+        if (node.phi >= thresholdPhi || node.delta >= thresholdDelta || aborted) {
+            store(key, node, nodes - nodesBefore + 1);
+            return;
+        }
+
+        const uint64_t childThresholdPhi = std::min<uint64_t>(uint64_t(thresholdDelta) + bestPhi - node.delta, INF);
+        const uint64_t childThresholdDelta = std::min<uint64_t>(thresholdPhi, uint64_t(secondDelta) + 1);
+        board.makeMove(children[best]);
+        mid(childMovesLeft, uint32_t(childThresholdPhi), uint32_t(childThresholdDelta));
+        board.unmakeMove();
+    }
+}
+
+// Follows the proof through the table: the attacker plays its quickest proven mate,
+// the defender the reply that holds out longest. Whatever the table has lost on the
+// way is proven again.
+void MateSolver::buildLine(int movesLeft, std::vector<BoardMove>& line) {
+    int played = 0;
+    while (!aborted) {
+        MoveList moves;
+        board.generateLegalMoves(moves);
+        const bool attacking = board.sideToMove() == attacker;
+        if (moves.empty() || (attacking && movesLeft == 0)) break;
+
+        const int childMovesLeft = attacking ? movesLeft - 1 : movesLeft;
+        BoardMove chosen = BoardMove::none();
+        int chosenDistance = 0;
+        // The attacker only searches again when no proven move is left in the table;
+        // every defence has to be proven to find the longest
+        for (int pass = attacking ? 0 : 1; pass < 2 && chosen.isNone() && !aborted; ++pass) {
+            for (BoardMove move : moves) {
+                board.makeMove(move);
+                Numbers child;
+                bool proven = lookup(nodeKey(childMovesLeft), child)
+                              && (attacking ? child.delta == 0 : child.phi == 0);
+                if (!proven && pass == 1) proven = prove(childMovesLeft, child);
+                board.unmakeMove();
+                if (!proven) continue;
+                if (chosen.isNone() || (attacking ? child.distance < chosenDistance : child.distance > chosenDistance)) {
+                    chosen = move;
+                    chosenDistance = child.distance;
+                }
+            }
+        }
+        if (chosen.isNone()) break;
+        board.makeMove(chosen);
+        line.push_back(chosen);
+        played++;
+        movesLeft = childMovesLeft;
+    }
+    while (played-- > 0) board.unmakeMove();
+}
@@ -0,0 +1,103 @@
+#ifndef MATESOLVER_H
+#define MATESOLVER_H
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "engine/Board.h"
+
+// Finds forced mates with depth-first proof-number search (df-pn).
+//
+// The side to move attacks; a node is proven when every defence runs into mate and
+// disproven when one defence escapes. Each node carries a proof number and a
+// disproof number (the number of leaves still to settle either way), and the search
+// always expands the most proving child while its numbers stay under thresholds
+// handed down from the parent, the way df-pn turns best-first proof-number search
+// into a depth-first one that only keeps a hash table.
+//
+// The search proves a mate within the allowed number of moves and keeps the distance
+// to mate of every proven node, so the reported mate is the quickest the proof found;
+// asked for the shortest, it proves shorter ones until one fails. The allowed number
+// of attacker moves is part of every table key, which also keeps repetitions out of
+// the proof.
+// The table has a fixed size and keeps the entries that took the most work.
+class MateSolver {
+public:
+    struct Limits {
+        int maxMoves = 5;         // longest mate to look for, in moves of the attacker
+        uint64_t maxNodes = 0;    // 0 for no limit
+        int64_t moveTimeMs = 0;   // 0 for no limit
+        bool shortest = false;    // true proves that no shorter mate was missed
+    };
+
+    enum class Status { Mate, NoMate, Unknown }; // NoMate: none within maxMoves
+
+    struct Result {
+        Status status = Status::Unknown;
+        int mateIn = 0;                 // moves of the attacker
+        std::vector<BoardMove> line;    // attacker and defender moves up to the mate
+        uint64_t nodes = 0;
+        int64_t timeMs = 0;
+    };
+
+    explicit MateSolver(size_t megabytes = 16);
+    MateSolver(const MateSolver&) = delete;
+    MateSolver& operator=(const MateSolver&) = delete;
+
+    // The table is allocated on the first solve
+    void resize(size_t megabytes);
+    void clear();
+
+    // Call clearStop() before handing solve() to another thread
+    Result solve(const Board& position, const Limits& limits);
+    // Safe to call from another thread; the running solve returns what it has proven
+    void stop() { stopRequested.store(true, std::memory_order_relaxed); }
+    void clearStop() { stopRequested.store(false, std::memory_order_relaxed); }
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    // Proof and disproof number from the side to move's point of view: phi is 0 when
+    // it wins and delta is 0 when it fails
+    struct Numbers {
+        uint32_t phi = 1;
+        uint32_t delta = 1;
+        int distance = 0;   // plies to mate, once proven for the attacker
+    };
+
+    struct Entry {
+        uint64_t key = 0;
+        uint32_t phi = 0;
+        uint32_t delta = 0;
+        uint32_t work = 0;  // nodes spent below this entry, for replacement
+        uint16_t distance = 0;
+    };
+
+    static constexpr uint32_t INF = 1u << 30;
+    static constexpr int BUCKET_SIZE = 4;
+
+    std::vector<Entry> table;
+    size_t entryCount = 0;
+    std::atomic<bool> stopRequested { false };
+
+    Board board;
+    Color attacker = WHITE;
+    Limits limits;
+    Clock::time_point startTime;
+    uint64_t nodes = 0;
+    bool aborted = false;
+
+    uint64_t nodeKey(int movesLeft) const;
+    bool lookup(uint64_t key, Numbers& numbers) const;
+    void store(uint64_t key, const Numbers& numbers, uint64_t work);
+    void checkLimits();
+
+    void mid(int movesLeft, uint32_t thresholdPhi, uint32_t thresholdDelta);
+    // Runs mid() to the end and reports whether the attacker mates in time
+    bool prove(int movesLeft, Numbers& numbers);
+    void buildLine(int movesLeft, std::vector<BoardMove>& line);
+};
+
+#endif // MATESOLVER_H
@@ -0,0 +1,132 @@
+#include "engine/OpeningBook.h"
+#include "engine/PolyglotRandom.h"
+
+#include <QtEndian>
+#include <QDebug>
+#include <algorithm>
+
+OpeningBook::~OpeningBook() {
+    close();
+}
+
+bool OpeningBook::open(const QString& path) {
+    close();
+    file.setFileName(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        qWarning() << "OpeningBook: cannot open" << path << file.errorString();
+        return false;
+    }
+    qint64 size = file.size();
+    if (size <= 0 || size % ENTRY_SIZE != 0) {
+        qWarning() << "OpeningBook:" << path << "is not a Polyglot book (size" << size << ")";
+        file.close();
+        return false;
+    }
+    data = file.map(0, size);
+    if (!data) {
+        qWarning() << "OpeningBook: cannot map" << path << file.errorString();
+        file.close();
+        return false;
+    }
+    count = size_t(size / ENTRY_SIZE);
+    qDebug() << "Opening book" << path << "mapped," << count << "entries";
+    return true;
+}
+
+void OpeningBook::close() {
+    if (data) file.unmap(const_cast<uchar*>(data));
+    data = nullptr;
+    count = 0;
+    if (file.isOpen()) file.close();
+}
+
+uint64_t OpeningBook::keyAt(size_t index) const {
+    return qFromBigEndian<quint64>(data + index * ENTRY_SIZE);
+}
+
+std::vector<BookMove> OpeningBook::lookup(const Board& board) const {
+    std::vector<BookMove> moves;
+    if (!data) return moves;
+
+    // Binary search for the first entry with the key
+    const uint64_t target = key(board);
+    size_t low = 0, high = count;
+    while (low < high) {
+        size_t mid = low + (high - low) / 2;
+        if (keyAt(mid) < target) low = mid + 1;
+        else high = mid;
+    }
+
+    for (size_t i = low; i < count && keyAt(i) == target; ++i) {
+        const uchar *entry = data + i * ENTRY_SIZE;
+        BoardMove move = decodeMove(board, qFromBigEndian<quint16>(entry + 8));
+        // A key collision or a damaged entry can yield a move that is not legal here
+        if (move.isNone()) continue;
+        moves.push_back({ move, qFromBigEndian<quint16>(entry + 10) });
+    }
+    std::stable_sort(moves.begin(), moves.end(),
+                     [](const BookMove& a, const BookMove& b) { return a.weight > b.weight; });
+    return moves;
+}
+
+BoardMove OpeningBook::pickMove(const Board& board) {
+    std::vector<BookMove> moves = lookup(board);
+    if (moves.empty()) return BoardMove::none();
+
+    int total = 0;
+    for (const BookMove& entry : moves) total += entry.weight;
+    // All weights zero: every listed move is equally good
+    if (total == 0) return moves[std::uniform_int_distribution<size_t>(0, moves.size() - 1)(rng)].move;
+
+    int pick = std::uniform_int_distribution<int>(0, total - 1)(rng);
+    for (const BookMove& entry : moves) {
+        if (pick < entry.weight) return entry.move;
+        pick -= entry.weight;
+    }
+    return moves.front().move;
+}
+
+uint64_t OpeningBook::key(const Board& board) {
+    uint64_t hash = 0;
+    Bitboard occupied = board.occupied();
+    while (occupied) {
+        int sq = popLsb(occupied);
+        int piece = board.pieceAt(sq);
+        int kind = 2 * pieceType(piece) + (pieceColor(piece) == WHITE ? 1 : 0);
+        hash ^= PolyglotRandom::value(PolyglotRandom::PIECE_OFFSET + 64 * kind + sq);
+    }
+
+    const int rights = board.castlingRights();
+    const int castleBits[4] = { WHITE_KINGSIDE, WHITE_QUEENSIDE, BLACK_KINGSIDE, BLACK_QUEENSIDE };
+    for (int i = 0; i < 4; ++i) {
+        if (rights & castleBits[i]) hash ^= PolyglotRandom::value(PolyglotRandom::CASTLE_OFFSET + i);
+    }
+
+    // Polyglot hashes the en-passant file only when a pawn stands ready to capture, which is
+    // exactly when the board records an en-passant square
+    if (board.enPassantSquare() != NO_SQUARE) {
+        hash ^= PolyglotRandom::value(PolyglotRandom::EN_PASSANT_OFFSET + colOf(board.enPassantSquare()));
+    }
+    if (board.sideToMove() == WHITE) hash ^= PolyglotRandom::value(PolyglotRandom::TURN_OFFSET);
+    return hash;
+}
+
+uint16_t OpeningBook::encodeMove(BoardMove move) {
+    int from = move.from();
+    int to = move.to();
+    // Polyglot writes castling as the king taking its own rook
+    if (move.flag() == BoardMove::KING_CASTLE) to = squareOf(rowOf(from), 7);
+    else if (move.flag() == BoardMove::QUEEN_CASTLE) to = squareOf(rowOf(from), 0);
+
+    int promotion = move.isPromotion() ? move.promotionType() - KNIGHT + 1 : 0;
+    return uint16_t(colOf(to) | (rowOf(to) << 3) | (colOf(from) << 6) | (rowOf(from) << 9) | (promotion << 12));
+}
+
+BoardMove OpeningBook::decodeMove(const Board& board, uint16_t bookMove) {
+    MoveList legal;
+    board.generateLegalMoves(legal);
+    for (BoardMove move : legal) {
+        if (encodeMove(move) == bookMove) return move;
+    }
+    return BoardMove::none();
+}
@@ -0,0 +1,52 @@
+#ifndef OPENINGBOOK_H
+#define OPENINGBOOK_H
+
+#include <QFile>
+#include <QString>
+#include <cstdint>
+#include <random>
+#include <vector>
+#include "engine/Board.h"
+
+struct BookMove {
+    BoardMove move;
+    int weight = 0;
+};
+
+// Read-only Polyglot (.bin) opening book. The file is memory-mapped when opened, so
+// opening costs no more than a map call and pages are read only when a lookup
+// touches them. Entries are 16 bytes, big-endian and sorted by key:
+// key (8), move (2), weight (2), learn (4).
+class OpeningBook {
+public:
+    static constexpr int ENTRY_SIZE = 16;
+
+    OpeningBook() = default;
+    ~OpeningBook();
+
+    bool open(const QString& path);
+    void close();
+    bool isOpen() const { return data != nullptr; }
+    QString fileName() const { return file.fileName(); }
+    size_t entryCount() const { return count; }
+
+    // All book moves for the position that are legal in it, best weighted first
+    std::vector<BookMove> lookup(const Board& board) const;
+    // A book move chosen at random in proportion to its weight; none when out of book
+    BoardMove pickMove(const Board& board);
+
+    // Polyglot hash key and move encoding
+    static uint64_t key(const Board& board);
+    static uint16_t encodeMove(BoardMove move);
+    static BoardMove decodeMove(const Board& board, uint16_t bookMove);
+
+private:
+    QFile file;
+    const uchar *data = nullptr;
+    size_t count = 0;
+    std::mt19937 rng { std::random_device{}() };
+
+    uint64_t keyAt(size_t index) const;
+};
+
+#endif // OPENINGBOOK_H
@@ -0,0 +1,236 @@
+#include "engine/San.h"
+
+#include <algorithm>
+#include <cstdio>
+
+namespace {
+
+PieceType pieceFromLetter(char c) {
+    switch (c) {
+        case 'N': return KNIGHT;
+        case 'B': return BISHOP;
+        case 'R': return ROOK;
+        case 'Q': return QUEEN;
+        case 'K': return KING;
+        default: return NO_PIECE_TYPE;
+    }
+}
+
+const char PieceLetters[] = "PNBRQK";
+
+bool isFile(char c) { return c >= 'a' && c <= 'h'; }
+bool isRank(char c) { return c >= '1' && c <= '8'; }
+
+// The move without its check or mate suffix; returns the end of the text
+char* writeMoveText(const Board& board, BoardMove move, char* p) {
+    const int from = move.from();
+    const int to = move.to();
+    if (move.isCastle()) {
+        const std::string_view castle = move.flag() == BoardMove::KING_CASTLE ? "O-O" : "O-O-O";
+        p = std::copy(castle.begin(), castle.end(), p);
+    } else {
+        const PieceType type = pieceType(board.pieceAt(from));
+        if (type == PAWN) {
+            if (move.isCapture()) *p++ = char('a' + colOf(from));
+        } else {
+            *p++ = PieceLetters[type];
+            // Other pieces of the kind that could legally go to the same square
+            Bitboard others = Bitboards::attacks(type, to, board.occupied())
+                              & board.pieces(board.sideToMove(), type) & ~squareBB(from);
+            bool sameFile = false;
+            bool sameRank = false;
+            bool ambiguous = false;
+            while (others) {
+                const int other = popLsb(others);
+                if (!board.isLegal(BoardMove(other, to, move.flag()))) continue;
+                ambiguous = true;
+                sameFile |= colOf(other) == colOf(from);
+                sameRank |= rowOf(other) == rowOf(from);
+            }
+            if (ambiguous && (!sameFile || sameRank)) *p++ = char('a' + colOf(from));
+            if (sameFile) *p++ = char('1' + rowOf(from));
+        }
+        if (move.isCapture()) *p++ = 'x';
+        *p++ = char('a' + colOf(to));
+        *p++ = char('1' + rowOf(to));
+        if (move.isPromotion()) {
+            *p++ = '=';
+            *p++ = PieceLetters[move.promotionType()];
+        }
+    }
+    return p;
+}
+
+} // namespace
+
+SanError San::parse(const Board& board, std::string_view token, BoardMove& move) {
+    move = BoardMove::none();
+    while (!token.empty() && (token.back() == '+' || token.back() == '#' || token.back() == '!' || token.back() == '?')) {
+        token.remove_suffix(1);
+    }
+    if (token.empty()) return SanError::Syntax;
+
+    if (token[0] == 'O' || token[0] == '0') {
+        const char c = token[0];
+        int flag;
+        if (token.size() == 3 && token[1] == '-' && token[2] == c) {
+            flag = BoardMove::KING_CASTLE;
+        } else if (token.size() == 5 && token[1] == '-' && token[2] == c && token[3] == '-' && token[4] == c) {
+            flag = BoardMove::QUEEN_CASTLE;
+        } else {
+            return SanError::Syntax;
+        }
+        // Rare enough that the generator's castling checks are not worth repeating here
+        MoveList legal;
+        board.generateLegalMoves(legal);
+        for (BoardMove candidate : legal) {
+            if (candidate.flag() == flag) {
+                move = candidate;
+                return SanError::None;
+            }
+        }
+        return SanError::Castling;
+    }
+
+    // Read from both ends: piece letter, promotion and destination are at fixed places,
+    // what is left in between is the capture mark and the disambiguation
+    const char* p = token.data();
+    const char* last = p + token.size();
+    PieceType type = pieceFromLetter(*p);
+    if (type == NO_PIECE_TYPE) type = PAWN;
+    else ++p;
+
+    PieceType promotion = NO_PIECE_TYPE;
+    if (last - p >= 2 && last[-2] == '=') {
+        promotion = pieceFromLetter(last[-1]);
+        if (type != PAWN || promotion == NO_PIECE_TYPE || promotion == KING) return SanError::Syntax;
+        last -= 2;
+    } else if (type == PAWN && last - p >= 3 && pieceFromLetter(last[-1]) != NO_PIECE_TYPE) {
+        promotion = pieceFromLetter(last[-1]);
+        if (promotion == KING) return SanError::Syntax;
+        --last;
+    }
+
+    if (last - p < 2 || !isFile(last[-2]) || !isRank(last[-1])) return SanError::Syntax;
+    const int to = squareOf(last[-1] - '1', last[-2] - 'a');
+    last -= 2;
+    if (last > p && last[-1] == 'x') --last;
+
+    Bitboard fromMask = ~Bitboard(0);
+    int fromFile = -1;
+    if (p < last && isFile(*p)) {
+        fromFile = *p - 'a';
+        fromMask &= Bitboards::FILE_A << fromFile;
+        ++p;
+    }
+    if (p < last && isRank(*p)) {
+        fromMask &= Bitboards::RANK_1 << (8 * (*p - '1'));
+        ++p;
+    }
+    if (p != last) return SanError::Syntax;
+
+    const Color us = board.sideToMove();
+    const Bitboard target = squareBB(to);
+    const Bitboard enemies = board.pieces(!us);
+    if (board.pieces(us) & target) return SanError::NoPiece;
+
+    Bitboard sources = 0;
+    int flag = (enemies & target) ? BoardMove::CAPTURE : BoardMove::QUIET;
+    if (type == PAWN) {
+        const bool lastRank = rowOf(to) == (us == WHITE ? 7 : 0);
+        if (lastRank && promotion == NO_PIECE_TYPE) return SanError::MissingPromotion;
+        if (!lastRank && promotion != NO_PIECE_TYPE) return SanError::UnexpectedPromotion;
+
+        const Bitboard pawns = board.pieces(us, PAWN) & fromMask;
+        if (fromFile >= 0 && fromFile != colOf(to)) {
+            // A capture: the pawns that attack the square, taking a piece or en passant
+            if (to == board.enPassantSquare()) flag = BoardMove::EN_PASSANT;
+            else if (!(enemies & target)) return SanError::NoPiece;
+            sources = Bitboards::pawnAttacks(!us, to) & pawns;
+        } else if (!(board.occupied() & target)) {
+            const int behind = us == WHITE ? to - 8 : to + 8;
+            if (behind >= 0 && behind < 64) {
+                if (pawns & squareBB(behind)) {
+                    sources = squareBB(behind);
+                } else if (!(board.occupied() & squareBB(behind)) && rowOf(to) == (us == WHITE ? 3 : 4)) {
+                    sources = pawns & squareBB(us == WHITE ? to - 16 : to + 16);
+                    flag = BoardMove::DOUBLE_PUSH;
+                }
+            }
+        }
+        if (promotion != NO_PIECE_TYPE) {
+            flag = (flag == BoardMove::CAPTURE ? BoardMove::PROMOTION_CAPTURE : BoardMove::PROMOTION) + promotion - KNIGHT;
+        }
+    } else {
+        // Piece attacks are symmetric, so the pieces that reach the square are the ones
+        // it would attack as that piece
+        sources = Bitboards::attacks(type, to, board.occupied()) & board.pieces(us, type) & fromMask;
+    }
+    if (!sources) return SanError::NoPiece;
+
+    int legalCount = 0;
+    while (sources) {
+        BoardMove candidate(popLsb(sources), to, flag);
+        if (board.isLegal(candidate)) {
+            move = candidate;
+            legalCount++;
+        }
+    }
+    if (legalCount == 1) return SanError::None;
+    move = BoardMove::none();
+    return legalCount == 0 ? SanError::KingInCheck : SanError::Ambiguous;
+}
+
+const char* San::errorMessage(SanError error) {
+    switch (error) {
+        case SanError::None: return "no error";
+        case SanError::Syntax: return "not a move in standard algebraic notation";
+        case SanError::NoPiece: return "no piece of that kind can move to the square";
+        case SanError::Ambiguous: return "more than one piece can make the move";
+        case SanError::KingInCheck: return "the move would leave the king in check";
+        case SanError::MissingPromotion: return "a pawn reaching the last rank needs a promotion piece";
+        case SanError::UnexpectedPromotion: return "promotion on a move that does not reach the last rank";
+        case SanError::Castling: return "castling is not legal here";
+    }
+    return "unknown error";
+}
+
+size_t San::write(Board& board, BoardMove move, char (&out)[SAN_BUFFER_SIZE]) {
+    char* p = writeMoveText(board, move, out);
+    if (board.givesCheck(move)) {
+        board.makeMove(move);
+        MoveList replies;
+        board.generateLegalMoves(replies);
+        board.unmakeMove();
+        *p++ = replies.empty() ? '#' : '+';
+    }
+    *p = '\0';
+    return size_t(p - out);
+}
+
+size_t San::writeMoves(const Board& start, const BoardMove* moves, size_t count, std::string& out) {
+    Board board = start;
+    // The legal moves after each move both check the next one and tell check from mate
+    MoveList legal;
+    board.generateLegalMoves(legal);
+    char text[SAN_BUFFER_SIZE + 16];
+    int moveNumber = start.fullmoveNumber();
+    for (size_t i = 0; i < count; ++i) {
+        const BoardMove move = moves[i];
+        if (std::find(legal.begin(), legal.end(), move) == legal.end()) return i;
+
+        char* p = text;
+        if (i > 0) *p++ = ' ';
+        if (board.sideToMove() == WHITE || i == 0) {
+            p += std::snprintf(p, 16, board.sideToMove() == WHITE ? "%d. " : "%d... ", moveNumber);
+        }
+        p = writeMoveText(board, move, p);
+        if (board.sideToMove() == BLACK) moveNumber++;
+        board.makeMove(move);
+        legal.count = 0;
+        board.generateLegalMoves(legal);
+        if (board.inCheck()) *p++ = legal.empty() ? '#' : '+';
+        out.append(text, size_t(p - text));
+    }
+    return count;
+}
@@ -0,0 +1,44 @@
+#ifndef SAN_H
+#define SAN_H
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include "engine/Board.h"
+
+enum class SanError {
+    None,
+    Syntax,            // not a move in standard algebraic notation
+    NoPiece,           // no piece of that kind can move to the square
+    Ambiguous,         // more than one piece fits; the move needs a file or rank
+    KingInCheck,       // the only pieces that fit would leave their king in check
+    MissingPromotion,  // a pawn reaches the last rank without a promotion piece
+    UnexpectedPromotion,
+    Castling           // castling that side is not legal here
+};
+
+// Standard algebraic notation for engine moves
+class San {
+public:
+    // The longest move, "Qa1xb2#" or "exd8=Q+", and the terminating null
+    static constexpr size_t SAN_BUFFER_SIZE = 8;
+
+    // Finds the legal move meant by token, such as "Nbd7", "exd6", "O-O-O" or "e8=N+",
+    // without generating the move list. Check and annotation suffixes ("+", "#", "!",
+    // "?") are accepted without being verified, as are "0-0", a promotion without '='
+    // and a missing or superfluous 'x'.
+    static SanError parse(const Board& board, std::string_view token, BoardMove& move);
+    static const char* errorMessage(SanError error);
+
+    // Writes a legal move as a null-terminated token with its check or mate suffix and
+    // returns the length. Only pieces that can legally make the same move count for the
+    // disambiguation. The suffix comes from playing the move, so the board is taken by
+    // reference, but it is left as it was.
+    static size_t write(Board& board, BoardMove move, char (&out)[SAN_BUFFER_SIZE]);
+    // Appends the move text of a game or line played from start, numbered as in PGN:
+    // "1. e4 e5 2. Nf3", or "5... Nc6 6. Bb5" when Black moves first. Stops before the
+    // first move that is not legal and returns how many were written.
+    static size_t writeMoves(const Board& start, const BoardMove* moves, size_t count, std::string& out);
+};
+
+#endif // SAN_H
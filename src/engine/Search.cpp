@@ -0,0 +1,594 @@
+#include "engine/Search.h"
+#include "engine/Evaluation.h"
+
+#include <algorithm>
+#include <array>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+
+namespace {
+
+// ln(x) for x >= 1, evaluated at compile time through the atanh series
+constexpr double constexprLog(double x) {
+    int exponent = 0;
+    while (x > 2.0) {
+        x /= 2.718281828459045;
+        exponent++;
+    }
+    double y = (x - 1.0) / (x + 1.0);
+    double y2 = y * y;
+    double term = y;
+    double sum = 0.0;
+    for (int n = 1; n < 40; n += 2) {
+        sum += term / n;
+        term *= y2;
+    }
+    return exponent + 2.0 * sum;
+}
+
+using ReductionTable = std::array<std::array<int8_t, 64>, 64>;
+
+// Late move reduction indexed by [depth][move number]
+constexpr ReductionTable makeReductions() {
+    ReductionTable table{};
+    for (int depth = 1; depth < 64; ++depth) {
+        for (int moveNumber = 1; moveNumber < 64; ++moveNumber) {
+            table[depth][moveNumber] = int8_t(0.75 + constexprLog(depth) * constexprLog(moveNumber) / 2.25);
+        }
+    }
+    return table;
+}
+
+constexpr ReductionTable Reductions = makeReductions();
+
+constexpr int FutilityMargins[4] = { 0, 100, 250, 400 };
+constexpr int ReverseFutilityMargin = 80;
+constexpr int ReverseFutilityMaxDepth = 6;
+constexpr int NullMoveMinDepth = 3;
+constexpr int NullVerificationMinDepth = 8;
+constexpr int AspirationMinDepth = 5;
+constexpr int AspirationDelta = 25;
+
+constexpr int TTMoveScore = 10000000;
+constexpr int CaptureScore = 1000000;
+constexpr int KillerScores[2] = { 900000, 800000 };
+
+} // namespace
+
+Search::Search(TranspositionTable& table) : tt(table) {
+    clearHistory();
+}
+
+void Search::clearHistory() {
+    std::memset(killers, 0, sizeof(killers));
+    std::memset(historyTable, 0, sizeof(historyTable));
+}
+
+// Mate and tablebase scores count from the root; the table keeps them relative to the node
+int Search::scoreToTT(int score, int ply) {
+    if (score >= TB_WIN_BOUND) return score + ply;
+    if (score <= -TB_WIN_BOUND) return score - ply;
+    return score;
+}
+
+int Search::scoreFromTT(int score, int ply) {
+    if (score >= TB_WIN_BOUND) return score - ply;
+    if (score <= -TB_WIN_BOUND) return score + ply;
+    return score;
+}
+
+int64_t Search::elapsedMs() const {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(Clock::now() - startTime).count();
+}
+
+int64_t Search::clockElapsedMs() const {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(Clock::now() - clockStartTime).count();
+}
+
+// Called on the search thread; starts the clock the first time it sees that pondering has ended
+bool Search::isPondering() {
+    if (clockRunning) return false;
+    if (pondering.load()) return true;
+    clockRunning = true;
+    clockStartTime = Clock::now();
+    return false;
+}
+
+void Search::setupTimeLimits() {
+    softLimitMs = hardLimitMs = 0;
+    if (limits.infinite) return;
+    if (limits.moveTimeMs > 0) {
+        softLimitMs = hardLimitMs = limits.moveTimeMs;
+        return;
+    }
+    Color us = board.sideToMove();
+    int64_t timeLeft = limits.timeLeftMs[us];
+    if (timeLeft <= 0) return;
+
+    const int64_t overhead = 30;
+    int movesToGo = limits.movesToGo > 0 ? limits.movesToGo : 30;
+    int64_t available = std::max<int64_t>(1, timeLeft - overhead);
+    softLimitMs = available / movesToGo + limits.incrementMs[us] * 3 / 4;
+    softLimitMs = std::min(softLimitMs, available / 2);
+    hardLimitMs = std::min(softLimitMs * 3, available * 3 / 4);
+    softLimitMs = std::max<int64_t>(1, softLimitMs);
+    hardLimitMs = std::max(softLimitMs, hardLimitMs);
+}
+
+void Search::checkLimits() {
+    if (limits.nodes && nodes >= limits.nodes) stop();
+    if (hardLimitMs > 0 && !isPondering() && clockElapsedMs() >= hardLimitMs) stop();
+    if (haveInfo && limits.infoIntervalMs > 0) flushInfo(false);
+}
+
+SearchInfo Search::makeInfo(int depth, int multiPv, const RootLine& line) const {
+    SearchInfo info;
+    info.multiPv = multiPv;
+    info.depth = depth;
+    info.selDepth = selDepth;
+    info.score = line.pv.empty() ? line.score : rootTablebaseScore(line.pv[0], line.score);
+    info.nodes = nodes;
+    info.timeMs = elapsedMs();
+    info.nps = info.timeMs > 0 ? nodes * 1000 / uint64_t(info.timeMs) : nodes;
+    info.hashfull = tt.hashfull();
+    info.tbHits = tbHits;
+    info.pv = line.pv;
+    return info;
+}
+
+void Search::reportIteration(int depth) {
+    lastInfo.clear();
+    for (size_t i = 0; i < rootLines.size(); ++i) {
+        lastInfo.push_back(makeInfo(depth, int(i) + 1, rootLines[i]));
+    }
+    haveInfo = true;
+    infoPending = true;
+    flushInfo(limits.infoIntervalMs <= 0);
+}
+
+void Search::flushInfo(bool force) {
+    if (!infoCallback) return;
+    Clock::time_point now = Clock::now();
+    if (!force && now - lastInfoTime < std::chrono::milliseconds(limits.infoIntervalMs)) return;
+
+    // Between iterations only the counters move; refresh them so long iterations still show progress
+    int64_t timeMs = elapsedMs();
+    int hashfull = tt.hashfull();
+    for (SearchInfo& info : lastInfo) {
+        info.nodes = nodes;
+        info.timeMs = timeMs;
+        info.nps = timeMs > 0 ? nodes * 1000 / uint64_t(timeMs) : nodes;
+        info.hashfull = hashfull;
+        info.tbHits = tbHits;
+    }
+    lastInfoTime = now;
+    infoPending = false;
+    for (const SearchInfo& info : lastInfo) infoCallback(info);
+}
+
+SearchResult Search::run(const Board& position, const SearchLimits& searchLimits) {
+    board = position;
+    limits = searchLimits;
+    startTime = clockStartTime = Clock::now();
+    // A ponder hit that arrived before the search started turns it into a normal search
+    pondering.store(limits.ponder && !ponderHitPending.exchange(false));
+    clockRunning = !pondering.load();
+    nodes = 0;
+    haveInfo = infoPending = false;
+    lastInfoTime = startTime;
+    std::memset(killers, 0, sizeof(killers));
+    if (helperIndex == 0) tt.newSearch();
+    setupTimeLimits();
+
+    SearchResult result;
+    MoveList legal;
+    board.generateLegalMoves(legal);
+    if (legal.empty()) return result;
+    bitbases = Bitbases::current();
+    rankRootMovesWithTablebases(legal);
+    for (BoardMove move : legal) {
+        if (!isExcludedRootMove(move)) {
+            result.bestMove = move;
+            break;
+        }
+    }
+
+    const int maxDepth = limits.depth > 0 ? std::min(limits.depth, MAX_PLY - 1) : MAX_PLY - 1;
+    const int searchable = legal.size() - int(tablebaseExcludedMoves.size());
+    const int multiPv = std::clamp(limits.multiPV, 1, searchable);
+    rootLines.assign(multiPv, RootLine{});
+    for (RootLine& line : rootLines) line.score = 0;
+    std::vector<RootLine> iterationLines(multiPv);
+
+    for (int depth = 1; depth <= maxDepth; ++depth) {
+        if (helperIndex > 0 && depth > 1 && (depth + helperIndex) % 2 == 0) continue;
+        selDepth = 0;
+        excludedRootMoves.clear();
+        int completedLines = 0;
+
+        // Each line is the best move once the better lines' moves are excluded at the root.
+        // A line cannot score above the one before it, so that score caps its window.
+        for (int pvIndex = 0; pvIndex < multiPv; ++pvIndex) {
+            int ceiling = pvIndex > 0 ? iterationLines[pvIndex - 1].score : INFINITE_SCORE;
+            int score = aspirationSearch(depth, rootLines[pvIndex].score, ceiling);
+            if (isStopped() && depth > 1) break;
+            if (pvLength[0] == 0) break;
+
+            iterationLines[pvIndex].score = score;
+            iterationLines[pvIndex].pv.assign(pvTable[0], pvTable[0] + pvLength[0]);
+            excludedRootMoves.push_back(pvTable[0][0]);
+            completedLines++;
+            if (isStopped()) break;
+        }
+
+        // A stopped iteration is only trusted once at least one full iteration has finished,
+        // but a finished first line still improves the move to play
+        if (completedLines < multiPv) {
+            if (completedLines > 0 && depth > 1) {
+                const std::vector<BoardMove>& pv = iterationLines[0].pv;
+                result.bestMove = pv[0];
+                result.ponderMove = pv.size() > 1 ? pv[1] : BoardMove::none();
+                result.score = iterationLines[0].score;
+            }
+            if (depth > 1 || completedLines == 0) break;
+            rootLines.resize(completedLines);
+        }
+        for (int i = 0; i < int(rootLines.size()); ++i) rootLines[i] = iterationLines[i];
+        // A line searched after a better one may still have failed high past it
+        std::stable_sort(rootLines.begin(), rootLines.end(),
+                         [](const RootLine& a, const RootLine& b) { return a.score > b.score; });
+
+        const std::vector<BoardMove>& bestPv = rootLines[0].pv;
+        result.bestMove = bestPv[0];
+        result.ponderMove = bestPv.size() > 1 ? bestPv[1] : BoardMove::none();
+        result.score = rootLines[0].score;
+        result.depth = depth;
+        reportIteration(depth);
+
+        if (isStopped()) break;
+        if (isPondering()) continue;
+        // Do not start an iteration that is unlikely to finish in time
+        if (softLimitMs > 0 && clockElapsedMs() >= softLimitMs / 2) break;
+        // A forced mate found within the horizon will not improve with depth
+        if (!limits.infinite && multiPv == 1 && isMateScore(result.score)
+            && depth > 2 * mateInMoves(std::abs(result.score))) break;
+    }
+
+    if (infoPending) flushInfo(true);
+    // Pondering and infinite searches report their move only once told to (stop or ponder hit)
+    while ((limits.infinite || isPondering()) && !isStopped()) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    pondering.store(false);
+    ponderHitPending.store(false);
+
+    result.score = rootTablebaseScore(result.bestMove, result.score);
+    result.nodes = nodes;
+    return result;
+}
+
+int Search::aspirationSearch(int depth, int previousScore, int ceiling) {
+    int delta = AspirationDelta;
+    int alpha = -INFINITE_SCORE;
+    int beta = INFINITE_SCORE;
+    if (searchOptions.aspirationWindows && depth >= AspirationMinDepth && std::abs(previousScore) < TB_WIN_BOUND) {
+        alpha = std::max(previousScore - delta, -INFINITE_SCORE);
+        beta = std::min(previousScore + delta, INFINITE_SCORE);
+    }
+    if (ceiling < INFINITE_SCORE) {
+        beta = std::min(beta, ceiling + 1);
+        if (alpha >= beta) alpha = std::max(beta - delta, -INFINITE_SCORE);
+    }
+
+    while (true) {
+        int score = negamax(alpha, beta, depth, 0, false);
+        if (isStopped()) return score;
+        if (score <= alpha && alpha > -INFINITE_SCORE) {
+            beta = (alpha + beta) / 2;
+            alpha = std::max(score - delta, -INFINITE_SCORE);
+        } else if (score >= beta && beta < INFINITE_SCORE) {
+            beta = std::min(score + delta, INFINITE_SCORE);
+        } else {
+            return score;
+        }
+        delta *= 2;
+        if (delta > 1000) {
+            alpha = -INFINITE_SCORE;
+            beta = INFINITE_SCORE;
+        }
+    }
+}
+
+bool Search::isExcludedRootMove(BoardMove move) const {
+    return std::find(excludedRootMoves.begin(), excludedRootMoves.end(), move) != excludedRootMoves.end()
+           || std::find(tablebaseExcludedMoves.begin(), tablebaseExcludedMoves.end(), move) != tablebaseExcludedMoves.end();
+}
+
+void Search::rankRootMovesWithTablebases(const MoveList& legal) {
+    tablebases = Tablebases::current();
+    probeInSearch = tablebases && tablebases->maxPieces() > 0;
+    tbHits = 0;
+    rootTablebaseMoves.clear();
+    tablebaseExcludedMoves.clear();
+    if (!probeInSearch || !tablebases->covers(board)) return;
+
+    bool rankedByDtz = false;
+    if (!tablebases->rankRootMoves(board, rootTablebaseMoves, &rankedByDtz)) return;
+    tbHits += uint64_t(legal.size());
+
+    // Keep only the moves that hold the best outcome
+    int bestRank = rootTablebaseMoves.front().rank;
+    for (const TablebaseRootMove& root : rootTablebaseMoves) bestRank = std::max(bestRank, root.rank);
+    for (const TablebaseRootMove& root : rootTablebaseMoves) {
+        if (root.rank < bestRank) tablebaseExcludedMoves.push_back(root.move);
+    }
+
+    // With DTZ the remaining moves all keep the result, so the search needs no more probes;
+    // without it, probing still steers a winning side towards conversions
+    if (rankedByDtz || bestRank <= 0) probeInSearch = false;
+}
+
+// The score to show for a root move: the tablebase verdict unless the search found a mate
+int Search::rootTablebaseScore(BoardMove move, int score) const {
+    if (isMateScore(score)) return score;
+    for (const TablebaseRootMove& root : rootTablebaseMoves) {
+        if (root.move != move) continue;
+        // Wins the fifty-move rule spoils show as small advantages that grow as they near a real win
+        const int rank = root.rank;
+        return rank >= 900 ? TB_WIN_SCORE
+             : rank > 0 ? std::max(3, rank - 800) / 2
+             : rank == 0 ? 0
+             : rank > -900 ? std::min(-3, rank + 800) / 2
+             : -TB_WIN_SCORE;
+    }
+    return score;
+}
+
+void Search::updatePv(int ply, BoardMove move) {
+    pvTable[ply][0] = move;
+    for (int i = 0; i < pvLength[ply + 1]; ++i) pvTable[ply][i + 1] = pvTable[ply + 1][i];
+    pvLength[ply] = pvLength[ply + 1] + 1;
+}
+
+void Search::scoreMoves(const MoveList& moves, int* scores, BoardMove ttMove, int ply) const {
+    for (int i = 0; i < moves.size(); ++i) {
+        BoardMove move = moves[i];
+        if (move == ttMove) {
+            scores[i] = TTMoveScore;
+        } else if (move.isCapture() || move.isPromotion()) {
+            // MVV-LVA: most valuable victim first, cheapest attacker as tie-break
+            int victim = move.isEnPassant() ? PAWN : (move.isCapture() ? pieceType(board.pieceAt(move.to())) : PAWN);
+            int attacker = pieceType(board.pieceAt(move.from()));
+            int promotion = move.isPromotion() ? Evaluation::pieceValue(move.promotionType()) : 0;
+            scores[i] = CaptureScore + Evaluation::pieceValue(PieceType(victim)) * 10 - attacker + promotion;
+        } else if (move == killers[ply][0]) {
+            scores[i] = KillerScores[0];
+        } else if (move == killers[ply][1]) {
+            scores[i] = KillerScores[1];
+        } else {
+            scores[i] = historyTable[board.sideToMove()][move.from()][move.to()];
+        }
+    }
+}
+
+BoardMove Search::pickNext(MoveList& moves, int* scores, int index) {
+    int best = index;
+    for (int i = index + 1; i < moves.size(); ++i) {
+        if (scores[i] > scores[best]) best = i;
+    }
+    std::swap(moves[index], moves[best]);
+    std::swap(scores[index], scores[best]);
+    return moves[index];
+}
+
+void Search::updateQuietStats(BoardMove move, int depth, int ply) {
+    if (killers[ply][0] != move) {
+        killers[ply][1] = killers[ply][0];
+        killers[ply][0] = move;
+    }
+    int& entry = historyTable[board.sideToMove()][move.from()][move.to()];
+    entry += depth * depth;
+    if (entry > KillerScores[1] / 2) {
+        for (auto& bySide : historyTable)
+            for (auto& byFrom : bySide)
+                for (int& value : byFrom) value /= 2;
+    }
+}
+
+int Search::negamax(int alpha, int beta, int depth, int ply, bool allowNull) {
+    const bool rootNode = ply == 0;
+    const bool pvNode = beta - alpha > 1;
+    const bool inCheck = board.inCheck();
+    pvLength[ply] = 0;
+
+    if (!rootNode) {
+        if (board.isRepetition() || board.isFiftyMoveDraw() || board.hasInsufficientMaterial()) return 0;
+        // Mate distance pruning
+        alpha = std::max(alpha, -MATE_SCORE + ply);
+        beta = std::min(beta, MATE_SCORE - ply - 1);
+        if (alpha >= beta) return alpha;
+    }
+
+    if (inCheck && searchOptions.checkExtensions) depth++;
+    if (depth <= 0) return quiescence(alpha, beta, ply);
+
+    if ((++nodes & 1023) == 0) checkLimits();
+    if (isStopped()) return 0;
+    if (ply >= MAX_PLY - 1) return Evaluation::evaluate(board, bitbases.get());
+    selDepth = std::max(selDepth, ply);
+
+    TTEntry ttEntry;
+    const bool ttHit = tt.probe(board.key(), ttEntry);
+    const BoardMove ttMove = ttHit ? ttEntry.move : BoardMove::none();
+    if (ttHit && !pvNode && ttEntry.depth >= depth) {
+        int ttScore = scoreFromTT(ttEntry.score, ply);
+        if (ttEntry.bound == Bound::Exact
+            || (ttEntry.bound == Bound::Lower && ttScore >= beta)
+            || (ttEntry.bound == Bound::Upper && ttScore <= alpha)) {
+            return ttScore;
+        }
+    }
+
+    // Tablebases: the exact result, probed where a capture or pawn move has just reset the counter
+    if (!rootNode && probeInSearch && board.halfmoveClock() == 0 && tablebases->covers(board)) {
+        WdlScore wdl;
+        if (tablebases->probeWdl(board, wdl)) {
+            tbHits++;
+            // Cursed wins and blessed losses are draws under the fifty-move rule
+            const int score = wdl == WdlScore::Win ? TB_WIN_SCORE - ply : wdl == WdlScore::Loss ? -TB_WIN_SCORE + ply : 0;
+            const Bound bound = wdl == WdlScore::Win ? Bound::Lower : wdl == WdlScore::Loss ? Bound::Upper : Bound::Exact;
+            if (bound == Bound::Exact || (bound == Bound::Lower ? score >= beta : score <= alpha)) {
+                tt.store(board.key(), BoardMove::none(), scoreToTT(score, ply), Evaluation::evaluate(board, bitbases.get()),
+                         std::min(depth + 6, MAX_PLY - 1), bound);
+                return score;
+            }
+        }
+    }
+
+    const int staticEval = inCheck ? -INFINITE_SCORE : (ttHit ? int(ttEntry.staticEval) : Evaluation::evaluate(board, bitbases.get()));
+    const Color us = board.sideToMove();
+
+    // Reverse futility: the position is so good that even a margin per ply cannot bring it below beta
+    if (searchOptions.reverseFutility && !pvNode && !inCheck && depth <= ReverseFutilityMaxDepth
+        && std::abs(beta) < TB_WIN_BOUND && staticEval - ReverseFutilityMargin * depth >= beta) {
+        return staticEval;
+    }
+
+    // Null move: give the opponent a free move; if we still fail high, the node is very likely a cut node
+    if (searchOptions.nullMove && allowNull && !pvNode && !inCheck && depth >= NullMoveMinDepth
+        && staticEval >= beta && board.hasNonPawnMaterial(us)) {
+        int reduction = 3 + depth / 6;
+        board.makeNullMove();
+        int nullScore = -negamax(-beta, -beta + 1, depth - 1 - reduction, ply + 1, false);
+        board.unmakeNullMove();
+        if (isStopped()) return 0;
+        if (nullScore >= beta) {
+            if (nullScore >= TB_WIN_BOUND) nullScore = beta;
+            if (!searchOptions.nullMoveVerification || depth < NullVerificationMinDepth) return nullScore;
+            // Verify with a reduced normal search to catch zugzwang positions
+            int verified = negamax(beta - 1, beta, depth - reduction, ply, false);
+            if (verified >= beta) return nullScore;
+        }
+    }
+
+    const bool futile = searchOptions.futility && !pvNode && !inCheck && depth < 4
+                        && std::abs(alpha) < TB_WIN_BOUND && staticEval + FutilityMargins[depth] <= alpha;
+
+    MoveList moves;
+    board.generateMoves(moves);
+    int scores[256];
+    scoreMoves(moves, scores, ttMove, ply);
+
+    const int originalAlpha = alpha;
+    int bestScore = -INFINITE_SCORE;
+    BoardMove bestMove;
+    int legalCount = 0;
+
+    for (int i = 0; i < moves.size(); ++i) {
+        BoardMove move = pickNext(moves, scores, i);
+        if (rootNode && isExcludedRootMove(move)) continue;
+        if (!board.isLegal(move)) continue;
+        legalCount++;
+
+        const bool quiet = move.isQuiet();
+        const bool givesCheck = board.givesCheck(move);
+
+        // Futility: quiet moves cannot raise a hopeless static eval above alpha near the horizon
+        if (futile && legalCount > 1 && quiet && !givesCheck) continue;
+
+        board.makeMove(move);
+        int newDepth = depth - 1;
+        int score;
+        if (legalCount == 1) {
+            score = -negamax(-beta, -alpha, newDepth, ply + 1, true);
+        } else {
+            int reduction = 0;
+            if (searchOptions.lateMoveReductions && depth >= 3 && legalCount > 3 && quiet && !inCheck && !givesCheck
+                && move != killers[ply][0] && move != killers[ply][1]) {
+                reduction = Reductions[std::min(depth, 63)][std::min(legalCount, 63)];
+                if (pvNode) reduction--;
+                reduction = std::clamp(reduction, 0, newDepth - 1);
+            }
+            score = -negamax(-alpha - 1, -alpha, newDepth - reduction, ply + 1, true);
+            if (reduction > 0 && score > alpha) {
+                score = -negamax(-alpha - 1, -alpha, newDepth, ply + 1, true);
+            }
+            if (score > alpha && score < beta) {
+                score = -negamax(-beta, -alpha, newDepth, ply + 1, true);
+            }
+        }
+        board.unmakeMove();
+        if (isStopped()) return 0;
+
+        if (score > bestScore) {
+            bestScore = score;
+            bestMove = move;
+            if (score > alpha) {
+                alpha = score;
+                updatePv(ply, move);
+                if (alpha >= beta) {
+                    if (quiet) updateQuietStats(move, depth, ply);
+                    break;
+                }
+            }
+        }
+    }
+
+    if (legalCount == 0) return inCheck ? -MATE_SCORE + ply : 0;
+    // With moves excluded the root result is not the position's value; keep it out of the table
+    if (rootNode && !excludedRootMoves.empty()) return bestScore;
+
+    Bound bound = bestScore >= beta ? Bound::Lower : (alpha > originalAlpha ? Bound::Exact : Bound::Upper);
+    tt.store(board.key(), bestMove, scoreToTT(bestScore, ply), staticEval, depth, bound);
+    return bestScore;
+}
+
+int Search::quiescence(int alpha, int beta, int ply) {
+    pvLength[ply] = 0;
+    if ((++nodes & 1023) == 0) checkLimits();
+    if (isStopped()) return 0;
+    selDepth = std::max(selDepth, ply);
+
+    const bool inCheck = board.inCheck();
+    if (ply >= MAX_PLY - 1) return inCheck ? 0 : Evaluation::evaluate(board, bitbases.get());
+    if (board.isRepetition() || board.isFiftyMoveDraw() || board.hasInsufficientMaterial()) return 0;
+
+    int bestScore = -INFINITE_SCORE;
+    if (!inCheck) {
+        bestScore = Evaluation::evaluate(board, bitbases.get());
+        if (bestScore >= beta) return bestScore;
+        if (bestScore > alpha) alpha = bestScore;
+    }
+
+    // In check every evasion is searched; otherwise only captures and queen promotions
+    MoveList moves;
+    if (inCheck) board.generateMoves(moves);
+    else board.generateCaptures(moves);
+    int scores[256];
+    scoreMoves(moves, scores, BoardMove::none(), ply);
+
+    int legalCount = 0;
+    for (int i = 0; i < moves.size(); ++i) {
+        BoardMove move = pickNext(moves, scores, i);
+        if (!board.isLegal(move)) continue;
+        legalCount++;
+
+        board.makeMove(move);
+        int score = -quiescence(-beta, -alpha, ply + 1);
+        board.unmakeMove();
+        if (isStopped()) return 0;
+
+        if (score > bestScore) {
+            bestScore = score;
+            if (score > alpha) {
+                alpha = score;
+                updatePv(ply, move);
+                if (alpha >= beta) break;
+            }
+        }
+    }
+
+    if (inCheck && legalCount == 0) return -MATE_SCORE + ply;
+    return bestScore;
+}
@@ -0,0 +1,183 @@
+#ifndef SEARCH_H
+#define SEARCH_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <functional>
+#include <memory>
+#include <vector>
+#include "engine/Bitbases.h"
+#include "engine/Board.h"
+#include "engine/Tablebases.h"
+#include "engine/TranspositionTable.h"
+
+// Selective search features. Each can be toggled at runtime to measure its
+// effect on nodes-to-depth and playing strength in isolation.
+struct SearchOptions {
+    bool nullMove = true;
+    bool nullMoveVerification = true;
+    bool lateMoveReductions = true;
+    bool reverseFutility = true;
+    bool futility = true;
+    bool checkExtensions = true;
+    bool aspirationWindows = true;
+};
+
+struct SearchLimits {
+    int depth = 0;               // 0 = no depth limit
+    int64_t moveTimeMs = 0;      // fixed time for this move
+    int64_t timeLeftMs[2] = { 0, 0 };
+    int64_t incrementMs[2] = { 0, 0 };
+    int movesToGo = 0;
+    uint64_t nodes = 0;          // 0 = no node limit
+    bool infinite = false;
+    bool ponder = false;         // search the expected position without a clock until ponderHit()
+    int64_t infoIntervalMs = 0;  // minimum time between info reports, 0 = report every iteration
+    int multiPV = 1;             // number of best root moves to search and report
+};
+
+struct SearchInfo {
+    int multiPv = 1;             // 1-based rank of the root line this report describes
+    int depth = 0;
+    int selDepth = 0;
+    int score = 0;
+    uint64_t nodes = 0;
+    int64_t timeMs = 0;
+    uint64_t nps = 0;
+    int hashfull = 0;
+    uint64_t tbHits = 0;
+    std::vector<BoardMove> pv;
+};
+
+struct SearchResult {
+    BoardMove bestMove;
+    BoardMove ponderMove;
+    int score = 0;
+    int depth = 0;
+    uint64_t nodes = 0;
+};
+
+class Search {
+public:
+    static constexpr int MAX_PLY = 128;
+    static constexpr int INFINITE_SCORE = 32001;
+    static constexpr int MATE_SCORE = 32000;
+    static constexpr int MATE_BOUND = MATE_SCORE - MAX_PLY;
+    // Tablebase wins rank below every mate and above every evaluation
+    static constexpr int TB_WIN_SCORE = MATE_BOUND - 1;
+    static constexpr int TB_WIN_BOUND = TB_WIN_SCORE - MAX_PLY;
+
+    explicit Search(TranspositionTable& tt);
+
+    SearchOptions& options() { return searchOptions; }
+    const SearchOptions& options() const { return searchOptions; }
+    void setInfoCallback(std::function<void(const SearchInfo&)> callback) { infoCallback = std::move(callback); }
+
+    // Helper threads of a parallel search (index > 0) share the main thread's hash table
+    // and skip some iteration depths so that the threads spread over different depths.
+    void setHelperIndex(int index) { helperIndex = index; }
+
+    // Runs iterative deepening on a copy of the given position; blocks until done or stopped.
+    // Call clearStop() before handing the search to another thread: run() leaves the stop
+    // flag alone so that a stop sent before the thread gets going is not lost.
+    SearchResult run(const Board& position, const SearchLimits& limits);
+
+    // Safe to call from any thread; the search returns within a few hundred nodes.
+    void stop() { stopRequested.store(true, std::memory_order_relaxed); }
+    void clearStop() { stopRequested.store(false, std::memory_order_relaxed); }
+    bool isStopped() const { return stopRequested.load(std::memory_order_relaxed); }
+    // Safe to call from any thread: the opponent played the expected move, so a ponder search
+    // keeps its tree and starts its clock now. Applies to the next search if none is running yet.
+    void ponderHit() {
+        ponderHitPending.store(true);
+        pondering.store(false);
+    }
+
+    void clearHistory();
+
+    static bool isMateScore(int score) { return score >= MATE_BOUND || score <= -MATE_BOUND; }
+    static bool isTablebaseScore(int score) { return !isMateScore(score) && std::abs(score) >= TB_WIN_BOUND; }
+    // Signed number of moves to mate, positive when the side to move mates
+    static int mateInMoves(int score) {
+        return score > 0 ? (MATE_SCORE - score + 1) / 2 : -(MATE_SCORE + score) / 2;
+    }
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    TranspositionTable& tt;
+    SearchOptions searchOptions;
+    std::function<void(const SearchInfo&)> infoCallback;
+    std::atomic<bool> stopRequested { false };
+    int helperIndex = 0;
+    std::atomic<bool> pondering { false };
+    std::atomic<bool> ponderHitPending { false };
+
+    Board board;
+    SearchLimits limits;
+    Clock::time_point startTime;
+    Clock::time_point clockStartTime; // time limits count from here; moves on a ponder hit
+    bool clockRunning = false;
+    int64_t softLimitMs = 0;
+    int64_t hardLimitMs = 0;
+    uint64_t nodes = 0;
+    int selDepth = 0;
+
+    // Tablebases taken when the search started. Root moves that lose ground against the
+    // tablebase verdict are left out, and with DTZ ranking the root no probing is needed below.
+    std::shared_ptr<Tablebases> tablebases;
+    bool probeInSearch = false;
+    uint64_t tbHits = 0;
+    std::vector<TablebaseRootMove> rootTablebaseMoves;
+    std::vector<BoardMove> tablebaseExcludedMoves;
+    // Our own bitbases, taken with the tablebases and consulted by the static evaluation
+    std::shared_ptr<Bitbases> bitbases;
+
+    // Best root lines of the last completed iteration, ordered by score
+    struct RootLine {
+        int score = -INFINITE_SCORE;
+        std::vector<BoardMove> pv;
+    };
+    std::vector<RootLine> rootLines;
+    // Root moves already claimed by better lines in the current iteration
+    std::vector<BoardMove> excludedRootMoves;
+
+    // Throttled reporting: the latest completed iteration, re-sent with fresh node counts
+    std::vector<SearchInfo> lastInfo;
+    bool haveInfo = false;
+    bool infoPending = false;
+    Clock::time_point lastInfoTime;
+
+    BoardMove pvTable[MAX_PLY][MAX_PLY];
+    int pvLength[MAX_PLY];
+    BoardMove killers[MAX_PLY][2];
+    int historyTable[2][64][64];
+
+    int negamax(int alpha, int beta, int depth, int ply, bool allowNull);
+    int quiescence(int alpha, int beta, int ply);
+    int aspirationSearch(int depth, int previousScore, int ceiling);
+    bool isExcludedRootMove(BoardMove move) const;
+    void rankRootMovesWithTablebases(const MoveList& legal);
+    int rootTablebaseScore(BoardMove move, int score) const;
+
+    void scoreMoves(const MoveList& moves, int* scores, BoardMove ttMove, int ply) const;
+    static BoardMove pickNext(MoveList& moves, int* scores, int index);
+    void updateQuietStats(BoardMove move, int depth, int ply);
+    void updatePv(int ply, BoardMove move);
+
+    void setupTimeLimits();
+    int64_t elapsedMs() const;
+    int64_t clockElapsedMs() const;
+    bool isPondering();
+    void checkLimits();
+    SearchInfo makeInfo(int depth, int multiPv, const RootLine& line) const;
+    void reportIteration(int depth);
+    void flushInfo(bool force);
+
+    static int scoreToTT(int score, int ply);
+    static int scoreFromTT(int score, int ply);
+};
+
+#endif // SEARCH_H
@@ -0,0 +1,62 @@
+#include "engine/SearchPool.h"
+
+#include <algorithm>
+#include <thread>
+
+SearchPool::SearchPool(TranspositionTable& table, int threads) : tt(table) {
+    setThreadCount(threads);
+}
+
+void SearchPool::setThreadCount(int threads) {
+    threads = std::max(1, threads);
+    SearchOptions options = searches.empty() ? SearchOptions() : searches[0]->options();
+    searches.resize(threads);
+    for (int i = 0; i < threads; ++i) {
+        if (!searches[i]) {
+            searches[i] = std::make_unique<Search>(tt);
+            searches[i]->options() = options;
+        }
+        searches[i]->setHelperIndex(i);
+    }
+}
+
+void SearchPool::setOptions(const SearchOptions& options) {
+    for (auto& search : searches) search->options() = options;
+}
+
+void SearchPool::setInfoCallback(std::function<void(const SearchInfo&)> callback) {
+    searches[0]->setInfoCallback(std::move(callback));
+}
+
+void SearchPool::clearHistory() {
+    for (auto& search : searches) search->clearHistory();
+}
+
+void SearchPool::stop() {
+    for (auto& search : searches) search->stop();
+}
+
+void SearchPool::clearStop() {
+    for (auto& search : searches) search->clearStop();
+}
+
+SearchResult SearchPool::run(const Board& position, const SearchLimits& limits) {
+    // Helpers search without limits of their own and report nothing
+    SearchLimits helperLimits;
+    helperLimits.infinite = true;
+
+    std::vector<std::thread> helpers;
+    std::vector<uint64_t> helperNodes(searches.size(), 0);
+    for (size_t i = 1; i < searches.size(); ++i) {
+        helpers.emplace_back([this, i, &position, &helperLimits, &helperNodes]() {
+            helperNodes[i] = searches[i]->run(position, helperLimits).nodes;
+        });
+    }
+
+    SearchResult result = searches[0]->run(position, limits);
+
+    for (size_t i = 1; i < searches.size(); ++i) searches[i]->stop();
+    for (std::thread& helper : helpers) helper.join();
+    for (uint64_t nodes : helperNodes) result.nodes += nodes;
+    return result;
+}
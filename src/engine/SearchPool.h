@@ -0,0 +1,40 @@
+#ifndef SEARCHPOOL_H
+#define SEARCHPOOL_H
+
+#include <functional>
+#include <memory>
+#include <vector>
+#include "engine/Board.h"
+#include "engine/Search.h"
+#include "engine/TranspositionTable.h"
+
+// Lazy SMP: several searches of the same position run on their own threads and
+// share one transposition table. Only the main search (index 0) reports and
+// decides when to stop; the helpers just fill the table and are stopped with it.
+class SearchPool {
+public:
+    explicit SearchPool(TranspositionTable& tt, int threads = 1);
+
+    // Not safe while a search is running
+    void setThreadCount(int threads);
+    int threadCount() const { return int(searches.size()); }
+    void setOptions(const SearchOptions& options);
+    const SearchOptions& options() const { return searches[0]->options(); }
+    void setInfoCallback(std::function<void(const SearchInfo&)> callback);
+    void clearHistory();
+
+    // Blocks the calling thread, which runs the main search; helpers get threads of their own.
+    // Call clearStop() before handing run() to another thread.
+    SearchResult run(const Board& position, const SearchLimits& limits);
+
+    // Safe to call from any thread
+    void stop();
+    void clearStop();
+    void ponderHit() { searches[0]->ponderHit(); }
+
+private:
+    TranspositionTable& tt;
+    std::vector<std::unique_ptr<Search>> searches;
+};
+
+#endif // SEARCHPOOL_H
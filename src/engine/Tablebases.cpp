@@ -0,0 +1,907 @@
+#include "engine/Tablebases.h"
+
+#include <QDir>
+#include <QFile>
+#include <QDebug>
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+
+// The file format and the probing logic follow the Syzygy reference code by Ronald
+// de Man, in the form it takes in Stockfish's tbprobe.cpp.
+
+namespace {
+
+constexpr int TB_PIECES = Tablebases::MAX_PIECES;
+
+// Table flags: all but SingleValue refer to DTZ tables
+enum TableFlag { STM = 1, Mapped = 2, WinPlies = 4, LossPlies = 8, Wide = 16, SingleValue = 128 };
+
+constexpr uint8_t WdlMagic[4] = { 0x71, 0xE8, 0x23, 0x5D };
+constexpr uint8_t DtzMagic[4] = { 0xD7, 0x66, 0x0C, 0xA5 };
+
+// Piece codes as the files store them: white pawn..king 1..6, black 9..14
+inline int tablePiece(int piece) {
+    return (pieceColor(piece) == BLACK ? 8 : 0) | (pieceType(piece) + 1);
+}
+
+inline int offDiagonal(int sq) { return rowOf(sq) - colOf(sq); }
+inline int flipFile(int sq) { return sq ^ 7; }
+inline int flipRank(int sq) { return sq ^ 56; }
+
+inline uint16_t readLE16(const uint8_t *p) { return uint16_t(p[0] | (p[1] << 8)); }
+inline uint32_t readLE32(const uint8_t *p) {
+    return uint32_t(p[0]) | (uint32_t(p[1]) << 8) | (uint32_t(p[2]) << 16) | (uint32_t(p[3]) << 24);
+}
+inline uint32_t readBE32(const uint8_t *p) {
+    return (uint32_t(p[0]) << 24) | (uint32_t(p[1]) << 16) | (uint32_t(p[2]) << 8) | uint32_t(p[3]);
+}
+inline uint64_t readBE64(const uint8_t *p) { return (uint64_t(readBE32(p)) << 32) | readBE32(p + 4); }
+
+// Counts of each non-king piece, white then black, four bits each: an exact key for
+// the material of a position, so tables are found without hashing.
+uint64_t materialKey(const int counts[2][6], bool swapColors) {
+    uint64_t key = 0;
+    for (int c = 0; c < 2; ++c) {
+        for (int t = PAWN; t < KING; ++t) key = (key << 4) | uint64_t(counts[swapColors ? 1 - c : c][t]);
+    }
+    return key;
+}
+
+uint64_t materialKey(const Board& board) {
+    int counts[2][6];
+    for (int c = 0; c < 2; ++c) {
+        for (int t = PAWN; t <= KING; ++t) counts[c][t] = popCount(board.pieces(Color(c), PieceType(t)));
+    }
+    return materialKey(counts, false);
+}
+
+// Index tables shared by every file
+struct Encoding {
+    int mapPawns[64] = {};
+    int mapB1H1H7[64] = {};
+    int mapA1D1D4[64] = {};
+    int mapKK[10][64] = {};
+    int binomial[6][64] = {};     // [k][n]: ways to choose k squares out of n
+    int leadPawnIdx[6][64] = {};  // [lead pawn count][square]
+    int leadPawnsSize[6][4] = {}; // [lead pawn count][file a..d]
+
+    Encoding() {
+        // Squares below the a1-h8 diagonal, 0..27
+        int code = 0;
+        for (int sq = 0; sq < 64; ++sq) {
+            if (offDiagonal(sq) < 0) mapB1H1H7[sq] = code++;
+        }
+
+        // The a1-d1-d4 triangle, 0..9, with the diagonal squares last
+        std::fill(std::begin(mapA1D1D4), std::end(mapA1D1D4), -1);
+        std::vector<int> diagonal;
+        code = 0;
+        for (int sq = 0; sq <= squareOf(3, 3); ++sq) {
+            if (colOf(sq) > 3) continue;
+            if (offDiagonal(sq) < 0) mapA1D1D4[sq] = code++;
+            else if (offDiagonal(sq) == 0) diagonal.push_back(sq);
+        }
+        for (int sq : diagonal) mapA1D1D4[sq] = code++;
+
+        // The 462 legal placements of two kings with the first in the triangle. With the
+        // first king on the diagonal the second may not be above it. Placements with both
+        // kings on the diagonal come last.
+        std::vector<std::pair<int, int>> bothOnDiagonal;
+        code = 0;
+        for (int idx = 0; idx < 10; ++idx) {
+            for (int s1 = 0; s1 < 64; ++s1) {
+                if (mapA1D1D4[s1] != idx) continue;
+                for (int s2 = 0; s2 < 64; ++s2) {
+                    if (std::abs(rowOf(s1) - rowOf(s2)) <= 1 && std::abs(colOf(s1) - colOf(s2)) <= 1) continue;
+                    if (!offDiagonal(s1) && offDiagonal(s2) > 0) continue;
+                    if (!offDiagonal(s1) && !offDiagonal(s2)) bothOnDiagonal.emplace_back(idx, s2);
+                    else mapKK[idx][s2] = code++;
+                }
+            }
+        }
+        for (const auto& placement : bothOnDiagonal) mapKK[placement.first][placement.second] = code++;
+
+        binomial[0][0] = 1;
+        for (int n = 1; n < 64; ++n) {
+            for (int k = 0; k < 6 && k <= n; ++k) {
+                binomial[k][n] = (k > 0 ? binomial[k - 1][n - 1] : 0) + (k < n ? binomial[k][n - 1] : 0);
+            }
+        }
+
+        // mapPawns numbers a2..h7 so that the leading pawn, the one nearest the edge and
+        // lowest on its file, has the highest value; the value is also the number of
+        // squares left for the other pawns of the group
+        int availableSquares = 47;
+        for (int leadPawnsCnt = 1; leadPawnsCnt <= 5; ++leadPawnsCnt) {
+            for (int file = 0; file < 4; ++file) {
+                int idx = 0;
+                for (int rank = 1; rank <= 6; ++rank) {
+                    int sq = squareOf(rank, file);
+                    if (leadPawnsCnt == 1) {
+                        mapPawns[sq] = availableSquares--;
+                        mapPawns[flipFile(sq)] = availableSquares--;
+                    }
+                    leadPawnIdx[leadPawnsCnt][sq] = idx;
+                    idx += binomial[leadPawnsCnt - 1][mapPawns[sq]];
+                }
+                leadPawnsSize[leadPawnsCnt][file] = idx;
+            }
+        }
+    }
+};
+
+const Encoding& encoding() {
+    static const Encoding tables;
+    return tables;
+}
+
+using Sym = uint16_t;
+
+// Decoding data of one sub-table: a file holds one per side to move (WDL only) and,
+// with pawns, one per file of the leading pawn
+struct PairsData {
+    uint8_t flags = 0;
+    uint8_t maxSymLen = 0;
+    uint8_t minSymLen = 0;             // the value itself for single-value tables
+    uint32_t numBlocks = 0;
+    size_t blockSize = 0;
+    size_t span = 0;                   // one sparse index entry every span values
+    const uint8_t *lowestSym = nullptr;
+    const uint8_t *btree = nullptr;    // three bytes per symbol: left and right child
+    const uint8_t *blockLength = nullptr;
+    uint32_t blockLengthSize = 0;
+    const uint8_t *sparseIndex = nullptr; // six bytes per entry: block (4), offset (2)
+    size_t sparseIndexSize = 0;
+    const uint8_t *data = nullptr;
+    std::vector<uint64_t> base64;      // lowest symbol of each length, left-aligned
+    std::vector<uint8_t> symlen;       // values a symbol expands to, minus one
+    int pieces[TB_PIECES] = {};
+    uint64_t groupIdx[TB_PIECES + 1] = {};
+    int groupLen[TB_PIECES + 1] = {};
+    uint32_t mapIdx[4] = {};           // DTZ value maps of win, loss, cursed win, blessed loss
+
+    Sym lowest(int len) const { return readLE16(lowestSym + 2 * len); }
+    Sym left(Sym sym) const { return Sym(((btree[3 * sym + 1] & 0xF) << 8) | btree[3 * sym]); }
+    Sym right(Sym sym) const { return Sym((btree[3 * sym + 2] << 4) | (btree[3 * sym + 1] >> 4)); }
+    uint16_t length(uint32_t block) const { return readLE16(blockLength + 2 * size_t(block)); }
+};
+
+} // namespace
+
+struct Tablebases::Table {
+    QString name;                // e.g. "KRvK", stronger side first
+    bool isDtz = false;
+    uint64_t key = 0;            // the material as named, the first side white
+    uint64_t key2 = 0;           // the same material with the colors swapped
+    int pieceCount = 0;
+    bool hasPawns = false;
+    bool hasUniquePieces = false;
+    uint8_t pawnCount[2] = {};   // leading color, other color
+
+    std::atomic<bool> ready { false };
+    QFile file;
+    const uchar *base = nullptr;
+    const uint8_t *dtzMap = nullptr;
+    PairsData items[2][4];       // [side to move][file of the leading pawn]
+
+    PairsData *get(int stm, int file) { return &items[isDtz ? 0 : stm % 2][hasPawns ? file : 0]; }
+};
+
+namespace {
+
+// Recursive pairing: each symbol stands for a pair of symbols, down to the leaves
+uint8_t setSymlen(PairsData& d, Sym sym, std::vector<bool>& visited) {
+    visited[sym] = true;
+    Sym right = d.right(sym);
+    if (right == 0xFFF) return 0;
+    Sym left = d.left(sym);
+    if (!visited[left]) d.symlen[left] = setSymlen(d, left, visited);
+    if (!visited[right]) d.symlen[right] = setSymlen(d, right, visited);
+    return uint8_t(d.symlen[left] + d.symlen[right] + 1);
+}
+
+// Groups of pieces encoded together: the leading group (up to three unique pieces,
+// the two kings, or the leading pawns), the other side's pawns, then one group per
+// piece kind. order[] says in which order the groups enter the index.
+void setGroups(Tablebases::Table& e, PairsData& d, const int order[2], int file) {
+    const Encoding& enc = encoding();
+    int n = 0;
+    int firstLen = e.hasPawns ? 0 : e.hasUniquePieces ? 3 : 2;
+    d.groupLen[n] = 1;
+    for (int i = 1; i < e.pieceCount; ++i) {
+        if (--firstLen > 0 || d.pieces[i] == d.pieces[i - 1]) d.groupLen[n]++;
+        else d.groupLen[++n] = 1;
+    }
+    d.groupLen[++n] = 0;
+
+    const bool pawnsOnBothSides = e.hasPawns && e.pawnCount[1];
+    int next = pawnsOnBothSides ? 2 : 1;
+    int freeSquares = 64 - d.groupLen[0] - (pawnsOnBothSides ? d.groupLen[1] : 0);
+    uint64_t idx = 1;
+
+    for (int k = 0; next < n || k == order[0] || k == order[1]; ++k) {
+        if (k == order[0]) {
+            d.groupIdx[0] = idx;
+            idx *= e.hasPawns ? enc.leadPawnsSize[d.groupLen[0]][file] : e.hasUniquePieces ? 31332 : 462;
+        } else if (k == order[1]) {
+            d.groupIdx[1] = idx;
+            idx *= enc.binomial[d.groupLen[1]][48 - d.groupLen[0]];
+        } else {
+            d.groupIdx[next] = idx;
+            idx *= enc.binomial[d.groupLen[next]][freeSquares];
+            freeSquares -= d.groupLen[next++];
+        }
+    }
+    d.groupIdx[n] = idx;
+}
+
+const uint8_t *setSizes(PairsData& d, const uint8_t *data) {
+    d.flags = *data++;
+    if (d.flags & SingleValue) {
+        d.numBlocks = d.blockLengthSize = 0;
+        d.span = d.sparseIndexSize = 0;
+        d.minSymLen = *data++;
+        return data;
+    }
+
+    // The index of the last group bounds every index, so it is the table size
+    const uint64_t tableSize = d.groupIdx[std::find(d.groupLen, d.groupLen + TB_PIECES, 0) - d.groupLen];
+
+    d.blockSize = size_t(1) << *data++;
+    d.span = size_t(1) << *data++;
+    d.sparseIndexSize = size_t((tableSize + d.span - 1) / d.span);
+    const uint8_t padding = *data++;
+    d.numBlocks = readLE32(data);
+    data += 4;
+    // Padded so that the sparse index never points past the end
+    d.blockLengthSize = d.numBlocks + padding;
+    d.maxSymLen = *data++;
+    d.minSymLen = *data++;
+    d.lowestSym = data;
+    d.base64.assign(d.maxSymLen - d.minSymLen + 1, 0);
+
+    // Canonical Huffman code: longer symbols have lower values, so base64[] decreases
+    // with the length and a left-aligned code is at least the base of its length
+    for (int i = int(d.base64.size()) - 2; i >= 0; --i) {
+        d.base64[i] = (d.base64[i + 1] + d.lowest(i) - d.lowest(i + 1)) / 2;
+    }
+    for (size_t i = 0; i < d.base64.size(); ++i) d.base64[i] <<= 64 - i - d.minSymLen;
+
+    data += d.base64.size() * sizeof(Sym);
+    d.symlen.assign(readLE16(data), 0);
+    data += 2;
+    d.btree = data;
+
+    std::vector<bool> visited(d.symlen.size());
+    for (size_t sym = 0; sym < d.symlen.size(); ++sym) {
+        if (!visited[sym]) d.symlen[sym] = setSymlen(d, Sym(sym), visited);
+    }
+    return data + d.symlen.size() * 3 + (d.symlen.size() & 1);
+}
+
+// DTZ values are stored as ranks by frequency; these maps turn them back into distances
+const uint8_t *setDtzMap(Tablebases::Table& e, const uint8_t *data, int maxFile) {
+    e.dtzMap = data;
+    for (int f = 0; f <= maxFile; ++f) {
+        PairsData& d = *e.get(0, f);
+        if (!(d.flags & Mapped)) continue;
+        if (d.flags & Wide) {
+            data += reinterpret_cast<uintptr_t>(data) & 1;
+            for (int i = 0; i < 4; ++i) {
+                d.mapIdx[i] = uint32_t(data - e.dtzMap + 2);
+                data += 2 * readLE16(data) + 2;
+            }
+        } else {
+            for (int i = 0; i < 4; ++i) {
+                d.mapIdx[i] = uint32_t(data - e.dtzMap + 1);
+                data += *data + 1;
+            }
+        }
+    }
+    return data + (reinterpret_cast<uintptr_t>(data) & 1);
+}
+
+// Reads the header of a freshly mapped file (after the magic) into the table
+bool setup(Tablebases::Table& e, const uint8_t *data) {
+    enum { Split = 1, HasPawns = 2 };
+    if (e.hasPawns != bool(*data & HasPawns) || (e.key != e.key2) != bool(*data & Split)) return false;
+    data++;
+
+    const int sides = !e.isDtz && e.key != e.key2 ? 2 : 1;
+    const int maxFile = e.hasPawns ? 3 : 0;
+    const bool pawnsOnBothSides = e.hasPawns && e.pawnCount[1];
+
+    for (int f = 0; f <= maxFile; ++f) {
+        for (int i = 0; i < sides; ++i) *e.get(i, f) = PairsData();
+
+        const int order[2][2] = { { *data & 0xF, pawnsOnBothSides ? *(data + 1) & 0xF : 0xF },
+                                  { *data >> 4, pawnsOnBothSides ? *(data + 1) >> 4 : 0xF } };
+        data += 1 + pawnsOnBothSides;
+
+        for (int k = 0; k < e.pieceCount; ++k, ++data) {
+            for (int i = 0; i < sides; ++i) e.get(i, f)->pieces[k] = i ? *data >> 4 : *data & 0xF;
+        }
+        for (int i = 0; i < sides; ++i) setGroups(e, *e.get(i, f), order[i], f);
+    }
+
+    data += reinterpret_cast<uintptr_t>(data) & 1;
+
+    for (int f = 0; f <= maxFile; ++f) {
+        for (int i = 0; i < sides; ++i) data = setSizes(*e.get(i, f), data);
+    }
+    if (e.isDtz) data = setDtzMap(e, data, maxFile);
+
+    for (int f = 0; f <= maxFile; ++f) {
+        for (int i = 0; i < sides; ++i) {
+            PairsData& d = *e.get(i, f);
+            d.sparseIndex = data;
+            data += d.sparseIndexSize * 6;
+        }
+    }
+    for (int f = 0; f <= maxFile; ++f) {
+        for (int i = 0; i < sides; ++i) {
+            PairsData& d = *e.get(i, f);
+            d.blockLength = data;
+            data += size_t(d.blockLengthSize) * 2;
+        }
+    }
+    for (int f = 0; f <= maxFile; ++f) {
+        for (int i = 0; i < sides; ++i) {
+            data = reinterpret_cast<const uint8_t*>((reinterpret_cast<uintptr_t>(data) + 0x3F) & ~uintptr_t(0x3F));
+            PairsData& d = *e.get(i, f);
+            d.data = data;
+            data += size_t(d.numBlocks) * d.blockSize;
+        }
+    }
+    return true;
+}
+
+// Value number idx of a sub-table. The data is split into blocks of Huffman-coded
+// symbols, each symbol expanding to up to 256 values; the sparse index gives a block
+// and offset near idx, and the block lengths walk it to the exact block.
+int decompressPairs(const PairsData& d, uint64_t idx) {
+    if (d.flags & SingleValue) return d.minSymLen;
+
+    const uint32_t k = uint32_t(idx / d.span);
+    uint32_t block = readLE32(d.sparseIndex + 6 * size_t(k));
+    int offset = readLE16(d.sparseIndex + 6 * size_t(k) + 4);
+
+    // The entry describes value k * span + span / 2
+    offset += int(idx % d.span) - int(d.span / 2);
+    while (offset < 0) offset += d.length(--block) + 1;
+    while (offset > d.length(block)) offset -= d.length(block++) + 1;
+
+    const uint8_t *ptr = d.data + uint64_t(block) * d.blockSize;
+    uint64_t buf64 = readBE64(ptr);
+    ptr += 8;
+    int buf64Size = 64;
+    Sym sym;
+
+    while (true) {
+        int len = 0;
+        while (buf64 < d.base64[len]) ++len;
+        sym = Sym((buf64 - d.base64[len]) >> (64 - len - d.minSymLen));
+        sym = Sym(sym + d.lowest(len));
+        if (offset < d.symlen[sym] + 1) break;
+
+        offset -= d.symlen[sym] + 1;
+        len += d.minSymLen;
+        buf64 <<= len;
+        buf64Size -= len;
+        if (buf64Size <= 32) {
+            buf64Size += 32;
+            buf64 |= uint64_t(readBE32(ptr)) << (64 - buf64Size);
+            ptr += 4;
+        }
+    }
+
+    // Descend the pair tree to the value at offset
+    while (d.symlen[sym]) {
+        Sym left = d.left(sym);
+        if (offset < d.symlen[left] + 1) {
+            sym = left;
+        } else {
+            offset -= d.symlen[left] + 1;
+            sym = d.right(sym);
+        }
+    }
+    return d.left(sym);
+}
+
+int dtzBeforeZeroing(WdlScore wdl) {
+    switch (wdl) {
+    case WdlScore::Win: return 1;
+    case WdlScore::CursedWin: return 101;
+    case WdlScore::BlessedLoss: return -101;
+    case WdlScore::Loss: return -1;
+    default: return 0;
+    }
+}
+
+inline int signOf(int value) { return (value > 0) - (value < 0); }
+
+bool isMate(Board& board) {
+    if (!board.inCheck()) return false;
+    MoveList moves;
+    board.generateLegalMoves(moves);
+    return moves.empty();
+}
+
+std::shared_ptr<Tablebases> currentSet;
+
+} // namespace
+
+Tablebases::Tablebases(const QString& paths) {
+    for (const QString& path : paths.split(QDir::listSeparator())) {
+        if (!path.isEmpty() && path != "<empty>") directories.append(path);
+    }
+    if (directories.isEmpty()) return;
+
+    // Every material combination of up to seven pieces, named the way the files are
+    for (int p1 = PAWN; p1 < KING; ++p1) {
+        addTable({ KING, PieceType(p1), KING });
+        for (int p2 = PAWN; p2 <= p1; ++p2) {
+            addTable({ KING, PieceType(p1), PieceType(p2), KING });
+            addTable({ KING, PieceType(p1), KING, PieceType(p2) });
+            for (int p3 = PAWN; p3 < KING; ++p3) {
+                addTable({ KING, PieceType(p1), PieceType(p2), KING, PieceType(p3) });
+            }
+            for (int p3 = PAWN; p3 <= p2; ++p3) {
+                addTable({ KING, PieceType(p1), PieceType(p2), PieceType(p3), KING });
+                for (int p4 = PAWN; p4 <= p3; ++p4) {
+                    addTable({ KING, PieceType(p1), PieceType(p2), PieceType(p3), PieceType(p4), KING });
+                    for (int p5 = PAWN; p5 <= p4; ++p5) {
+                        addTable({ KING, PieceType(p1), PieceType(p2), PieceType(p3), PieceType(p4), PieceType(p5), KING });
+                    }
+                    for (int p5 = PAWN; p5 < KING; ++p5) {
+                        addTable({ KING, PieceType(p1), PieceType(p2), PieceType(p3), PieceType(p4), KING, PieceType(p5) });
+                    }
+                }
+                for (int p4 = PAWN; p4 < KING; ++p4) {
+                    addTable({ KING, PieceType(p1), PieceType(p2), PieceType(p3), KING, PieceType(p4) });
+                    for (int p5 = PAWN; p5 <= p4; ++p5) {
+                        addTable({ KING, PieceType(p1), PieceType(p2), PieceType(p3), KING, PieceType(p4), PieceType(p5) });
+                    }
+                }
+            }
+            for (int p3 = PAWN; p3 <= p1; ++p3) {
+                for (int p4 = PAWN; p4 <= (p1 == p3 ? p2 : p3); ++p4) {
+                    addTable({ KING, PieceType(p1), PieceType(p2), KING, PieceType(p3), PieceType(p4) });
+                }
+            }
+        }
+    }
+    qDebug() << "Syzygy:" << tableCount() << "tablebases found, up to" << largest << "pieces";
+}
+
+// Each QFile unmaps its file when destroyed
+Tablebases::~Tablebases() = default;
+
+std::shared_ptr<Tablebases> Tablebases::current() {
+    return std::atomic_load(&currentSet);
+}
+
+void Tablebases::setCurrent(std::shared_ptr<Tablebases> tablebases) {
+    std::atomic_store(&currentSet, std::move(tablebases));
+}
+
+bool Tablebases::covers(const Board& board) const {
+    return largest > 0 && popCount(board.occupied()) <= largest && board.castlingRights() == 0;
+}
+
+void Tablebases::addTable(const std::vector<PieceType>& pieces) {
+    static const char PieceLetters[] = "PNBRQK";
+    QString name;
+    int counts[2][6] = {};
+    int side = -1;
+    for (PieceType type : pieces) {
+        if (type == KING) {
+            side++;
+            if (side == 1) name += 'v';
+        }
+        name += PieceLetters[type];
+        counts[side][type]++;
+    }
+
+    // Only the WDL file is looked for; a missing DTZ file shows when it is probed
+    bool found = false;
+    for (const QString& directory : directories) {
+        if (QFile::exists(directory + "/" + name + ".rtbw")) {
+            found = true;
+            break;
+        }
+    }
+    if (!found) return;
+
+    auto wdl = std::make_unique<Table>();
+    wdl->name = name;
+    wdl->key = materialKey(counts, false);
+    wdl->key2 = materialKey(counts, true);
+    wdl->pieceCount = int(pieces.size());
+    wdl->hasPawns = counts[WHITE][PAWN] + counts[BLACK][PAWN] > 0;
+    for (int c = 0; c < 2; ++c) {
+        for (int t = PAWN; t < KING; ++t) {
+            if (counts[c][t] == 1) wdl->hasUniquePieces = true;
+        }
+    }
+    // The side with fewer pawns leads, which compresses better
+    const bool whiteLeads = !counts[BLACK][PAWN]
+                            || (counts[WHITE][PAWN] && counts[BLACK][PAWN] >= counts[WHITE][PAWN]);
+    wdl->pawnCount[0] = uint8_t(counts[whiteLeads ? WHITE : BLACK][PAWN]);
+    wdl->pawnCount[1] = uint8_t(counts[whiteLeads ? BLACK : WHITE][PAWN]);
+
+    auto dtz = std::make_unique<Table>();
+    dtz->name = wdl->name;
+    dtz->isDtz = true;
+    dtz->key = wdl->key;
+    dtz->key2 = wdl->key2;
+    dtz->pieceCount = wdl->pieceCount;
+    dtz->hasPawns = wdl->hasPawns;
+    dtz->hasUniquePieces = wdl->hasUniquePieces;
+    dtz->pawnCount[0] = wdl->pawnCount[0];
+    dtz->pawnCount[1] = wdl->pawnCount[1];
+
+    const Entry entry { wdl.get(), dtz.get() };
+    byMaterial[wdl->key] = entry;
+    byMaterial[wdl->key2] = entry;
+    tables.push_back(std::move(wdl));
+    tables.push_back(std::move(dtz));
+    largest = std::max(largest, int(pieces.size()));
+}
+
+// Maps the file on first use; safe to call from several search threads at once
+bool Tablebases::mapTable(Table& e) {
+    if (e.ready.load(std::memory_order_acquire)) return e.base != nullptr;
+
+    std::lock_guard<std::mutex> lock(mapMutex);
+    if (e.ready.load(std::memory_order_relaxed)) return e.base != nullptr;
+
+    const QString fileName = e.name + (e.isDtz ? ".rtbz" : ".rtbw");
+    for (const QString& directory : directories) {
+        e.file.setFileName(directory + "/" + fileName);
+        if (e.file.open(QIODevice::ReadOnly)) break;
+    }
+
+    if (e.file.isOpen()) {
+        const qint64 size = e.file.size();
+        const uchar *data = size % 64 == 16 ? e.file.map(0, size) : nullptr;
+        const uint8_t *magic = e.isDtz ? DtzMagic : WdlMagic;
+        if (data && std::memcmp(data, magic, 4) == 0 && setup(e, data + 4)) {
+            e.base = data;
+        } else {
+            qWarning() << "Syzygy: corrupt tablebase" << e.file.fileName();
+            if (data) e.file.unmap(const_cast<uchar*>(data));
+        }
+        // The mapping outlives the descriptor
+        e.file.close();
+    }
+
+    e.ready.store(true, std::memory_order_release);
+    return e.base != nullptr;
+}
+
+// Looks the position up in its table. The index follows the file's encoding: the
+// position is mirrored so the stronger side is white, the leading piece is brought
+// into the a1-d1-d4 triangle (or the leading pawn onto files a-d), and each group of
+// pieces is numbered as a combination of its squares.
+int Tablebases::probeTable(const Board& board, bool dtz, WdlScore wdl, ProbeState& state) {
+    const Encoding& enc = encoding();
+    if (popCount(board.occupied()) == 2) return 0; // KvK
+
+    auto found = byMaterial.find(materialKey(board));
+    if (found == byMaterial.end()) {
+        state = ProbeState::Fail;
+        return 0;
+    }
+    Table *entry = dtz ? found->second.dtz : found->second.wdl;
+    if (!mapTable(*entry)) {
+        state = ProbeState::Fail;
+        return 0;
+    }
+
+    int squares[TB_PIECES];
+    int pieces[TB_PIECES];
+    int size = 0;
+    int leadPawnsCnt = 0;
+    Bitboard leadPawns = 0;
+    int tbFile = 0;
+
+    // Symmetric material is stored for white to move only, and every table with the
+    // stronger side as white: otherwise swap the colors and mirror the ranks
+    const bool symmetricBlackToMove = entry->key == entry->key2 && board.sideToMove() == BLACK;
+    const bool blackStronger = materialKey(board) != entry->key;
+    const bool flip = symmetricBlackToMove || blackStronger;
+    const int flipColor = flip ? 8 : 0;
+    const int flipSquares = flip ? 56 : 0;
+    const int stm = (flip ? 1 : 0) ^ int(board.sideToMove());
+
+    auto pawnOrder = [&enc](int a, int b) { return enc.mapPawns[a] < enc.mapPawns[b]; };
+
+    if (entry->hasPawns) {
+        // Pawns come first in every sub-table and their color is the leading one
+        const int leadPiece = entry->get(0, 0)->pieces[0] ^ flipColor;
+        const Color leadColor = leadPiece >= 8 ? BLACK : WHITE;
+        Bitboard b = leadPawns = board.pieces(leadColor, PAWN);
+        while (b) squares[size++] = popLsb(b) ^ flipSquares;
+        leadPawnsCnt = size;
+        std::swap(squares[0], *std::max_element(squares, squares + leadPawnsCnt, pawnOrder));
+        tbFile = std::min(colOf(squares[0]), 7 - colOf(squares[0]));
+    }
+
+    // DTZ files hold one side to move; for the other a one-ply search is needed
+    if (dtz) {
+        const int flags = entry->get(stm, tbFile)->flags;
+        if ((flags & STM) != stm && !(entry->key == entry->key2 && !entry->hasPawns)) {
+            state = ProbeState::ChangeSideToMove;
+            return 0;
+        }
+    }
+
+    Bitboard b = board.occupied() ^ leadPawns;
+    while (b) {
+        int sq = popLsb(b);
+        squares[size] = sq ^ flipSquares;
+        pieces[size++] = tablePiece(board.pieceAt(sq)) ^ flipColor;
+    }
+
+    PairsData& d = *entry->get(stm, tbFile);
+
+    // Put the pieces in the order the sub-table lists them
+    for (int i = leadPawnsCnt; i < size - 1; ++i) {
+        for (int j = i + 1; j < size; ++j) {
+            if (d.pieces[i] == pieces[j]) {
+                std::swap(pieces[i], pieces[j]);
+                std::swap(squares[i], squares[j]);
+                break;
+            }
+        }
+    }
+
+    if (colOf(squares[0]) > 3) {
+        for (int i = 0; i < size; ++i) squares[i] = flipFile(squares[i]);
+    }
+
+    uint64_t idx;
+    if (entry->hasPawns) {
+        idx = uint64_t(enc.leadPawnIdx[leadPawnsCnt][squares[0]]);
+        std::stable_sort(squares + 1, squares + leadPawnsCnt, pawnOrder);
+        for (int i = 1; i < leadPawnsCnt; ++i) idx += uint64_t(enc.binomial[i][enc.mapPawns[squares[i]]]);
+    } else {
+        if (rowOf(squares[0]) > 3) {
+            for (int i = 0; i < size; ++i) squares[i] = flipRank(squares[i]);
+        }
+        // The first piece of the leading group off the a1-h8 diagonal goes below it
+        for (int i = 0; i < d.groupLen[0]; ++i) {
+            if (!offDiagonal(squares[i])) continue;
+            if (offDiagonal(squares[i]) > 0) {
+                for (int j = i; j < size; ++j) squares[j] = ((squares[j] >> 3) | (squares[j] << 3)) & 63;
+            }
+            break;
+        }
+
+        if (entry->hasUniquePieces) {
+            // Three unique pieces encoded together: 31332 placements
+            const int adjust1 = squares[1] > squares[0];
+            const int adjust2 = (squares[2] > squares[0]) + (squares[2] > squares[1]);
+            if (offDiagonal(squares[0])) {
+                idx = uint64_t((enc.mapA1D1D4[squares[0]] * 63 + (squares[1] - adjust1)) * 62 + squares[2] - adjust2);
+            } else if (offDiagonal(squares[1])) {
+                idx = uint64_t((6 * 63 + rowOf(squares[0]) * 28 + enc.mapB1H1H7[squares[1]]) * 62 + squares[2] - adjust2);
+            } else if (offDiagonal(squares[2])) {
+                idx = uint64_t(6 * 63 * 62 + 4 * 28 * 62 + rowOf(squares[0]) * 7 * 28
+                               + (rowOf(squares[1]) - adjust1) * 28 + enc.mapB1H1H7[squares[2]]);
+            } else {
+                idx = uint64_t(6 * 63 * 62 + 4 * 28 * 62 + 4 * 7 * 28 + rowOf(squares[0]) * 7 * 6
+                               + (rowOf(squares[1]) - adjust1) * 6 + (rowOf(squares[2]) - adjust2));
+            }
+        } else {
+            // Only the two kings lead: 462 placements
+            idx = uint64_t(enc.mapKK[enc.mapA1D1D4[squares[0]]][squares[1]]);
+        }
+    }
+
+    // The remaining groups: pawns first, then pieces, each as a sorted combination of
+    // the squares the earlier groups leave free
+    idx *= d.groupIdx[0];
+    int *groupSq = squares + d.groupLen[0];
+    bool remainingPawns = entry->hasPawns && entry->pawnCount[1];
+    for (int next = 1; d.groupLen[next]; ++next) {
+        std::stable_sort(groupSq, groupSq + d.groupLen[next]);
+        uint64_t n = 0;
+        for (int i = 0; i < d.groupLen[next]; ++i) {
+            const int sq = groupSq[i];
+            const int adjust = int(std::count_if(squares, groupSq, [sq](int other) { return sq > other; }));
+            n += uint64_t(enc.binomial[i + 1][sq - adjust - (remainingPawns ? 8 : 0)]);
+        }
+        remainingPawns = false;
+        idx += n * d.groupIdx[next];
+        groupSq += d.groupLen[next];
+    }
+
+    int value = decompressPairs(d, idx);
+    if (!dtz) return value - 2;
+
+    // DTZ: undo the frequency ranking and convert moves to plies
+    constexpr int WdlMapIndex[] = { 1, 3, 0, 2, 0 };
+    const PairsData& mapData = *entry->get(0, tbFile);
+    if (mapData.flags & Mapped) {
+        const uint32_t offset = mapData.mapIdx[WdlMapIndex[int(wdl) + 2]];
+        if (mapData.flags & Wide) value = readLE16(entry->dtzMap + offset + 2 * size_t(value));
+        else value = entry->dtzMap[offset + size_t(value)];
+    }
+    if ((wdl == WdlScore::Win && !(mapData.flags & WinPlies))
+        || (wdl == WdlScore::Loss && !(mapData.flags & LossPlies))
+        || wdl == WdlScore::CursedWin || wdl == WdlScore::BlessedLoss) {
+        value *= 2;
+    }
+    return value + 1;
+}
+
+// The tables store "don't care" values where a capture is the best move (and, for
+// DTZ, where any zeroing move is), so those moves are searched and the best of their
+// results and the stored value is the true one.
+WdlScore Tablebases::searchZeroing(Board& board, bool checkPawnMoves, ProbeState& state) {
+    WdlScore bestValue = WdlScore::Loss;
+    MoveList moves;
+    board.generateLegalMoves(moves);
+    int moveCount = 0;
+
+    for (BoardMove move : moves) {
+        if (!move.isCapture() && (!checkPawnMoves || pieceType(board.pieceAt(move.from())) != PAWN)) continue;
+        moveCount++;
+
+        board.makeMove(move);
+        WdlScore value = -searchZeroing(board, false, state);
+        board.unmakeMove();
+        if (state == ProbeState::Fail) return WdlScore::Draw;
+
+        if (value > bestValue) {
+            bestValue = value;
+            if (value >= WdlScore::Win) {
+                state = ProbeState::ZeroingBestMove;
+                return value;
+            }
+        }
+    }
+
+    // With every legal move searched the stored value is not needed, and may be wrong:
+    // the tables know nothing of en-passant rights
+    const bool noMoreMoves = moveCount > 0 && moveCount == moves.size();
+    WdlScore value;
+    if (noMoreMoves) {
+        value = bestValue;
+    } else {
+        value = WdlScore(probeTable(board, false, WdlScore::Draw, state));
+        if (state == ProbeState::Fail) return WdlScore::Draw;
+    }
+
+    if (bestValue >= value) {
+        state = bestValue > WdlScore::Draw || noMoreMoves ? ProbeState::ZeroingBestMove : ProbeState::Ok;
+        return bestValue;
+    }
+    state = ProbeState::Ok;
+    return value;
+}
+
+WdlScore Tablebases::probeWdl(Board& board, ProbeState& state) {
+    state = ProbeState::Ok;
+    return searchZeroing(board, false, state);
+}
+
+bool Tablebases::probeWdl(Board& board, WdlScore& wdl) {
+    ProbeState state;
+    wdl = probeWdl(board, state);
+    return state != ProbeState::Fail;
+}
+
+// Plies to the next zeroing move, positive when winning. Cursed wins and blessed
+// losses come out beyond 100.
+int Tablebases::probeDtz(Board& board, ProbeState& state) {
+    state = ProbeState::Ok;
+    const WdlScore wdl = searchZeroing(board, true, state);
+    if (state == ProbeState::Fail || wdl == WdlScore::Draw) return 0;
+
+    // The best move zeroes, so the stored value cannot be used
+    if (state == ProbeState::ZeroingBestMove) return dtzBeforeZeroing(wdl);
+
+    int dtz = probeTable(board, true, wdl, state);
+    if (state == ProbeState::Fail) return 0;
+    if (state != ProbeState::ChangeSideToMove) {
+        const bool cursed = wdl == WdlScore::BlessedLoss || wdl == WdlScore::CursedWin;
+        return (dtz + (cursed ? 100 : 0)) * signOf(int(wdl));
+    }
+
+    // The file holds the other side to move: take the best move by its DTZ
+    int minDtz = 0xFFFF;
+    MoveList moves;
+    board.generateLegalMoves(moves);
+    for (BoardMove move : moves) {
+        const bool zeroing = move.isCapture() || pieceType(board.pieceAt(move.from())) == PAWN;
+        board.makeMove(move);
+
+        // For a zeroing move the sign of the result is all that matters
+        ProbeState childState = ProbeState::Ok;
+        dtz = zeroing ? -dtzBeforeZeroing(searchZeroing(board, false, childState))
+                      : -probeDtz(board, childState);
+        if (dtz == 1 && isMate(board)) minDtz = 1;
+        if (!zeroing) dtz += signOf(dtz);
+        if (dtz < minDtz && signOf(dtz) == signOf(int(wdl))) minDtz = dtz;
+
+        board.unmakeMove();
+        if (childState == ProbeState::Fail) {
+            state = ProbeState::Fail;
+            return 0;
+        }
+    }
+    // No legal moves: mated
+    return minDtz == 0xFFFF ? -1 : minDtz;
+}
+
+bool Tablebases::probeDtz(Board& board, int& dtz) {
+    ProbeState state;
+    dtz = probeDtz(board, state);
+    return state != ProbeState::Fail;
+}
+
+bool Tablebases::rankRootMoves(Board& board, std::vector<TablebaseRootMove>& moves, bool *rankedByDtz) {
+    moves.clear();
+    if (!covers(board)) return false;
+    MoveList legal;
+    board.generateLegalMoves(legal);
+    for (BoardMove move : legal) moves.push_back({ move });
+
+    const bool dtz = rankWithDtz(board, moves);
+    if (rankedByDtz) *rankedByDtz = dtz;
+    if (dtz || rankWithWdl(board, moves)) return true;
+    moves.clear();
+    return false;
+}
+
+bool Tablebases::rankWithDtz(Board& board, std::vector<TablebaseRootMove>& moves) {
+    const int cnt50 = board.halfmoveClock();
+    const bool repeated = board.isRepetition();
+    ProbeState state;
+
+    for (TablebaseRootMove& root : moves) {
+        board.makeMove(root.move);
+        int dtz;
+        if (board.halfmoveClock() == 0) {
+            dtz = dtzBeforeZeroing(-probeWdl(board, state));
+        } else {
+            dtz = -probeDtz(board, state);
+            dtz = dtz > 0 ? dtz + 1 : dtz < 0 ? dtz - 1 : dtz;
+        }
+        if (dtz == 2 && isMate(board)) dtz = 1;
+        board.unmakeMove();
+        if (state == ProbeState::Fail) return false;
+
+        // Wins the counter still allows rank equally; beyond that, and for losses that
+        // the fifty-move rule may save, the distance decides
+        root.dtz = dtz;
+        root.rank = dtz > 0 ? (dtz + cnt50 <= 99 && !repeated ? 1000 : 1000 - (dtz + cnt50))
+                  : dtz < 0 ? (-dtz * 2 + cnt50 < 100 ? -1000 : -1000 + (-dtz + cnt50))
+                  : 0;
+        root.wdl = root.rank >= 900 ? WdlScore::Win
+                 : root.rank > 0 ? WdlScore::CursedWin
+                 : root.rank == 0 ? WdlScore::Draw
+                 : root.rank > -900 ? WdlScore::BlessedLoss
+                 : WdlScore::Loss;
+    }
+    return true;
+}
+
+bool Tablebases::rankWithWdl(Board& board, std::vector<TablebaseRootMove>& moves) {
+    static const int WdlToRank[] = { -1000, -899, 0, 899, 1000 };
+    ProbeState state;
+    for (TablebaseRootMove& root : moves) {
+        board.makeMove(root.move);
+        const WdlScore wdl = -probeWdl(board, state);
+        board.unmakeMove();
+        if (state == ProbeState::Fail) return false;
+        root.wdl = wdl;
+        root.rank = WdlToRank[int(wdl) + 2];
+        root.dtz = 0;
+    }
+    return true;
+}
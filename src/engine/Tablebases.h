@@ -0,0 +1,86 @@
+#ifndef TABLEBASES_H
+#define TABLEBASES_H
+
+#include <QString>
+#include <QStringList>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+#include "engine/Board.h"
+
+// Game-theoretic result for the side to move. A cursed win is a win that the
+// fifty-move rule turns into a draw; a blessed loss is the other side of one.
+enum class WdlScore : int { Loss = -2, BlessedLoss = -1, Draw = 0, CursedWin = 1, Win = 2 };
+
+inline WdlScore operator-(WdlScore wdl) { return WdlScore(-int(wdl)); }
+
+struct TablebaseRootMove {
+    BoardMove move;
+    int rank = 0;                 // higher is better, equal ranks are equally good
+    WdlScore wdl = WdlScore::Draw;
+    int dtz = 0;                  // plies to the next zeroing move after this one, 0 without DTZ
+};
+
+// Syzygy endgame tablebases (.rtbw for win/draw/loss, .rtbz for distance to zeroing).
+//
+// Construction only looks for the files; each one is memory-mapped and its index
+// read the first time a probe needs it. Probing follows the reference
+// implementation: captures (and for DTZ, pawn moves) are searched one ply, since
+// the tables store "don't care" values where such a move is best.
+//
+// A set of tables is replaced as a whole: searches take the current set when they
+// start and keep it until they finish, so the path can change at any time.
+class Tablebases {
+public:
+    static constexpr int MAX_PIECES = 7;
+
+    // paths lists directories separated as in PATH (';' on Windows, ':' elsewhere)
+    explicit Tablebases(const QString& paths);
+    ~Tablebases();
+    Tablebases(const Tablebases&) = delete;
+    Tablebases& operator=(const Tablebases&) = delete;
+
+    size_t tableCount() const { return tables.size() / 2; } // WDL and DTZ count as one
+    int maxPieces() const { return largest; }
+    // Few enough pieces and no castling rights, which the tables do not cover
+    bool covers(const Board& board) const;
+
+    // The board is restored before these return; false when a table is missing
+    bool probeWdl(Board& board, WdlScore& wdl);
+    bool probeDtz(Board& board, int& dtz);
+    // Ranks every legal move with DTZ when the files are there, otherwise with WDL.
+    // Wins that the fifty-move counter still allows rank highest.
+    bool rankRootMoves(Board& board, std::vector<TablebaseRootMove>& moves, bool *rankedByDtz = nullptr);
+
+    static std::shared_ptr<Tablebases> current();
+    static void setCurrent(std::shared_ptr<Tablebases> tablebases);
+
+    struct Table;
+
+private:
+    enum class ProbeState { Fail, Ok, ChangeSideToMove, ZeroingBestMove };
+
+    struct Entry {
+        Table *wdl;
+        Table *dtz;
+    };
+
+    QStringList directories;
+    std::vector<std::unique_ptr<Table>> tables;
+    std::unordered_map<uint64_t, Entry> byMaterial;
+    int largest = 0;
+    std::mutex mapMutex;
+
+    void addTable(const std::vector<PieceType>& pieces);
+    bool mapTable(Table& table);
+    int probeTable(const Board& board, bool dtz, WdlScore wdl, ProbeState& state);
+    WdlScore searchZeroing(Board& board, bool checkPawnMoves, ProbeState& state);
+    WdlScore probeWdl(Board& board, ProbeState& state);
+    int probeDtz(Board& board, ProbeState& state);
+    bool rankWithDtz(Board& board, std::vector<TablebaseRootMove>& moves);
+    bool rankWithWdl(Board& board, std::vector<TablebaseRootMove>& moves);
+};
+
+#endif // TABLEBASES_H
@@ -0,0 +1,63 @@
+#include "engine/TranspositionTable.h"
+
+#include <algorithm>
+
+TranspositionTable::TranspositionTable(size_t megabytes) {
+    resize(megabytes);
+}
+
+void TranspositionTable::resize(size_t mb) {
+    if (mb < 1) mb = 1;
+    // Round the bucket count down to a power of two so the index is a mask
+    size_t count = 1;
+    while (count * 2 * sizeof(Bucket) <= mb * 1024 * 1024) count *= 2;
+    megabytes = mb;
+    buckets.assign(count, Bucket());
+    generation = 0;
+}
+
+void TranspositionTable::clear() {
+    std::fill(buckets.begin(), buckets.end(), Bucket());
+    generation = 0;
+}
+
+bool TranspositionTable::probe(uint64_t key, TTEntry& entry) const {
+    const Bucket& bucket = bucketFor(key);
+    if (bucket.deep.key == key && bucket.deep.bound != Bound::None) {
+        entry = bucket.deep;
+        return true;
+    }
+    if (bucket.recent.key == key && bucket.recent.bound != Bound::None) {
+        entry = bucket.recent;
+        return true;
+    }
+    return false;
+}
+
+void TranspositionTable::store(uint64_t key, BoardMove move, int score, int staticEval, int depth, Bound bound) {
+    Bucket& bucket = bucketFor(key);
+    TTEntry* slot = &bucket.recent;
+    if (bucket.deep.key == key || bucket.deep.generation != generation || depth >= bucket.deep.depth) {
+        slot = &bucket.deep;
+    }
+    // Keep the previous best move when re-storing the same position without one
+    if (move.isNone() && slot->key == key) move = slot->move;
+
+    slot->key = key;
+    slot->move = move;
+    slot->score = int16_t(score);
+    slot->staticEval = int16_t(staticEval);
+    slot->depth = int8_t(depth);
+    slot->bound = bound;
+    slot->generation = generation;
+}
+
+int TranspositionTable::hashfull() const {
+    size_t sample = std::min<size_t>(500, buckets.size());
+    int used = 0;
+    for (size_t i = 0; i < sample; ++i) {
+        if (buckets[i].deep.bound != Bound::None && buckets[i].deep.generation == generation) used++;
+        if (buckets[i].recent.bound != Bound::None && buckets[i].recent.generation == generation) used++;
+    }
+    return int(used * 1000 / (sample * 2));
+}
@@ -0,0 +1,52 @@
+#ifndef TRANSPOSITIONTABLE_H
+#define TRANSPOSITIONTABLE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "engine/BoardMove.h"
+
+enum class Bound : uint8_t { None = 0, Upper = 1, Lower = 2, Exact = 3 };
+
+struct TTEntry {
+    uint64_t key = 0;
+    BoardMove move;
+    int16_t score = 0;
+    int16_t staticEval = 0;
+    int8_t depth = 0;
+    Bound bound = Bound::None;
+    uint8_t generation = 0;
+};
+
+// Shared hash table of search results, two entries per bucket:
+// one kept by depth, one always replaced.
+class TranspositionTable {
+public:
+    explicit TranspositionTable(size_t megabytes = 16);
+
+    void resize(size_t megabytes);
+    void clear();
+    void newSearch() { generation++; }
+
+    bool probe(uint64_t key, TTEntry& entry) const;
+    void store(uint64_t key, BoardMove move, int score, int staticEval, int depth, Bound bound);
+
+    // Permille of sampled entries written during the current search
+    int hashfull() const;
+    size_t sizeInMegabytes() const { return megabytes; }
+
+private:
+    struct Bucket {
+        TTEntry deep;
+        TTEntry recent;
+    };
+
+    std::vector<Bucket> buckets;
+    size_t megabytes = 0;
+    uint8_t generation = 0;
+
+    Bucket& bucketFor(uint64_t key) { return buckets[key & (buckets.size() - 1)]; }
+    const Bucket& bucketFor(uint64_t key) const { return buckets[key & (buckets.size() - 1)]; }
+};
+
+#endif // TRANSPOSITIONTABLE_H
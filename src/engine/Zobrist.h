@@ -0,0 +1,53 @@
+#ifndef ZOBRIST_H
+#define ZOBRIST_H
+
+#include <array>
+#include <cstdint>
+
+// Hash keys for incremental position hashing, generated at compile time from a fixed seed
+// so that keys are stable across builds and platforms.
+class Zobrist {
+public:
+    static uint64_t piece(int pieceCode, int sq) { return Keys.pieces[pieceCode][sq]; }
+    static uint64_t castling(int rights) { return Keys.castling[rights]; }
+    static uint64_t enPassant(int file) { return Keys.enPassant[file]; }
+    static uint64_t side() { return Keys.side; }
+
+private:
+    struct KeyTable {
+        uint64_t pieces[12][64];
+        uint64_t castling[16];
+        uint64_t enPassant[8];
+        uint64_t side;
+    };
+
+    static constexpr uint64_t splitMix64(uint64_t& state) {
+        uint64_t z = (state += 0x9E3779B97F4A7C15ULL);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+        return z ^ (z >> 31);
+    }
+
+    static constexpr KeyTable generate() {
+        KeyTable table{};
+        uint64_t state = 0x2545F4914F6CDD1DULL;
+        for (auto& square : table.pieces)
+            for (auto& key : square) key = splitMix64(state);
+        // Castling keys are the xor of the individual right keys so that rights can be toggled one at a time
+        uint64_t rightKeys[4] = { splitMix64(state), splitMix64(state), splitMix64(state), splitMix64(state) };
+        for (int rights = 0; rights < 16; ++rights) {
+            for (int bit = 0; bit < 4; ++bit) {
+                if (rights & (1 << bit)) table.castling[rights] ^= rightKeys[bit];
+            }
+        }
+        for (auto& key : table.enPassant) key = splitMix64(state);
+        table.side = splitMix64(state);
+        return table;
+    }
+
+    static const KeyTable Keys;
+};
+
+inline constexpr Zobrist::KeyTable Zobrist::Keys = Zobrist::generate();
+
+#endif // ZOBRIST_H
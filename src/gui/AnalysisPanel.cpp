@@ -0,0 +1,229 @@
+#include "gui/AnalysisPanel.h"
+#include "gui/Constants.h"
+#include "engine/EngineController.h"
+#include "engine/San.h"
+#include "engine/Tablebases.h"
+
+#include <QCheckBox>
+#include <QFormLayout>
+#include <QLabel>
+#include <QLocale>
+#include <QSpinBox>
+#include <QVBoxLayout>
+#include <QWidget>
+#include <QDebug>
+
+AnalysisPanel::AnalysisPanel(QWidget *parent)
+    : QDockWidget(tr("Analysis"), parent)
+{
+    setObjectName("AnalysisPanel");
+    setAllowedAreas(Qt::LeftDockWidgetArea | Qt::RightDockWidgetArea | Qt::BottomDockWidgetArea);
+
+    setupUi();
+    setEngine(new EngineController(this));
+}
+
+AnalysisPanel::~AnalysisPanel()
+{
+    engine->cancel();
+}
+
+void AnalysisPanel::setupUi()
+{
+    QWidget *content = new QWidget(this);
+    QVBoxLayout *layout = new QVBoxLayout(content);
+
+    analyseCheckBox = new QCheckBox(tr("Analyse position"), content);
+    linesSpinBox = new QSpinBox(content);
+    linesSpinBox->setRange(1, ChessConstants::MAX_ANALYSIS_LINES);
+    linesSpinBox->setValue(1);
+    positionLabel = new QLabel(content);
+    positionLabel->setWordWrap(true);
+
+    QFormLayout *statsLayout = new QFormLayout();
+    depthLabel = new QLabel("-", content);
+    scoreLabel = new QLabel("-", content);
+    scoreLabel->setStyleSheet("font-weight: bold;");
+    nodesLabel = new QLabel("-", content);
+    npsLabel = new QLabel("-", content);
+    tablebaseLabel = new QLabel("-", content);
+    statsLayout->addRow(tr("Lines:"), linesSpinBox);
+    statsLayout->addRow(tr("Depth:"), depthLabel);
+    statsLayout->addRow(tr("Score:"), scoreLabel);
+    statsLayout->addRow(tr("Nodes:"), nodesLabel);
+    statsLayout->addRow(tr("NPS:"), npsLabel);
+    statsLayout->addRow(tr("Tablebase:"), tablebaseLabel);
+
+    linesLabel = new QLabel(content);
+    linesLabel->setWordWrap(true);
+    linesLabel->setTextInteractionFlags(Qt::TextSelectableByMouse);
+    linesLabel->setAlignment(Qt::AlignTop | Qt::AlignLeft);
+
+    layout->addWidget(analyseCheckBox);
+    layout->addWidget(positionLabel);
+    layout->addLayout(statsLayout);
+    layout->addWidget(new QLabel(tr("Best lines:"), content));
+    layout->addWidget(linesLabel, 1);
+    content->setLayout(layout);
+    content->setMinimumWidth(200);
+    setWidget(content);
+
+    connect(analyseCheckBox, &QCheckBox::toggled, this, &AnalysisPanel::setAnalysing);
+    connect(linesSpinBox, QOverload<int>::of(&QSpinBox::valueChanged), this, &AnalysisPanel::setLineCount);
+}
+
+void AnalysisPanel::setEngine(ChessEngine *newEngine)
+{
+    if (engine) {
+        engine->cancel();
+        engine->deleteLater();
+    }
+    engine = newEngine;
+    engine->setParent(this);
+    connect(engine, &ChessEngine::searchInfo, this, &AnalysisPanel::handleSearchInfo);
+    connect(engine, &ChessEngine::engineError, positionLabel, &QLabel::setText);
+    setWindowTitle(tr("Analysis - %1").arg(engine->name()));
+    if (isAnalysing()) restartSearch();
+}
+
+bool AnalysisPanel::isAnalysing() const
+{
+    return analyseCheckBox && analyseCheckBox->isChecked();
+}
+
+void AnalysisPanel::setAnalysing(bool enabled)
+{
+    if (analyseCheckBox->isChecked() != enabled) {
+        analyseCheckBox->setChecked(enabled); // re-enters through toggled()
+        return;
+    }
+    if (enabled) {
+        restartSearch();
+    } else {
+        engine->cancel();
+    }
+}
+
+void AnalysisPanel::setLineCount(int lines)
+{
+    if (linesSpinBox->value() != lines) {
+        linesSpinBox->setValue(lines); // re-enters through valueChanged()
+        return;
+    }
+    if (isAnalysing()) restartSearch();
+}
+
+void AnalysisPanel::setPosition(const QString& fen, const QString& description)
+{
+    hasPosition = position.setFromFen(fen.toStdString());
+    if (!hasPosition) {
+        qWarning() << "AnalysisPanel: invalid FEN" << fen;
+    }
+    positionLabel->setText(description);
+    showTablebaseResult();
+    if (isAnalysing()) restartSearch();
+}
+
+void AnalysisPanel::refresh()
+{
+    showTablebaseResult();
+    if (isAnalysing()) restartSearch();
+}
+
+// A tablebase probe takes microseconds once the file is mapped, so it is done here on the
+// GUI thread and shown whether or not the engine is running
+void AnalysisPanel::showTablebaseResult()
+{
+    std::shared_ptr<Tablebases> tablebases = Tablebases::current();
+    Board board = position;
+    WdlScore wdl;
+    if (!hasPosition || !tablebases || !tablebases->covers(board) || !tablebases->probeWdl(board, wdl)) {
+        tablebaseLabel->setText("-");
+        return;
+    }
+
+    // From White's point of view, like the scores
+    const int whiteWdl = position.sideToMove() == WHITE ? int(wdl) : -int(wdl);
+    QString text = whiteWdl == 2 ? tr("TB win for White")
+                 : whiteWdl == 1 ? tr("TB draw (White wins without the 50-move rule)")
+                 : whiteWdl == 0 ? tr("TB draw")
+                 : whiteWdl == -1 ? tr("TB draw (Black wins without the 50-move rule)")
+                 : tr("TB win for Black");
+    int dtz;
+    if (wdl != WdlScore::Draw && tablebases->probeDtz(board, dtz)) {
+        text += tr(", DTZ %1").arg(std::abs(dtz));
+    }
+    tablebaseLabel->setText(text);
+}
+
+void AnalysisPanel::restartSearch()
+{
+    clearOutput();
+    if (!hasPosition) {
+        engine->cancel();
+        return;
+    }
+
+    MoveList legal;
+    position.generateLegalMoves(legal);
+    if (legal.empty()) {
+        engine->cancel();
+        scoreLabel->setText(position.inCheck() ? tr("Checkmate") : tr("Stalemate"));
+        return;
+    }
+
+    SearchLimits limits;
+    limits.infinite = true;
+    limits.infoIntervalMs = ChessConstants::ANALYSIS_UPDATE_INTERVAL_MS;
+    limits.multiPV = linesSpinBox->value();
+    engine->startSearch(position, limits);
+}
+
+void AnalysisPanel::clearOutput()
+{
+    depthLabel->setText("-");
+    scoreLabel->setText("-");
+    nodesLabel->setText("-");
+    npsLabel->setText("-");
+    linesLabel->clear();
+    lineTexts.clear();
+}
+
+void AnalysisPanel::handleSearchInfo(const SearchInfo& info)
+{
+    // Lines of one iteration arrive best first; the summary follows the best line
+    if (info.multiPv == 1) {
+        QLocale locale;
+        depthLabel->setText(QString("%1/%2").arg(info.depth).arg(info.selDepth));
+        scoreLabel->setText(formatScore(info.score));
+        nodesLabel->setText(locale.toString(qulonglong(info.nodes)));
+        npsLabel->setText(locale.toString(qulonglong(info.nps)));
+    }
+
+    int index = info.multiPv - 1;
+    if (index < 0 || index >= ChessConstants::MAX_ANALYSIS_LINES) return;
+    while (lineTexts.size() <= index) lineTexts.append(QString());
+    lineTexts[index] = QString("%1. %2  %3").arg(info.multiPv).arg(formatScore(info.score), formatPv(info.pv));
+    linesLabel->setText(lineTexts.join('\n'));
+}
+
+QString AnalysisPanel::formatScore(int score) const
+{
+    // Engine scores are from the side to move; show them from White's point of view
+    int whiteScore = position.sideToMove() == WHITE ? score : -score;
+    if (Search::isMateScore(whiteScore)) {
+        int moves = Search::mateInMoves(whiteScore);
+        return moves > 0 ? QString("#%1").arg(moves) : QString("-#%1").arg(-moves);
+    }
+    if (Search::isTablebaseScore(whiteScore)) {
+        return whiteScore > 0 ? tr("TB win") : tr("TB loss");
+    }
+    return QString("%1%2").arg(whiteScore >= 0 ? "+" : "").arg(whiteScore / 100.0, 0, 'f', 2);
+}
+
+QString AnalysisPanel::formatPv(const std::vector<BoardMove>& pv) const
+{
+    std::string text;
+    San::writeMoves(position, pv.data(), pv.size(), text);
+    return QString::fromStdString(text);
+}
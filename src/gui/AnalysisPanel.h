@@ -0,0 +1,63 @@
+#ifndef ANALYSISPANEL_H
+#define ANALYSISPANEL_H
+
+#include <QDockWidget>
+#include <QStringList>
+#include "engine/Board.h"
+#include "engine/Search.h"
+
+class QCheckBox;
+class QLabel;
+class QSpinBox;
+class ChessEngine;
+
+// Dockable panel that runs an infinite engine search on the position it is given
+// and shows depth, score, node counts and the best lines as they arrive.
+class AnalysisPanel : public QDockWidget
+{
+    Q_OBJECT
+
+public:
+    explicit AnalysisPanel(QWidget *parent = nullptr);
+    ~AnalysisPanel() override;
+
+    // Restarts the analysis on a new position; the previous search is cancelled without waiting
+    void setPosition(const QString& fen, const QString& description);
+    bool isAnalysing() const;
+    // Switches to another engine; the panel takes ownership and restarts the analysis
+    void setEngine(ChessEngine *newEngine);
+
+public slots:
+    void setAnalysing(bool enabled);
+    void setLineCount(int lines);
+    // Probes the tablebases again and restarts the analysis, e.g. after new tables were loaded
+    void refresh();
+
+private slots:
+    void handleSearchInfo(const SearchInfo& info);
+
+private:
+    ChessEngine *engine = nullptr;
+    QCheckBox *analyseCheckBox = nullptr;
+    QSpinBox *linesSpinBox = nullptr;
+    QLabel *positionLabel = nullptr;
+    QLabel *depthLabel = nullptr;
+    QLabel *scoreLabel = nullptr;
+    QLabel *nodesLabel = nullptr;
+    QLabel *npsLabel = nullptr;
+    QLabel *tablebaseLabel = nullptr;
+    QLabel *linesLabel = nullptr;
+    QStringList lineTexts; // one formatted line per multi-PV rank
+
+    Board position;
+    bool hasPosition = false;
+
+    void setupUi();
+    void restartSearch();
+    void clearOutput();
+    void showTablebaseResult();
+    QString formatScore(int score) const;
+    QString formatPv(const std::vector<BoardMove>& pv) const;
+};
+
+#endif // ANALYSISPANEL_H
@@ -17,6 +17,13 @@ namespace ChessConstants {
     inline const QColor SELECTION_HIGHLIGHT_COLOR = QColor(255, 255, 0, 100);
     inline const QColor MOVE_INDICATOR_COLOR = QColor(0, 0, 0, 70);
 
+    inline constexpr int ENGINE_MOVE_TIME_MS = 1000;
+    inline constexpr int HINT_TIME_MS = 1500;
+    inline constexpr int MATE_SEARCH_TIME_MS = 30000;
+    inline constexpr int MATE_SEARCH_MAX_MOVES = 30;
+    inline constexpr int ANALYSIS_UPDATE_INTERVAL_MS = 100;
+    inline constexpr int MAX_ANALYSIS_LINES = 5;
+
     inline const QMap<char, QChar> PIECE_UNICODE_MAP = {
         { 'K', QChar(0x265A) }, { 'Q', QChar(0x265B) }, { 'R', QChar(0x265C) },
         { 'B', QChar(0x265D) }, { 'N', QChar(0x265E) }, { 'P', QChar(0x265F) }
@@ -5,7 +5,17 @@
 #include "gui/GameLoadDialog.h"
 #include "model/ChessModel.h"
 #include "core/Utils.h"
+#include "core/FenUtils.h"
 #include "model/DatabaseManager.h"
+#include "model/PgnExporter.h"
+#include "engine/Bitbases.h"
+#include "engine/EngineController.h"
+#include "engine/ExternalEngine.h"
+#include "engine/MateSolver.h"
+#include "engine/OpeningBook.h"
+#include "engine/Tablebases.h"
+#include "gui/AnalysisPanel.h"
+#include "gui/Constants.h"
 
 #include <QApplication>
 #include <QWidget>
@@ -14,12 +24,16 @@
 #include <QSplitter>
 #include <QListWidget>
 #include <QMessageBox>
+#include <QFileDialog>
+#include <QInputDialog>
 #include <QLabel>
 #include <QStatusBar>
 #include <QMenuBar>
 #include <QAction>
+#include <QKeySequence>
 #include <QDebug>
 #include <QSpacerItem>
+#include <QSignalBlocker>
 
 MainWindow::MainWindow(QWidget *parent)
     : QMainWindow(parent), fullMoveNumber(1), halfMoveClock(0), currentGameId(-1)
@@ -31,6 +45,9 @@ MainWindow::MainWindow(QWidget *parent)
          qDebug() << "Database initialized successfully.";
     }
 
+    engine = new EngineController(this);
+    openingBook = new OpeningBook();
+
     setupUi(); 
     setupConnections();
     updateStatus();
@@ -38,22 +55,48 @@ MainWindow::MainWindow(QWidget *parent)
 
 MainWindow::~MainWindow()
 {
+    // Stop the engine thread before the model goes away
+    delete engine;
+    engine = nullptr;
+    if (mateThread.joinable()) {
+        mateSolver->stop();
+        mateThread.join();
+    }
+    delete mateSolver;
+    delete openingBook;
     delete chessModel;
 }
 
 void MainWindow::setupUi()
 {
     setWindowTitle(tr("Chess"));
-    resize(890, 650);
+    resize(1120, 650);
 
     // Menu Bar
     QMenuBar *menuBar = this->menuBar();
     QMenu *gameMenu = menuBar->addMenu(tr("&Game"));
     QAction *newGameAction = gameMenu->addAction(tr("&New Game"));
     QAction *loadGameAction = gameMenu->addAction(tr("&Load Game"));
+    QAction *exportGamesAction = gameMenu->addAction(tr("&Export Games to PGN..."));
     gameMenu->addSeparator();
     QAction *quitAction = gameMenu->addAction(tr("&Quit"));
 
+    QMenu *engineMenu = menuBar->addMenu(tr("&Engine"));
+    playVsComputerAction = engineMenu->addAction(tr("Play vs &Computer"));
+    playVsComputerAction->setCheckable(true);
+    hintAction = engineMenu->addAction(tr("&Hint"));
+    hintAction->setShortcut(QKeySequence(tr("H")));
+    ponderAction = engineMenu->addAction(tr("&Ponder on Your Time"));
+    ponderAction->setCheckable(true);
+    ponderAction->setChecked(true);
+    findMateAction = engineMenu->addAction(tr("Find &Mate..."));
+    engineMenu->addSeparator();
+    QAction *externalEngineAction = engineMenu->addAction(tr("Use &External Engine..."));
+    QAction *builtInEngineAction = engineMenu->addAction(tr("Use &Built-in Engine"));
+    QAction *openBookAction = engineMenu->addAction(tr("Opening &Book..."));
+    QAction *tablebasesAction = engineMenu->addAction(tr("Syzygy &Tablebases..."));
+    QAction *bitbasesAction = engineMenu->addAction(tr("Endgame B&itbases..."));
+
     // Central Widget
     QWidget *centralWidget = new QWidget(this);
     setCentralWidget(centralWidget);
@@ -118,13 +161,34 @@ void MainWindow::setupUi()
     mainLayout->addWidget(splitter);
     centralWidget->setLayout(mainLayout);
 
+    // Analysis dock, next to the side panel
+    analysisPanel = new AnalysisPanel(this);
+    addDockWidget(Qt::RightDockWidgetArea, analysisPanel);
+    engineMenu->addSeparator();
+    engineMenu->addAction(analysisPanel->toggleViewAction());
+
     // Status Bar
     statusBar()->showMessage(tr("Ready"));
 
     // Connect Menu Actions
     connect(newGameAction, &QAction::triggered, this, &MainWindow::startNewGame);
     connect(loadGameAction, &QAction::triggered, this, &MainWindow::loadGame);
+    connect(exportGamesAction, &QAction::triggered, this, &MainWindow::exportGames);
     connect(quitAction, &QAction::triggered, qApp, &QApplication::quit);
+    // The window outlives the event loop, so commit the queued moves when it ends
+    connect(qApp, &QCoreApplication::aboutToQuit, dbManager, &DatabaseManager::flushMoves);
+    connect(dbManager, &DatabaseManager::movesNotSaved, this, &MainWindow::handleMovesNotSaved);
+    connect(playVsComputerAction, &QAction::toggled, this, &MainWindow::togglePlayVsComputer);
+    connect(hintAction, &QAction::triggered, this, &MainWindow::requestHint);
+    connect(externalEngineAction, &QAction::triggered, this, &MainWindow::chooseExternalEngine);
+    connect(builtInEngineAction, &QAction::triggered, this, &MainWindow::useBuiltInEngine);
+    connect(openBookAction, &QAction::triggered, this, &MainWindow::openOpeningBook);
+    connect(tablebasesAction, &QAction::triggered, this, &MainWindow::chooseTablebases);
+    connect(bitbasesAction, &QAction::triggered, this, &MainWindow::chooseBitbases);
+    connect(findMateAction, &QAction::triggered, this, &MainWindow::findMate);
+    connect(ponderAction, &QAction::toggled, this, [this](bool enabled) {
+        if (!enabled && isPonderTask()) cancelEngineTask();
+    });
 }
 
 
@@ -135,10 +199,44 @@ void MainWindow::setupConnections()
     } else {
         qWarning() << "setupConnections: boardWidget is null!";
     }
+    connectEngine();
+    connect(moveHistoryWidget, &QListWidget::currentRowChanged, this, &MainWindow::handleHistorySelection);
 }
 
 void MainWindow::handleMoveAttempt(const Move& move) {
-    if (!chessModel || !boardWidget || !dbManager || chessModel->isGameOver()) return;
+    if (!chessModel || !boardWidget) return;
+
+    if (isComputerTurn()) {
+        statusBar()->showMessage(tr("The computer is thinking."), 2000);
+        boardWidget->resetInteractionState();
+        return;
+    }
+    // A pending hint is for the position before this move
+    if (engineTask == EngineTask::Hint) cancelEngineTask();
+
+    if (engineTask == EngineTask::Ponder) {
+        Board before;
+        bool hit = before.setFromFen(chessModel->getCurrentFEN()) && before.fromModelMove(move) == expectedReply;
+        if (hit && applyMove(move)) {
+            // The engine has been searching this position all along; let it finish on its clock
+            engine->ponderHit();
+            engineTask = EngineTask::ComputerMove;
+            statusBar()->showMessage(tr("Computer is thinking..."));
+            return;
+        }
+        cancelEngineTask();
+    } else if (engineTask == EngineTask::PonderAll) {
+        cancelEngineTask();
+    }
+
+    // On a ponder miss the hash table still holds the pondered lines, so this search starts warm
+    if (applyMove(move)) {
+        startComputerMove();
+    }
+}
+
+bool MainWindow::applyMove(const Move& move) {
+    if (!chessModel || !boardWidget || !dbManager || chessModel->isGameOver()) return false;
 
     if (currentGameId < 0 && !chessModel->isGameOver()) { 
          qWarning() << "Attempted move but no active game ID is set. Move not saved.";
@@ -149,24 +247,24 @@ void MainWindow::handleMoveAttempt(const Move& move) {
     bool isPawnMove = (movingPiece && movingPiece->type == 'P');
     bool isCapture = (capturedPiece != nullptr) || (movingPiece && movingPiece->type == 'P' && chessModel->getEnPassantTarget() && move.to == *(chessModel->getEnPassantTarget())); // Check EP
 
-    std::string sanBase = Utils::moveToSAN(move, *chessModel);
-    qDebug() << "Attempting move:" << QString::fromStdString(sanBase);
+    // Written before the move, with its check or mate suffix
+    const QString sanFull = QString::fromStdString(Utils::moveToSAN(move, *chessModel));
+    qDebug() << "Attempting move:" << sanFull;
 
     bool success = chessModel->makeMove(move);
 
     if (success) {
-        qDebug() << "Move successful:" << QString::fromStdString(sanBase);
+        qDebug() << "Move successful:" << sanFull;
 
         boardWidget->resetInteractionState(false); 
-        std::string fenAfterMove = chessModel->getCurrentFEN();
-        QString sanFull = QString::fromStdString(sanBase);
-        if (chessModel->getIsCheckmate()) sanFull += '#';
-        else if (chessModel->isInCheck()) sanFull += '+';
+        char fenBuffer[FenUtils::FEN_BUFFER_SIZE];
+        const QString fenAfterMove = QString::fromLatin1(fenBuffer, int(FenUtils::writeFen(*chessModel, fenBuffer)));
+        positionHistory.append(fenAfterMove);
 
         bool isWhiteTurnJustEnded = !chessModel->isWhiteToMove(); 
 
         if (currentGameId >= 0) {
-            if (!dbManager->saveMove(currentGameId, fullMoveNumber, isWhiteTurnJustEnded, move, sanFull, QString::fromStdString(fenAfterMove))) {
+            if (!dbManager->saveMove(currentGameId, fullMoveNumber, isWhiteTurnJustEnded, move, sanFull, fenAfterMove)) {
                  qWarning() << "Failed to save move to database for game" << currentGameId;
                  
             }
@@ -191,6 +289,7 @@ void MainWindow::handleMoveAttempt(const Move& move) {
         if (whiteCapturedWidget) whiteCapturedWidget->update();
         if (blackCapturedWidget) blackCapturedWidget->update();
         updateStatus();
+        analyseLivePosition();
 
         if (chessModel->isGameOver()) {
              QString endMessage;
@@ -204,17 +303,285 @@ void MainWindow::handleMoveAttempt(const Move& move) {
                  endMessage = QString("Stalemate! Game is a draw.");
              }
              if (currentGameId >= 0 && !resultStr.isEmpty()) {
-                 dbManager->finishGame(currentGameId, resultStr, QString::fromStdString(fenAfterMove));
+                 dbManager->finishGame(currentGameId, resultStr, fenAfterMove);
              }
 
              showGameOverMessage(endMessage);
              boardWidget->setEnabled(false); 
         }
+        return true;
 
     } else {
         qDebug() << "Invalid move rejected by model.";
         statusBar()->showMessage(tr("Invalid move."), 2000);
+        return false;
+    }
+}
+
+bool MainWindow::isComputerTurn() const {
+    return playVsComputer && chessModel && !chessModel->isGameOver()
+           && chessModel->isWhiteToMove() == computerPlaysWhite;
+}
+
+void MainWindow::cancelEngineTask() {
+    if (engine) engine->cancel();
+    engineTask = EngineTask::None;
+}
+
+void MainWindow::connectEngine() {
+    connect(engine, &ChessEngine::bestMoveFound, this, &MainWindow::handleEngineBestMove);
+    connect(engine, &ChessEngine::engineError, this, &MainWindow::handleEngineError);
+}
+
+// The game and the analysis panel each get their own instance, as with the built-in engine
+void MainWindow::replaceEngines(ChessEngine *playEngine, ChessEngine *analysisEngine) {
+    cancelEngineTask();
+    delete engine;
+    engine = playEngine;
+    engine->setParent(this);
+    connectEngine();
+    analysisPanel->setEngine(analysisEngine);
+    statusBar()->showMessage(tr("Using %1.").arg(engine->name()), 3000);
+    startComputerMove();
+}
+
+void MainWindow::chooseExternalEngine() {
+    QString program = QFileDialog::getOpenFileName(this, tr("Choose UCI Engine"));
+    if (program.isEmpty()) return;
+    replaceEngines(new ExternalEngine(program), new ExternalEngine(program));
+}
+
+void MainWindow::useBuiltInEngine() {
+    replaceEngines(new EngineController(), new EngineController());
+}
+
+void MainWindow::openOpeningBook() {
+    QString path = QFileDialog::getOpenFileName(this, tr("Open Opening Book"), QString(),
+                                                tr("Polyglot books (*.bin);;All files (*)"));
+    if (path.isEmpty()) return;
+    if (!openingBook->open(path)) {
+        QMessageBox::warning(this, tr("Opening Book"), tr("Could not open %1 as a Polyglot book.").arg(path));
+        return;
+    }
+    statusBar()->showMessage(tr("Opening book loaded: %1 entries.").arg(openingBook->entryCount()), 3000);
+    if (engineTask == EngineTask::None) startComputerMove();
+}
+
+void MainWindow::chooseTablebases() {
+    QString directory = QFileDialog::getExistingDirectory(this, tr("Syzygy Tablebase Folder"));
+    if (directory.isEmpty()) return;
+    // Searches already running keep the tables they started with
+    auto tablebases = std::make_shared<Tablebases>(directory);
+    if (tablebases->tableCount() == 0) {
+        QMessageBox::warning(this, tr("Syzygy Tablebases"), tr("No Syzygy tablebases (*.rtbw) found in %1.").arg(directory));
+        return;
+    }
+    Tablebases::setCurrent(tablebases);
+    statusBar()->showMessage(tr("%1 tablebases loaded, up to %2 pieces.")
+                             .arg(tablebases->tableCount()).arg(tablebases->maxPieces()), 3000);
+    analysisPanel->refresh();
+}
+
+void MainWindow::chooseBitbases() {
+    QString directory = QFileDialog::getExistingDirectory(this, tr("Endgame Bitbase Folder"));
+    if (directory.isEmpty()) return;
+    auto bitbases = std::make_shared<Bitbases>(directory);
+    if (bitbases->tableCount() == 0) {
+        QMessageBox::warning(this, tr("Endgame Bitbases"), tr("No bitbases (*.bb) found in %1.").arg(directory));
+        return;
+    }
+    Bitbases::setCurrent(bitbases);
+    statusBar()->showMessage(tr("%1 bitbases loaded.").arg(bitbases->tableCount()), 3000);
+}
+
+void MainWindow::findMate() {
+    if (!chessModel || chessModel->isGameOver() || mateThread.joinable()) return;
+    Board snapshot;
+    if (!snapshot.setFromFen(chessModel->getCurrentFEN())) return;
+
+    bool ok = false;
+    const int moves = QInputDialog::getInt(this, tr("Find Mate"), tr("Mate in at most (moves):"), 5,
+                                           1, ChessConstants::MATE_SEARCH_MAX_MOVES, 1, &ok);
+    if (!ok) return;
+
+    // The solver runs on a thread of its own and reports back through the event loop
+    if (!mateSolver) mateSolver = new MateSolver();
+    MateSolver::Limits limits;
+    limits.maxMoves = moves;
+    limits.moveTimeMs = ChessConstants::MATE_SEARCH_TIME_MS;
+    limits.shortest = true;
+    mateSolver->clearStop();
+    findMateAction->setEnabled(false);
+    statusBar()->showMessage(tr("Looking for a mate in %1...").arg(moves));
+    mateThread = std::thread([this, snapshot, limits]() {
+        const MateSolver::Result result = mateSolver->solve(snapshot, limits);
+        QMetaObject::invokeMethod(this, [this, result, limits]() {
+            mateThread.join();
+            findMateAction->setEnabled(true);
+            statusBar()->clearMessage();
+            if (result.status == MateSolver::Status::Mate) {
+                QStringList line;
+                for (BoardMove move : result.line) line << QString::fromStdString(move.toUci());
+                QMessageBox::information(this, tr("Find Mate"), tr("Mate in %1 (%2 nodes, %3 ms):\n%4")
+                                         .arg(result.mateIn).arg(result.nodes).arg(result.timeMs)
+                                         .arg(line.join(' ')));
+            } else if (result.status == MateSolver::Status::NoMate) {
+                QMessageBox::information(this, tr("Find Mate"), tr("There is no forced mate in %1.").arg(limits.maxMoves));
+            } else {
+                QMessageBox::information(this, tr("Find Mate"), tr("No mate found within %1 seconds.")
+                                         .arg(ChessConstants::MATE_SEARCH_TIME_MS / 1000));
+            }
+        }, Qt::QueuedConnection);
+    });
+}
+
+void MainWindow::handleEngineError(const QString& message) {
+    engineTask = EngineTask::None;
+    qWarning() << message;
+    QMessageBox::warning(this, tr("Engine Error"), message);
+}
+
+void MainWindow::handleMovesNotSaved(int count, const QString& error) {
+    QMessageBox::warning(this, tr("Database Error"),
+                         tr("%n move(s) could not be saved to the game database: %1", nullptr, count).arg(error));
+}
+
+bool MainWindow::isPonderTask() const {
+    return engineTask == EngineTask::Ponder || engineTask == EngineTask::PonderAll;
+}
+
+void MainWindow::startPondering(const SearchResult& result) {
+    if (!engine || !ponderAction->isChecked() || !playVsComputer || !chessModel
+        || chessModel->isGameOver() || isComputerTurn()) return;
+
+    Board snapshot;
+    if (!snapshot.setFromFen(chessModel->getCurrentFEN())) return;
+
+    // Search the position after the expected reply as if it were the computer's turn already
+    SearchLimits limits;
+    limits.moveTimeMs = ChessConstants::ENGINE_MOVE_TIME_MS;
+    limits.ponder = true;
+    expectedReply = result.ponderMove;
+    // The round trip through the model's move type also rules out under-promotions the board cannot play
+    if (!expectedReply.isNone() && snapshot.fromModelMove(Board::toModelMove(expectedReply)) == expectedReply) {
+        snapshot.makeMove(expectedReply);
+        engineTask = EngineTask::Ponder;
+        engine->startSearch(snapshot, limits);
+        return;
+    }
+
+    // No expected reply: search the human's own position so every candidate reply gets hash entries
+    expectedReply = BoardMove::none();
+    limits = SearchLimits();
+    limits.infinite = true;
+    engineTask = EngineTask::PonderAll;
+    engine->startSearch(snapshot, limits);
+}
+
+void MainWindow::startComputerMove() {
+    if (!engine || !isComputerTurn()) return;
+
+    Board snapshot;
+    if (!snapshot.setFromFen(chessModel->getCurrentFEN())) {
+        qWarning() << "startComputerMove: could not build engine position from FEN.";
+        return;
+    }
+    // Book moves are played at once, whichever engine is in use
+    BoardMove bookMove = openingBook->pickMove(snapshot);
+    if (!bookMove.isNone()) {
+        statusBar()->showMessage(tr("Book move."), 2000);
+        if (!applyMove(Board::toModelMove(bookMove))) {
+            qWarning() << "Book move" << QString::fromStdString(bookMove.toUci()) << "was rejected by the model.";
+        }
+        return;
     }
+
+    SearchLimits limits;
+    limits.moveTimeMs = ChessConstants::ENGINE_MOVE_TIME_MS;
+    engineTask = EngineTask::ComputerMove;
+    engine->startSearch(snapshot, limits);
+    statusBar()->showMessage(tr("Computer is thinking..."));
+}
+
+void MainWindow::togglePlayVsComputer(bool enabled) {
+    if (playVsComputer == enabled) return;
+    playVsComputer = enabled;
+    if (!enabled) {
+        if (engineTask == EngineTask::ComputerMove || isPonderTask()) cancelEngineTask();
+        statusBar()->showMessage(tr("Two-player mode."), 3000);
+        return;
+    }
+    // The human keeps the side that is to move now
+    computerPlaysWhite = chessModel && !chessModel->isWhiteToMove();
+    statusBar()->showMessage(tr("Playing against the computer as %1.")
+                                 .arg(computerPlaysWhite ? tr("Black") : tr("White")), 3000);
+    startComputerMove();
+}
+
+void MainWindow::requestHint() {
+    if (!engine || !chessModel || chessModel->isGameOver() || isComputerTurn()) return;
+
+    Board snapshot;
+    if (!snapshot.setFromFen(chessModel->getCurrentFEN())) return;
+    BoardMove bookMove = openingBook->pickMove(snapshot);
+    if (!bookMove.isNone()) {
+        QString san = QString::fromStdString(Utils::moveToSAN(Board::toModelMove(bookMove), *chessModel));
+        statusBar()->showMessage(tr("Hint: %1 (book)").arg(san), 5000);
+        return;
+    }
+    SearchLimits limits;
+    limits.moveTimeMs = ChessConstants::HINT_TIME_MS;
+    engineTask = EngineTask::Hint;
+    engine->startSearch(snapshot, limits);
+    statusBar()->showMessage(tr("Looking for a hint..."));
+}
+
+void MainWindow::handleEngineBestMove(const SearchResult& result) {
+    EngineTask task = engineTask;
+    engineTask = EngineTask::None;
+    if (result.bestMove.isNone() || !chessModel) return;
+
+    Move move = Board::toModelMove(result.bestMove);
+    if (task == EngineTask::ComputerMove) {
+        if (!isComputerTurn()) return;
+        statusBar()->clearMessage();
+        if (!applyMove(move)) {
+            qWarning() << "Engine move" << QString::fromStdString(result.bestMove.toUci()) << "was rejected by the model.";
+            return;
+        }
+        startPondering(result);
+    } else if (task == EngineTask::Hint) {
+        QString san = QString::fromStdString(Utils::moveToSAN(move, *chessModel));
+        statusBar()->showMessage(tr("Hint: %1").arg(san), 5000);
+    }
+}
+
+void MainWindow::resetPositionHistory(const QString& startFen, const QList<QString>& fenAfterMoves) {
+    positionHistory.clear();
+    positionHistory.append(startFen);
+    positionHistory.append(fenAfterMoves);
+}
+
+void MainWindow::analyseLivePosition() {
+    if (!analysisPanel || !chessModel) return;
+    if (moveHistoryWidget) {
+        QSignalBlocker blocker(moveHistoryWidget);
+        moveHistoryWidget->setCurrentRow(-1);
+    }
+    analysisPanel->setPosition(QString::fromStdString(chessModel->getCurrentFEN()), tr("Current position"));
+}
+
+void MainWindow::handleHistorySelection(int row) {
+    if (!analysisPanel || !moveHistoryWidget) return;
+    int plies = positionHistory.size() - 1;
+    if (row < 0 || plies <= 0) {
+        analyseLivePosition();
+        return;
+    }
+    // Each row holds a White and a Black move; analyse the position after the last one shown
+    int ply = qMin(2 * row + 2, plies);
+    QListWidgetItem *item = moveHistoryWidget->item(row);
+    analysisPanel->setPosition(positionHistory[ply], tr("After %1").arg(item ? item->text() : QString::number(ply)));
 }
 
 void MainWindow::updateMoveHistory(const QString& sanMove) {
@@ -301,12 +668,14 @@ void MainWindow::showGameOverMessage(const QString& message) {
 }
 
 void MainWindow::startNewGame() {
+     cancelEngineTask();
      fullMoveNumber = 1;
      halfMoveClock = 0;
      currentGameId = -1;
 
      if (chessModel) {
          chessModel->setupStartingPosition();
+         resetPositionHistory(QString::fromStdString(chessModel->getCurrentFEN()));
      } else {
          qWarning() << "startNewGame: chessModel is null!";
          return; 
@@ -340,6 +709,8 @@ void MainWindow::startNewGame() {
      updateStatus();
      qDebug() << "New game setup complete.";
      statusBar()->showMessage(tr("New Game Started."), 3000);
+     analyseLivePosition();
+     startComputerMove();
 }
 
 bool MainWindow::loadGame() {
@@ -360,13 +731,17 @@ bool MainWindow::loadGame() {
 
         qDebug() << "User selected game ID:" << selectedGameId;
 
+        cancelEngineTask();
         QList<QString> sanMovesList;
-        if (dbManager->loadGameMoves(selectedGameId, chessModel, sanMovesList)) {
+        QList<QString> fenAfterMoves;
+        QString startFen;
+        if (dbManager->loadGameMoves(selectedGameId, chessModel, sanMovesList, &fenAfterMoves, &startFen)) {
+            resetPositionHistory(startFen, fenAfterMoves);
             currentGameId = selectedGameId;
-            fullMoveNumber = (sanMovesList.size() / 2) + 1;
-            // Determine halfMoveClock based on last moves if possible, or reset
-            // For simplicity, we'll reset it here. 
-            halfMoveClock = 0;
+            // The model replayed the game, or took the last FEN with counters worked out from
+            // the moves, so its clocks are those of the last position
+            fullMoveNumber = chessModel->getFullmoveNumber();
+            halfMoveClock = chessModel->getHalfmoveClock();
 
             if (boardWidget) {
                 boardWidget->resetInteractionState();
@@ -381,9 +756,11 @@ bool MainWindow::loadGame() {
 
             populateMoveHistory(sanMovesList);
             updateStatus(); 
+            analyseLivePosition();
 
             statusBar()->showMessage(QString("Loaded game %1.").arg(selectedGameId), 3000);
             qDebug() << "Game" << selectedGameId << "loaded successfully.";
+            startComputerMove();
             return true;
 
         } else {
@@ -396,3 +773,23 @@ bool MainWindow::loadGame() {
         return false; 
     }
 }
+
+void MainWindow::exportGames() {
+    if (!dbManager) return;
+    QString path = QFileDialog::getSaveFileName(this, tr("Export Games"), "games.pgn",
+                                                tr("PGN files (*.pgn);;All files (*)"));
+    if (path.isEmpty()) return;
+
+    // The export has its own connection and streams the database, so a large one only
+    // takes time, not memory
+    dbManager->flushMoves();
+    PgnExporter exporter(dbManager->databasePath());
+    QApplication::setOverrideCursor(Qt::WaitCursor);
+    const bool ok = exporter.exportTo(path.toStdString());
+    QApplication::restoreOverrideCursor();
+    if (!ok) {
+        QMessageBox::warning(this, tr("Export Games"), tr("Could not export the games to %1.").arg(path));
+        return;
+    }
+    statusBar()->showMessage(tr("Exported %1 games to %2.").arg(exporter.stats().games).arg(path), 3000);
+}
@@ -2,7 +2,10 @@
 #define MAINWINDOW_H
 
 #include <QMainWindow>
+#include <QStringList>
+#include <thread>
 #include "model/DatabaseManager.h" 
+#include "engine/Search.h"
 
 class ChessBoardWidget;
 class ChessModel;
@@ -10,6 +13,11 @@ class QLabel;
 class Move;
 class QListWidget;
 class CapturedPiecesWidget;
+class ChessEngine;
+class OpeningBook;
+class AnalysisPanel;
+class MateSolver;
+class QAction;
 
 class MainWindow : public QMainWindow
 {
@@ -25,6 +33,19 @@ public slots:
 
 private slots:
     void handleMoveAttempt(const Move& move);
+    void togglePlayVsComputer(bool enabled);
+    void requestHint();
+    void handleEngineBestMove(const SearchResult& result);
+    void handleHistorySelection(int row);
+    void chooseExternalEngine();
+    void openOpeningBook();
+    void chooseTablebases();
+    void chooseBitbases();
+    void exportGames();
+    void findMate();
+    void useBuiltInEngine();
+    void handleEngineError(const QString& message);
+    void handleMovesNotSaved(int count, const QString& error);
 
 private:
     ChessBoardWidget *boardWidget = nullptr;
@@ -39,8 +60,37 @@ private:
     DatabaseManager *dbManager = nullptr;
     qint64 currentGameId = -1; 
 
+    // Ponder: searching the position after the expected reply; PonderAll: searching the
+    // human's position itself when no reply is expected, to fill the hash table
+    enum class EngineTask { None, ComputerMove, Hint, Ponder, PonderAll };
+    ChessEngine *engine = nullptr;
+    QAction *playVsComputerAction = nullptr;
+    QAction *hintAction = nullptr;
+    QAction *ponderAction = nullptr;
+    QAction *findMateAction = nullptr;
+    bool playVsComputer = false;
+    bool computerPlaysWhite = false;
+    EngineTask engineTask = EngineTask::None;
+    BoardMove expectedReply;
+
+    OpeningBook *openingBook = nullptr;
+    AnalysisPanel *analysisPanel = nullptr;
+    MateSolver *mateSolver = nullptr;
+    std::thread mateThread;
+    QStringList positionHistory; // FEN of the start position followed by the FEN after each ply
+
     void setupUi();
     void setupConnections();
+    bool applyMove(const Move& move);
+    bool isComputerTurn() const;
+    void startComputerMove();
+    void startPondering(const SearchResult& result);
+    bool isPonderTask() const;
+    void cancelEngineTask();
+    void connectEngine();
+    void replaceEngines(ChessEngine *playEngine, ChessEngine *analysisEngine);
+    void resetPositionHistory(const QString& startFen, const QList<QString>& fenAfterMoves = {});
+    void analyseLivePosition();
     void updateStatus();
     void showGameOverMessage(const QString& message);
     void updateMoveHistory(const QString& sanMove);
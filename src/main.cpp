@@ -4,23 +4,125 @@
 #include "model/ChessModel.h"
 #include "gui/ChessView.h"
 #include "controller/ChessController.h"
+#include "controller/UciController.h"
+#include "controller/ToolCommands.h"
+#include <QCoreApplication>
 #include <iostream>
 #include <string>
 #include <vector>
 int main(int argc, char *argv[])
 {
     bool consoleMode = false;
+    bool uciMode = false;
+    size_t buildBookIndex = 0;
+    size_t importPgnIndex = 0;
+    size_t exportPgnIndex = 0;
+    size_t archiveGamesIndex = 0;
+    size_t indexPositionsIndex = 0;
+    size_t findPositionIndex = 0;
+    size_t generateBitbasesIndex = 0;
+    size_t mateBenchIndex = 0;
+    size_t epdIndex = 0;
+    size_t benchIndex = 0;
+    size_t checkEngineIndex = 0;
     std::vector<std::string> args(argv + 1, argv + argc); // Get command line arguments
 
-    // Check for a simple "--console" flag
-    for (const std::string& arg : args) {
+    // Check for a simple "--console" or "--uci" flag, or a tool
+    for (size_t i = 0; i < args.size(); ++i) {
+        const std::string& arg = args[i];
         if (arg == "--console" || arg == "-c") {
             consoleMode = true;
             break;
         }
+        if (arg == "--uci") {
+            uciMode = true;
+            break;
+        }
+        if (arg == "--build-book") {
+            buildBookIndex = i + 1;
+            break;
+        }
+        if (arg == "--import-pgn") {
+            importPgnIndex = i + 1;
+            break;
+        }
+        if (arg == "--export-pgn") {
+            exportPgnIndex = i + 1;
+            break;
+        }
+        if (arg == "--archive-games") {
+            archiveGamesIndex = i + 1;
+            break;
+        }
+        if (arg == "--index-positions") {
+            indexPositionsIndex = i + 1;
+            break;
+        }
+        if (arg == "--find-position") {
+            findPositionIndex = i + 1;
+            break;
+        }
+        if (arg == "--generate-bitbases") {
+            generateBitbasesIndex = i + 1;
+            break;
+        }
+        if (arg == "--mate-bench") {
+            mateBenchIndex = i + 1;
+            break;
+        }
+        if (arg == "--epd") {
+            epdIndex = i + 1;
+            break;
+        }
+        if (arg == "--bench") {
+            benchIndex = i + 1;
+            break;
+        }
+        if (arg == "--check-engine") {
+            checkEngineIndex = i + 1;
+            break;
+        }
     }
 
-    if (consoleMode) {
+    if (buildBookIndex > 0) {
+        // Needed for the SQL driver plugins and the data location
+        QCoreApplication app(argc, argv);
+        return runBuildBook(std::vector<std::string>(args.begin() + buildBookIndex, args.end()));
+    } else if (importPgnIndex > 0) {
+        QCoreApplication app(argc, argv);
+        return runImportPgn(std::vector<std::string>(args.begin() + importPgnIndex, args.end()));
+    } else if (exportPgnIndex > 0) {
+        QCoreApplication app(argc, argv);
+        return runExportPgn(std::vector<std::string>(args.begin() + exportPgnIndex, args.end()));
+    } else if (archiveGamesIndex > 0) {
+        QCoreApplication app(argc, argv);
+        return runArchiveGames(std::vector<std::string>(args.begin() + archiveGamesIndex, args.end()));
+    } else if (indexPositionsIndex > 0) {
+        QCoreApplication app(argc, argv);
+        return runIndexPositions(std::vector<std::string>(args.begin() + indexPositionsIndex, args.end()));
+    } else if (findPositionIndex > 0) {
+        QCoreApplication app(argc, argv);
+        return runFindPosition(std::vector<std::string>(args.begin() + findPositionIndex, args.end()));
+    } else if (generateBitbasesIndex > 0) {
+        return runGenerateBitbases(std::vector<std::string>(args.begin() + generateBitbasesIndex, args.end()));
+    } else if (mateBenchIndex > 0) {
+        return runMateBench(std::vector<std::string>(args.begin() + mateBenchIndex, args.end()));
+    } else if (epdIndex > 0) {
+        return runEpd(std::vector<std::string>(args.begin() + epdIndex, args.end()));
+    } else if (benchIndex > 0) {
+        // Needed for the SQL driver plugins when benchmarking the database
+        QCoreApplication app(argc, argv);
+        return runBench(std::vector<std::string>(args.begin() + benchIndex, args.end()));
+    } else if (checkEngineIndex > 0) {
+        // The engine's process I/O needs an event loop
+        QCoreApplication app(argc, argv);
+        return runCheckEngine(std::vector<std::string>(args.begin() + checkEngineIndex, args.end()));
+    } else if (uciMode) {
+        // stdout belongs to the protocol, so nothing else may be printed here
+        UciController controller;
+        controller.run();
+        return 0;
+    } else if (consoleMode) {
         std::cout << "Running in Console Mode...\n";
         ChessModel model;
         ChessView view;
@@ -5,6 +5,7 @@
 
 #include "model/ChessModel.h"
 #include "core/FenUtils.h" // Include the new utility
+#include "engine/Zobrist.h"
 #include "pieces/Pawn.h"
 #include "pieces/Knight.h"
 #include "pieces/Bishop.h"
@@ -48,6 +49,7 @@ void ChessModel::clearBoard() {
         }
     }
     moveHistory.clear();
+    positionKeys.clear();
     delete enPassantTarget;
     enPassantTarget = nullptr;
     isCheckmate = false;
@@ -60,8 +62,9 @@ void ChessModel::setupStartingPosition() {
 }
 
 void ChessModel::setupFromFEN(const std::string& fen) {
-    if (!FenUtils::parseFen(fen, *this)) {
-         qWarning("Failed to parse provided FEN string: %s", fen.c_str());
+    FenError error = FenUtils::parseFen(fen, *this);
+    if (error != FenError::None) {
+         qWarning("Failed to parse provided FEN string: %s (%s)", fen.c_str(), FenUtils::errorMessage(error));
     }
 }
 
@@ -282,6 +285,34 @@ bool ChessModel::makeMove(const Move& move) {
         return false;
     }
 
+    if (!applyMove(move)) return false;
+    updateCurrentValidMoves();
+    updateGameStatus();
+    return true;
+}
+
+bool ChessModel::replayMoves(const std::vector<Move>& moves) {
+    bool complete = true;
+    for (const Move& move : moves) {
+        Piece* piece = getPiece(move.from.row, move.from.col);
+        Piece* target = getPiece(move.to.row, move.to.col);
+        if (!piece || piece->isWhite != whiteToMove || !move.to.isValid() || (target && target->isWhite == whiteToMove)) {
+            complete = false;
+            break;
+        }
+        if (!applyMove(move)) {
+            complete = false;
+            break;
+        }
+    }
+    updateCurrentValidMoves();
+    updateGameStatus();
+    return complete;
+}
+
+// Moves the pieces and updates castling rights, en passant, captures, the clocks and the
+// history; the move must be legal
+bool ChessModel::applyMove(const Move& move) {
     Piece* piece = board[move.from.row][move.from.col];
     Piece* capturedPiece = board[move.to.row][move.to.col];
     Piece* actualCaptured = capturedPiece;
@@ -291,7 +322,6 @@ bool ChessModel::makeMove(const Move& move) {
         int capturedRow = piece->isWhite ? move.to.row - 1 : move.to.row + 1;
         actualCaptured = board[capturedRow][move.to.col];
         board[capturedRow][move.to.col] = nullptr;
-        qDebug() << "En passant capture performed.";
     }
 
     // Handle Castling
@@ -303,7 +333,6 @@ bool ChessModel::makeMove(const Move& move) {
             board[move.from.row][rookToCol] = rook;
             board[move.from.row][rookFromCol] = nullptr;
             rook->hasMoved = true;
-            qDebug() << "Castling rook moved.";
         } else {
             qWarning() << "CRITICAL ERROR: Castling move valid but rook missing.";
             return false;
@@ -328,7 +357,6 @@ bool ChessModel::makeMove(const Move& move) {
             board[move.to.row][move.to.col] = promotedPiece;
             promotedPiece->hasMoved = true;
             piece = promotedPiece;
-            qDebug() << "Pawn promoted to Queen!";
         } else {
             qWarning() << "Failed to create promotion piece!";
             board[move.from.row][move.from.col] = pawnToPromote;
@@ -350,17 +378,67 @@ bool ChessModel::makeMove(const Move& move) {
     if (actualCaptured != nullptr) {
         if (actualCaptured->isWhite) capturedByBlack.push_back(actualCaptured);
         else capturedByWhite.push_back(actualCaptured);
-        qDebug() << "Piece captured:" << actualCaptured->type << "at" << move.to.row << "," << move.to.col;
     }
 
+    if (piece->type == 'P' || isPromotion || actualCaptured != nullptr) halfmoveClock = 0;
+    else halfmoveClock++;
+    if (!whiteToMove) fullmoveNumber++;
+
     whiteToMove = !whiteToMove;
     moveHistory.push_back(move);
-    updateCurrentValidMoves();
-    updateGameStatus();
-
+    positionKeys.push_back(computePositionKey());
     return true;
 }
 
+uint64_t ChessModel::computePositionKey() const {
+    uint64_t key = 0;
+    for (int row = 0; row < 8; ++row) {
+        for (int col = 0; col < 8; ++col) {
+            const Piece* piece = board[row][col];
+            if (!piece) continue;
+            int type = 0;
+            switch (piece->type) {
+                case 'P': type = 0; break;
+                case 'N': type = 1; break;
+                case 'B': type = 2; break;
+                case 'R': type = 3; break;
+                case 'Q': type = 4; break;
+                default:  type = 5; break;
+            }
+            key ^= Zobrist::piece((piece->isWhite ? 0 : 6) + type, row * 8 + col);
+        }
+    }
+    int rights = 0;
+    for (int i = 0; i < 4; ++i) {
+        if (castlingRights[i]) rights |= 1 << i;
+    }
+    key ^= Zobrist::castling(rights);
+    // Like Board, the en passant file only counts when a pawn could take there
+    if (enPassantTarget) {
+        const int pawnRow = whiteToMove ? enPassantTarget->row - 1 : enPassantTarget->row + 1;
+        for (int col = enPassantTarget->col - 1; col <= enPassantTarget->col + 1; col += 2) {
+            const Piece* pawn = getPiece(pawnRow, col);
+            if (pawn && pawn->type == 'P' && pawn->isWhite == whiteToMove) {
+                key ^= Zobrist::enPassant(enPassantTarget->col);
+                break;
+            }
+        }
+    }
+    if (!whiteToMove) key ^= Zobrist::side();
+    return key;
+}
+
+int ChessModel::repetitionCount() const {
+    if (positionKeys.empty()) return 0;
+    const int last = int(positionKeys.size()) - 1;
+    const int first = std::max(0, last - halfmoveClock);
+    int count = 1;
+    for (int i = last - 2; i >= first; i -= 2) {
+        if (positionKeys[i] == positionKeys[last]) count++;
+    }
+    return count;
+}
+
 Position ChessModel::findKing(bool white) const {
     // Find the king
     Position kingPos(-1, -1);
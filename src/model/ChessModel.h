@@ -1,6 +1,7 @@
 #ifndef CHESS_MODEL_H
 #define CHESS_MODEL_H
 
+#include <cstdint>
 #include <string>
 #include <vector>
 #include <optional>
@@ -18,6 +19,8 @@ private:
     bool whiteToMove;
     Position* enPassantTarget;
     bool castlingRights[4]; // 0: white kingside, 1: white queenside, 2: black kingside, 3: black queenside
+    int halfmoveClock = 0;  // plies since the last capture or pawn move
+    int fullmoveNumber = 1;
 
     // Game State
     bool isCheckmate = false;
@@ -26,6 +29,7 @@ private:
     std::vector<Piece*> capturedByWhite;
     std::vector<Piece*> capturedByBlack;
     std::vector<Move> moveHistory;      
+    std::vector<uint64_t> positionKeys; // the start position and after each move, as Board::key()
 
     // Private Helper Methods
     bool isMoveLegal(const Move& move);
@@ -33,6 +37,8 @@ private:
     void updateGameStatus();
     void updateCastlingRights(const Move& move, Piece* movedPiece, Piece* capturedPiece);    
     void updateEnPassantTarget(const Move& move, Piece* movedPiece);
+    bool applyMove(const Move& move);
+    uint64_t computePositionKey() const;
     Position findKing(bool white) const;
     bool isSquareAttacked(Position square, bool byWhite) const;
     
@@ -52,14 +58,24 @@ public:
     void setWhiteToMove(bool white);
     Position* getEnPassantTarget() const;
     bool getCastlingRight(int index) const;    
+    int getHalfmoveClock() const { return halfmoveClock; }
+    int getFullmoveNumber() const { return fullmoveNumber; }
     const std::vector<Piece*>& getCapturedPieces(bool capturedByWhitePlayer) const; 
     std::vector<Position> getValidMoves(Position pos) const;    
     bool makeMove(const Move& move);
+    // Plays the moves of a saved game without generating the legal moves of every position
+    // on the way, only of the last one. The moves are trusted to be legal; false at one
+    // whose from-square does not hold a piece of the side to move, which is not played.
+    bool replayMoves(const std::vector<Move>& moves);
     bool isInCheck() const;
     bool getIsCheckmate() const { return isCheckmate; }
     bool getIsStalemate() const { return isStalemate; }
     bool isGameOver() const { return isCheckmate || isStalemate; }
     const std::vector<Move>& getMoveHistory() const { return moveHistory; } 
+    const std::vector<uint64_t>& getPositionKeys() const { return positionKeys; }
+    // How often the current position has occurred since the last capture or pawn move,
+    // itself included
+    int repetitionCount() const;
 };
 
 #endif // CHESS_MODEL_H
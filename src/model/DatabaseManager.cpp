@@ -1,7 +1,12 @@
 #include "model/DatabaseManager.h"
 #include "model/Move.h"
+#include "model/Position.h"
 #include "model/ChessModel.h"
+#include "model/MoveWriter.h"
 #include "core/Utils.h"
+#include "engine/Board.h"
+#include "engine/GameCodec.h"
+#include "engine/San.h"
 
 #include <QSqlQuery>
 #include <QSqlError>
@@ -10,25 +15,107 @@
 #include <QDebug>
 #include <QDir>
 #include <QStandardPaths>
+#include <QFileInfo>
+#include <QStringList>
+#include <QElapsedTimer>
+
+namespace {
+
+// Covers the lookups: the game ids and plies of a key are read from the index alone
+const char* const POSITIONS_INDEX_SQL = "CREATE INDEX IF NOT EXISTS idx_positions_zobrist ON Positions (zobrist, game_id, ply)";
+
+// Placement, side to move and castling. Earlier versions wrote every FEN with "- 0 1" for
+// the en-passant square and the counters, so those fields of a stored FEN say nothing.
+QString positionFields(const QString& fen)
+{
+    return fen.section(' ', 0, 2);
+}
+
+// The last FEN of a game with its move counters worked out from the start position and
+// the moves, for games restored from that FEN alone
+QString withMoveCounters(const QString& finalFen, const QString& startFen, const QList<QString>& sanMoves)
+{
+    int halfmoveClock = startFen.section(' ', 4, 4).toInt();
+    for (const QString& san : sanMoves) {
+        const bool pawnMove = !san.isEmpty() && san.at(0) >= 'a' && san.at(0) <= 'h';
+        halfmoveClock = pawnMove || san.contains('x') ? 0 : halfmoveClock + 1;
+    }
+    const int plies = int(sanMoves.size()) + (startFen.section(' ', 1, 1) == "b" ? 1 : 0);
+    const int fullmoveNumber = qMax(1, startFen.section(' ', 5, 5).toInt()) + plies / 2;
+    return QString("%1 %2 %3").arg(finalFen.section(' ', 0, 3)).arg(halfmoveClock).arg(fullmoveNumber);
+}
+
+} // namespace
 
 DatabaseManager::DatabaseManager(const QString& dbName, QObject *parent)
     : QObject(parent)
 {
-    QString dataPath = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation);
-    QDir dir(dataPath);
-    if (!dir.exists()) {
-        dir.mkpath(".");
+    // An absolute path (from the command-line tools) is used as is
+    if (QFileInfo(dbName).isAbsolute()) {
+        m_dbPath = dbName;
+    } else {
+        QString dataPath = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation);
+        QDir dir(dataPath);
+        if (!dir.exists()) {
+            dir.mkpath(".");
+        }
+        m_dbPath = dataPath + "/" + dbName;
     }
-    m_dbPath = dataPath + "/" + dbName;
     qDebug() << "Database path:" << m_dbPath;
 }
 
 DatabaseManager::~DatabaseManager()
 {
+    m_moveWriter.reset(); // Commits the moves still queued
     if (m_db.isOpen()) {
-        m_db.close();
-        QSqlDatabase::removeDatabase("chessConnection"); // Clean up connection
+        closeDatabase();
+    }
+}
+
+DatabaseManager::ConnectionSettings DatabaseManager::ConnectionSettings::sqliteDefaults()
+{
+    ConnectionSettings settings;
+    settings.journalMode.clear();
+    settings.synchronous.clear();
+    settings.mmapSizeBytes = 0;
+    settings.cacheSizeKb = 0;
+    settings.tempStoreInMemory = false;
+    return settings;
+}
+
+bool DatabaseManager::applyConnectionSettings(QSqlDatabase& db, const ConnectionSettings& settings)
+{
+    QSqlQuery query(db);
+    bool success = true;
+    if (!settings.journalMode.isEmpty()) {
+        // Answers with the mode in effect, which stays the old one where WAL is not possible
+        if (!query.exec("PRAGMA journal_mode = " + settings.journalMode) || !query.next()) {
+            qWarning() << "Failed to set journal mode" << settings.journalMode << ":" << query.lastError();
+            success = false;
+        } else if (query.value(0).toString().compare(settings.journalMode, Qt::CaseInsensitive) != 0) {
+            qWarning() << "Journal mode" << settings.journalMode << "not available, using" << query.value(0).toString();
+        }
+        query.finish();
     }
+
+    QStringList pragmas;
+    if (!settings.synchronous.isEmpty()) pragmas << "PRAGMA synchronous = " + settings.synchronous;
+    if (settings.mmapSizeBytes > 0) pragmas << QString("PRAGMA mmap_size = %1").arg(settings.mmapSizeBytes);
+    if (settings.cacheSizeKb > 0) pragmas << QString("PRAGMA cache_size = -%1").arg(settings.cacheSizeKb);
+    if (settings.tempStoreInMemory) pragmas << "PRAGMA temp_store = MEMORY";
+    for (const QString& pragma : pragmas) {
+        if (!query.exec(pragma)) {
+            qWarning() << "Failed to run" << pragma << ":" << query.lastError();
+            success = false;
+        }
+        query.finish();
+    }
+    return success;
+}
+
+void DatabaseManager::setConnectionSettings(const ConnectionSettings& settings)
+{
+    m_connectionSettings = settings;
 }
 
 bool DatabaseManager::openDatabase()
@@ -49,10 +136,32 @@ bool DatabaseManager::openDatabase()
         qWarning() << "Error: connection with database failed -" << m_db.lastError().text();
         return false;
     }
+    applyConnectionSettings(m_db, m_connectionSettings);
     qDebug() << "Database opened successfully.";
     return true;
 }
 
+void DatabaseManager::closeDatabase()
+{
+    // The cached statements must go before their connection
+    m_statements.clear();
+    m_db.close();
+    m_db = QSqlDatabase();
+    QSqlDatabase::removeDatabase("chessConnection");
+}
+
+QSqlQuery& DatabaseManager::cachedQuery(const QString& sql)
+{
+    auto it = m_statements.find(sql);
+    if (it == m_statements.end()) {
+        QSqlQuery query(m_db);
+        query.setForwardOnly(true);
+        if (!query.prepare(sql)) qWarning() << "Failed to prepare" << sql << ":" << query.lastError();
+        it = m_statements.insert(sql, std::move(query));
+    }
+    return *it;
+}
+
 bool DatabaseManager::createTables()
 {
     if (!m_db.isOpen()) {
@@ -71,11 +180,33 @@ bool DatabaseManager::createTables()
             result TEXT,
             last_fen TEXT,
             white_player_name TEXT DEFAULT 'White',
-            black_player_name TEXT DEFAULT 'Black'
+            black_player_name TEXT DEFAULT 'Black',
+            event TEXT,
+            site TEXT,
+            round TEXT,
+            start_fen TEXT,
+            encoded_moves BLOB
         )
     )");
     if (!success) qWarning() << "Failed to create Games table:" << query.lastError();
 
+    // Databases from before the PGN import lack the tag columns and the encoded moves
+    // (one byte per ply, see GameCodec)
+    QStringList gameColumns;
+    if (query.exec("PRAGMA table_info(Games)")) {
+        while (query.next()) gameColumns << query.value(1).toString();
+    }
+    const char* const addedColumns[][2] = {
+        { "event", "TEXT" }, { "site", "TEXT" }, { "round", "TEXT" }, { "start_fen", "TEXT" },
+        { "encoded_moves", "BLOB" }
+    };
+    for (const auto& column : addedColumns) {
+        if (!gameColumns.isEmpty() && !gameColumns.contains(column[0])) {
+            success &= query.exec(QString("ALTER TABLE Games ADD COLUMN %1 %2").arg(column[0], column[1]));
+            if (!success) qWarning() << "Failed to add column" << column[0] << "to Games table:" << query.lastError();
+        }
+    }
+
     success &= query.exec(R"(
         CREATE TABLE IF NOT EXISTS Moves (
             move_id INTEGER PRIMARY KEY AUTOINCREMENT,
@@ -96,17 +227,35 @@ bool DatabaseManager::createTables()
     success &= query.exec("CREATE INDEX IF NOT EXISTS idx_moves_game_id ON Moves (game_id)");
      if (!success) qWarning() << "Failed to create index on Moves table:" << query.lastError();
 
+    // Zobrist keys are unsigned 64-bit and stored with the same bits as SQLite's signed integers
+    success &= query.exec(R"(
+        CREATE TABLE IF NOT EXISTS Positions (
+            zobrist INTEGER NOT NULL,
+            game_id INTEGER NOT NULL,
+            ply INTEGER NOT NULL,
+            FOREIGN KEY(game_id) REFERENCES Games(game_id) ON DELETE CASCADE
+        )
+    )");
+    if (!success) qWarning() << "Failed to create Positions table:" << query.lastError();
+
+    success &= query.exec(POSITIONS_INDEX_SQL);
+    if (!success) qWarning() << "Failed to create index on Positions table:" << query.lastError();
+
     return success;
 }
 
+QString DatabaseManager::databasePath() const
+{
+    return m_dbPath;
+}
+
 bool DatabaseManager::initDatabase()
 {
     if (!openDatabase()) {
         return false;
     }
     if (!createTables()) {
-        m_db.close();
-        QSqlDatabase::removeDatabase("chessConnection");
+        closeDatabase();
         return false;
     }
     return true;
@@ -116,8 +265,7 @@ qint64 DatabaseManager::startNewGame(const QString& whitePlayer, const QString&
 {
     if (!m_db.isOpen()) return -1;
 
-    QSqlQuery query(m_db);
-    query.prepare(R"(
+    QSqlQuery& query = cachedQuery(R"(
         INSERT INTO Games (start_datetime, white_player_name, black_player_name, last_fen)
         VALUES (:start, :white, :black, :fen)
     )");
@@ -143,53 +291,69 @@ bool DatabaseManager::saveMove(qint64 gameId, int moveNumber, bool isWhiteMove,
         return false;
     }
 
-    QSqlQuery query(m_db);
-    query.prepare(R"(
-        INSERT INTO Moves (game_id, move_number, is_white_move, from_row, from_col, to_row, to_col, san, fen_after_move)
-        VALUES (:game_id, :move_num, :is_white, :f_row, :f_col, :t_row, :t_col, :san, :fen)
-    )");
-    query.bindValue(":game_id", gameId);
-    query.bindValue(":move_num", moveNumber);
-    query.bindValue(":is_white", isWhiteMove ? 1 : 0);
-    query.bindValue(":f_row", move.from.row);
-    query.bindValue(":f_col", move.from.col);
-    query.bindValue(":t_row", move.to.row);
-    query.bindValue(":t_col", move.to.col);
-    query.bindValue(":san", san);
-    query.bindValue(":fen", fenAfterMove);
-
-    if (!query.exec()) {
-        qWarning() << "Failed to save move for game" << gameId << ":" << query.lastError();
-        return false;
+    // The writer starts with the first move, so tools that never save moves don't pay for it
+    if (!m_moveWriter) {
+        MoveWriter::Settings settings;
+        settings.flushIntervalMs = m_moveFlushIntervalMs;
+        settings.connection = m_connectionSettings;
+        // Reported from the writer thread; the signal is emitted on this object's thread
+        settings.movesLost = [this](size_t moves, const QString& error) {
+            QMetaObject::invokeMethod(this, [this, moves, error] { emit movesNotSaved(int(moves), error); }, Qt::QueuedConnection);
+        };
+        m_moveWriter = std::make_unique<MoveWriter>(m_dbPath, settings);
+        if (!m_moveWriter->start()) {
+            m_moveWriter.reset();
+            return false;
+        }
     }
 
-    // Also update the last_fen in the Games table
-    QSqlQuery updateFenQuery(m_db);
-    updateFenQuery.prepare("UPDATE Games SET last_fen = :fen WHERE game_id = :game_id");
-    updateFenQuery.bindValue(":fen", fenAfterMove);
-    updateFenQuery.bindValue(":game_id", gameId);
-    if (!updateFenQuery.exec()) {
-        qWarning() << "Failed to update last FEN for game" << gameId << ":" << updateFenQuery.lastError();
-        // Not returning false here, as the move itself was saved.
+    MoveWriter::PendingMove pending { gameId, moveNumber, isWhiteMove,
+                                      uint8_t(move.from.row), uint8_t(move.from.col),
+                                      uint8_t(move.to.row), uint8_t(move.to.col),
+                                      san, fenAfterMove };
+    if (!m_moveWriter->enqueue(std::move(pending))) {
+        qWarning() << "Failed to save move for game" << gameId << ": the move writer has stopped";
+        return false;
     }
+    return true;
+}
 
+bool DatabaseManager::flushMoves()
+{
+    return !m_moveWriter || m_moveWriter->flush();
+}
 
-    return true;
+void DatabaseManager::setMoveFlushInterval(int milliseconds)
+{
+    m_moveFlushIntervalMs = milliseconds;
+    if (m_moveWriter) m_moveWriter->setFlushInterval(milliseconds);
 }
 
 bool DatabaseManager::finishGame(qint64 gameId, const QString& result, const QString& finalFen)
 {
      if (!m_db.isOpen() || gameId < 0) return false;
+     if (!flushMoves()) qWarning() << "Some moves of game" << gameId << "could not be saved";
+
+     // Encoded as the importer does it, so tools read the finished game from one column
+     QVariant encodedMoves;
+     QSqlQuery& startQuery = cachedQuery("SELECT start_fen FROM Games WHERE game_id = :game_id");
+     startQuery.bindValue(":game_id", gameId);
+     if (startQuery.exec() && startQuery.next()) {
+         const QString startFen = startQuery.value(0).toString();
+         startQuery.finish();
+         QByteArray encoded;
+         if (encodeSavedMoves(gameId, startFen, encoded)) encodedMoves = encoded;
+     }
 
-     QSqlQuery query(m_db);
-     query.prepare(R"(
+     QSqlQuery& query = cachedQuery(R"(
          UPDATE Games
-         SET end_datetime = :end_time, result = :result, last_fen = :fen
+         SET end_datetime = :end_time, result = :result, last_fen = :fen, encoded_moves = :encoded_moves
          WHERE game_id = :game_id
      )");
      query.bindValue(":end_time", QDateTime::currentDateTime().toString(Qt::ISODate));
      query.bindValue(":result", result);
      query.bindValue(":fen", finalFen);
+     query.bindValue(":encoded_moves", encodedMoves);
      query.bindValue(":game_id", gameId);
 
      if (!query.exec()) {
@@ -205,8 +369,9 @@ QList<GameInfo> DatabaseManager::getSavedGamesList()
 {
     QList<GameInfo> games;
     if (!m_db.isOpen()) return games;
+    flushMoves();
 
-    QSqlQuery query("SELECT game_id, start_datetime, end_datetime, result, white_player_name, black_player_name FROM Games ORDER BY start_datetime DESC", m_db);
+    QSqlQuery& query = cachedQuery("SELECT game_id, start_datetime, end_datetime, result, white_player_name, black_player_name FROM Games ORDER BY start_datetime DESC");
     if (!query.exec()) {
         qWarning() << "Failed to get saved games list:" << query.lastError();
         return games;
@@ -225,16 +390,19 @@ QList<GameInfo> DatabaseManager::getSavedGamesList()
     return games;
 }
 
-bool DatabaseManager::loadGameMoves(qint64 gameId, ChessModel* modelToLoadInto, QList<QString>& sanMovesList)
+bool DatabaseManager::loadGameMoves(qint64 gameId, ChessModel* modelToLoadInto, QList<QString>& sanMovesList,
+                                    QList<QString>* fenAfterMoves, QString* startFenOut)
 {
     if (!m_db.isOpen() || gameId < 0 || !modelToLoadInto) return false;
+    flushMoves();
 
     sanMovesList.clear();
+    if (fenAfterMoves) fenAfterMoves->clear();
+    const QString initialFen = "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1";
+    QString startFen;
     QString finalFen;
-    bool gameFound = false;
 
-    QSqlQuery gameQuery(m_db);
-    gameQuery.prepare("SELECT last_fen FROM Games WHERE game_id = :game_id");
+    QSqlQuery& gameQuery = cachedQuery("SELECT start_fen, last_fen FROM Games WHERE game_id = :game_id");
     gameQuery.bindValue(":game_id", gameId);
 
     if (!gameQuery.exec()) {
@@ -243,44 +411,273 @@ bool DatabaseManager::loadGameMoves(qint64 gameId, ChessModel* modelToLoadInto,
     }
 
     if (gameQuery.next()) {
-        finalFen = gameQuery.value(0).toString();
-        gameFound = true;
+        startFen = gameQuery.value(0).toString();
+        finalFen = gameQuery.value(1).toString();
+        gameQuery.finish();
         qDebug() << "Found game" << gameId << "with last FEN:" << finalFen;
     } else {
          qWarning() << "Game with ID" << gameId << "not found in Games table.";
          return false;
     }
+    if (startFen.isEmpty()) startFen = initialFen;
+    if (startFenOut) *startFenOut = startFen;
 
-    // If FEN is somehow empty (shouldn't happen with current save logic, but defensively check)
-    if (finalFen.isEmpty()) {
-         qWarning() << "Final FEN is empty for game" << gameId << ". Using starting position as fallback.";
-         finalFen = "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1";
+    // Every move in play order, in one pass over idx_moves_game_id
+    QSqlQuery& movesQuery = cachedQuery(R"(
+        SELECT from_row, from_col, to_row, to_col, san, fen_after_move
+        FROM Moves WHERE game_id = :game_id ORDER BY move_id
+    )");
+    movesQuery.bindValue(":game_id", gameId);
+    std::vector<Move> moves;
+    bool underpromotes = false; // the model only promotes to a queen
+    if (!movesQuery.exec()) {
+        qWarning() << "Failed to load moves for game" << gameId << ":" << movesQuery.lastError();
+        // Continue anyway, show the last position
+    } else {
+        while (movesQuery.next()) {
+            moves.emplace_back(Position(movesQuery.value(0).toInt(), movesQuery.value(1).toInt()),
+                               Position(movesQuery.value(2).toInt(), movesQuery.value(3).toInt()));
+            const QString san = movesQuery.value(4).toString();
+            const int promotion = san.indexOf('=');
+            if (promotion >= 0 && promotion + 1 < san.size() && san.at(promotion + 1) != 'Q') underpromotes = true;
+            sanMovesList.append(san);
+            if (fenAfterMoves) fenAfterMoves->append(movesQuery.value(5).toString());
+        }
     }
 
-    // Setup the model from the final FEN
+    // Replaying gives the model the move history, castling state and position keys that
+    // the last FEN alone cannot. A game with an underpromotion, or one that does not end on
+    // the position of its last FEN, is restored from the FEN instead.
     try {
-         modelToLoadInto->setupFromFEN(finalFen.toStdString());
+        modelToLoadInto->setupFromFEN(startFen.toStdString());
+        bool replayed = !underpromotes && modelToLoadInto->replayMoves(moves);
+        if (replayed && !finalFen.isEmpty()
+            && positionFields(QString::fromStdString(modelToLoadInto->getCurrentFEN())) != positionFields(finalFen)) {
+            replayed = false;
+        }
+        if (!replayed) {
+            qWarning() << "Game" << gameId << "does not replay from its moves; restoring its last position only";
+            modelToLoadInto->setupFromFEN(finalFen.isEmpty() ? startFen.toStdString()
+                                                             : withMoveCounters(finalFen, startFen, sanMovesList).toStdString());
+        }
     } catch (const std::exception& e) {
-        qWarning() << "Failed to setup model from FEN for game" << gameId << ":" << e.what();
+        qWarning() << "Failed to setup model for game" << gameId << ":" << e.what();
         return false;
     } catch (...) {
-         qWarning() << "Unknown exception setting up model from FEN for game" << gameId;
+         qWarning() << "Unknown exception setting up model for game" << gameId;
          return false;
     }
 
-    // Get the list of SAN moves for the history display
-    QSqlQuery movesQuery(m_db);
-    movesQuery.prepare("SELECT san FROM Moves WHERE game_id = :game_id ORDER BY move_number ASC, is_white_move ASC");
-    movesQuery.bindValue(":game_id", gameId);
-    if (!movesQuery.exec()) {
-        qWarning() << "Failed to load SAN moves for game" << gameId << ":" << movesQuery.lastError();
-        // Continue anyway, show the board state
-    } else {
-        while (movesQuery.next()) {
-            sanMovesList.append(movesQuery.value(0).toString());
+    qDebug() << "Loaded game" << gameId << "with final FEN:" << finalFen << "and" << sanMovesList.count() << "moves.";
+    return true;
+}
+
+bool DatabaseManager::forEachFinishedGame(int maxPlies, const GameVisitor& visitor)
+{
+    if (!m_db.isOpen()) return false;
+    flushMoves();
+
+    // Moves are stored in the order they were played, so (game_id, move_id) is play order and
+    // the scan can follow idx_moves_game_id without a sort
+    QString sql = R"(
+        SELECT m.game_id, g.result, g.start_fen, m.from_row, m.from_col, m.to_row, m.to_col
+        FROM Moves m JOIN Games g ON g.game_id = m.game_id
+        WHERE g.result IN ('1-0', '0-1', '1/2-1/2')
+    )";
+    // Move numbers of a game set up from a FEN go on from the FEN's, so those games are
+    // only cut short below
+    if (maxPlies > 0) sql += " AND (g.start_fen IS NOT NULL OR m.move_number <= :max_move_number)";
+    sql += " ORDER BY m.game_id, m.move_id";
+
+    QSqlQuery& query = cachedQuery(sql);
+    if (maxPlies > 0) query.bindValue(":max_move_number", (maxPlies + 1) / 2);
+    if (!query.exec()) {
+        qWarning() << "Failed to read games:" << query.lastError();
+        return false;
+    }
+
+    qint64 currentGame = -1;
+    QString currentResult;
+    QString currentStartFen;
+    QByteArray packedMoves;
+    while (query.next()) {
+        qint64 gameId = query.value(0).toLongLong();
+        if (gameId != currentGame) {
+            if (currentGame >= 0 && !visitor(currentGame, currentResult, currentStartFen, packedMoves)) {
+                query.finish();
+                return true;
+            }
+            currentGame = gameId;
+            currentResult = query.value(1).toString();
+            currentStartFen = query.value(2).toString();
+            packedMoves.clear();
         }
+        if (maxPlies > 0 && packedMoves.size() >= 2 * maxPlies) continue;
+        packedMoves.append(char(query.value(3).toInt() * 8 + query.value(4).toInt()));
+        packedMoves.append(char(query.value(5).toInt() * 8 + query.value(6).toInt()));
+    }
+    if (currentGame >= 0) visitor(currentGame, currentResult, currentStartFen, packedMoves);
+    return true;
+}
+
+bool DatabaseManager::forEachEncodedGame(const EncodedGameVisitor& visitor, qint64* unreplayable)
+{
+    if (unreplayable) *unreplayable = 0;
+    if (!m_db.isOpen()) return false;
+    flushMoves();
+
+    // Not a cached statement: encodeSavedMoves() may add to the cache, which would move it
+    QSqlQuery query(m_db);
+    query.setForwardOnly(true);
+    if (!query.exec(R"(
+            SELECT game_id, result, start_fen, encoded_moves
+            FROM Games
+            WHERE result IN ('1-0', '0-1', '1/2-1/2')
+            ORDER BY game_id
+        )")) {
+        qWarning() << "Failed to read games:" << query.lastError();
+        return false;
     }
 
-    qDebug() << "Loaded game" << gameId << "with final FEN:" << finalFen << "and" << sanMovesList.count() << "moves.";
+    while (query.next()) {
+        const qint64 gameId = query.value(0).toLongLong();
+        const QString startFen = query.value(2).toString();
+        QByteArray encodedMoves = query.value(3).toByteArray();
+        if (query.isNull(3) && !encodeSavedMoves(gameId, startFen, encodedMoves)) {
+            if (unreplayable) ++*unreplayable;
+            continue;
+        }
+        if (!visitor(gameId, query.value(1).toString(), startFen, encodedMoves)) return true;
+    }
     return true;
-}
\ No newline at end of file
+}
+
+bool DatabaseManager::encodeSavedMoves(qint64 gameId, const QString& startFen, QByteArray& encodedMoves)
+{
+    Board start;
+    if (!start.setFromFen(startFen.isEmpty() ? std::string(Board::START_FEN) : startFen.toStdString())) return false;
+
+    // The from/to columns lose the promotion piece; the SAN has it
+    QSqlQuery& query = cachedQuery("SELECT san FROM Moves WHERE game_id = :game_id ORDER BY move_id");
+    query.bindValue(":game_id", gameId);
+    if (!query.exec()) {
+        qWarning() << "Failed to read the moves of game" << gameId << ":" << query.lastError();
+        return false;
+    }
+    std::vector<BoardMove> moves;
+    Board board = start;
+    while (query.next()) {
+        BoardMove move;
+        if (San::parse(board, query.value(0).toString().toStdString(), move) != SanError::None) {
+            query.finish();
+            return false;
+        }
+        moves.push_back(move);
+        board.makeMove(move);
+    }
+
+    std::string encoded;
+    GameCodec::encode(start, moves.data(), moves.size(), encoded);
+    encodedMoves = QByteArray(encoded.data(), int(encoded.size()));
+    return true;
+}
+
+QList<PositionMatch> DatabaseManager::findGamesWithPosition(uint64_t zobristKey, int limit)
+{
+    QList<PositionMatch> matches;
+    if (!m_db.isOpen()) return matches;
+    flushMoves();
+
+    // The index is ordered by (zobrist, game_id, ply), so the groups come out in order
+    // and the first ply of each game is its minimum
+    QSqlQuery& query = cachedQuery(R"(
+        SELECT game_id, MIN(ply) FROM Positions
+        WHERE zobrist = :zobrist
+        GROUP BY game_id ORDER BY game_id
+        LIMIT :limit
+    )");
+    query.bindValue(":zobrist", qint64(zobristKey));
+    query.bindValue(":limit", limit > 0 ? limit : -1);
+    if (!query.exec()) {
+        qWarning() << "Failed to look up position:" << query.lastError();
+        return matches;
+    }
+    while (query.next()) {
+        matches.append(PositionMatch{ query.value(0).toLongLong(), query.value(1).toInt() });
+    }
+    return matches;
+}
+
+QList<PositionMatch> DatabaseManager::findGamesWithPosition(const QString& fen, int limit)
+{
+    Board board;
+    if (!board.setFromFen(fen.toStdString())) {
+        qWarning() << "Cannot look up position, invalid FEN:" << fen;
+        return QList<PositionMatch>();
+    }
+    return findGamesWithPosition(board.key(), limit);
+}
+
+qint64 DatabaseManager::rebuildPositionIndex()
+{
+    if (!m_db.isOpen()) return -1;
+    flushMoves();
+    QElapsedTimer timer;
+    timer.start();
+
+    // Without the index the rows are appended to the table, and the index is built
+    // afterwards in one sort instead of one random insert per row
+    QSqlQuery query(m_db);
+    QSqlQuery insertQuery(m_db);
+    QSqlQuery movesQuery(m_db);
+    movesQuery.setForwardOnly(true);
+    bool ok = m_db.transaction();
+    ok = ok && query.exec("DROP INDEX IF EXISTS idx_positions_zobrist");
+    ok = ok && query.exec("DELETE FROM Positions");
+    ok = ok && insertQuery.prepare("INSERT INTO Positions (zobrist, game_id, ply) VALUES (?, ?, ?)");
+    // In play order along idx_moves_game_id, so the plies are counted per game as they come
+    ok = ok && movesQuery.exec("SELECT game_id, fen_after_move FROM Moves ORDER BY game_id, move_id");
+    if (!ok) {
+        qWarning() << "Failed to start rebuilding the position index:" << query.lastError() << movesQuery.lastError();
+        m_db.rollback();
+        return -1;
+    }
+
+    Board board;
+    qint64 positions = 0;
+    qint64 unreadable = 0;
+    qint64 currentGame = -1;
+    int ply = 0;
+    while (movesQuery.next()) {
+        const qint64 gameId = movesQuery.value(0).toLongLong();
+        if (gameId != currentGame) {
+            currentGame = gameId;
+            ply = 0;
+        }
+        ply++;
+        if (!board.setFromFen(movesQuery.value(1).toString().toStdString())) {
+            unreadable++;
+            continue;
+        }
+        insertQuery.bindValue(0, qint64(board.key()));
+        insertQuery.bindValue(1, gameId);
+        insertQuery.bindValue(2, ply);
+        if (!insertQuery.exec()) {
+            qWarning() << "Failed to index position:" << insertQuery.lastError();
+            movesQuery.finish();
+            m_db.rollback();
+            return -1;
+        }
+        positions++;
+    }
+    movesQuery.finish();
+
+    if (!query.exec(POSITIONS_INDEX_SQL) || !m_db.commit()) {
+        qWarning() << "Failed to build the position index:" << query.lastError() << m_db.lastError().text();
+        m_db.rollback();
+        return -1;
+    }
+    if (unreadable > 0) qWarning() << unreadable << "moves with an unreadable FEN were not indexed";
+    qDebug() << "Indexed" << positions << "positions in" << timer.elapsed() << "ms";
+    return positions;
+}
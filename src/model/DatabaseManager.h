@@ -3,12 +3,19 @@
 
 #include <QObject>
 #include <QSqlDatabase>
+#include <QSqlQuery>
+#include <QHash>
 #include <QString>
 #include <QList>
 #include <QPair>
+#include <QByteArray>
+#include <cstdint>
+#include <functional>
+#include <memory>
 
 class Move;
 class ChessModel;
+class MoveWriter;
 
 // Struct to hold basic game info for listing
 struct GameInfo {
@@ -20,6 +27,12 @@ struct GameInfo {
     QString blackPlayer;
 };
 
+// A game that reached a position, and the ply after which it first did
+struct PositionMatch {
+    qint64 gameId;
+    int ply;
+};
+
 class DatabaseManager : public QObject
 {
     Q_OBJECT
@@ -27,21 +40,90 @@ public:
     explicit DatabaseManager(const QString& dbPath = "chess_games.db", QObject *parent = nullptr);
     ~DatabaseManager();
 
+    // Pragmas run on every connection to the database as it opens; empty and zero values
+    // keep SQLite's defaults. With the write-ahead log readers don't wait for writers and
+    // a commit appends to the log, which synchronous=NORMAL syncs only at checkpoints: a
+    // power cut can lose the last commits but does not corrupt the database.
+    struct ConnectionSettings {
+        QString journalMode = "WAL";
+        QString synchronous = "NORMAL";
+        qint64 mmapSizeBytes = qint64(256) << 20;
+        int cacheSizeKb = 16384;
+        bool tempStoreInMemory = true;
+
+        // No pragmas: SQLite's rollback journal, synchronous=FULL and default cache
+        static ConnectionSettings sqliteDefaults();
+    };
+    static bool applyConnectionSettings(QSqlDatabase& db, const ConnectionSettings& settings);
+    // Takes effect for connections opened afterwards, so call it before initDatabase()
+    void setConnectionSettings(const ConnectionSettings& settings);
+
     bool initDatabase(); 
+    QString databasePath() const;
 
     qint64 startNewGame(const QString& whitePlayer = "White", const QString& blackPlayer = "Black");
+    // Queues the move for a writer thread (see MoveWriter), which commits the moves of each
+    // flush interval together. Everything that reads or finishes games flushes the queue first.
     bool saveMove(qint64 gameId, int moveNumber, bool isWhiteMove, const Move& move, const QString& san, const QString& fenAfterMove);
     bool finishGame(qint64 gameId, const QString& result, const QString& finalFen);
+    // Waits until every saved move is committed; for readers on other connections
+    bool flushMoves();
+    void setMoveFlushInterval(int milliseconds);
 
     QList<GameInfo> getSavedGamesList();
-    bool loadGameMoves(qint64 gameId, ChessModel* modelToLoadInto, QList<QString>& sanMovesList);
+    // Sets the model up at the game's start position and replays every move, so it ends
+    // with the full move history; see ChessModel::replayMoves. startFen gets the position
+    // the game started from.
+    bool loadGameMoves(qint64 gameId, ChessModel* modelToLoadInto, QList<QString>& sanMovesList,
+                       QList<QString>* fenAfterMoves = nullptr, QString* startFen = nullptr);
+
+    // Streams the moves of every game with a result, in play order and without building
+    // a ChessModel per game. Each ply is packed as two bytes, from and to square (row * 8 + col).
+    // startFen is empty for games from the standard starting position. Only the first maxPlies
+    // plies are read when maxPlies > 0. The visitor returns false to stop.
+    using GameVisitor = std::function<bool(qint64 gameId, const QString& result, const QString& startFen, const QByteArray& packedMoves)>;
+    bool forEachFinishedGame(int maxPlies, const GameVisitor& visitor);
+    // Streams every game with a result in game id order, with its moves as GameCodec bytes:
+    // the encoded_moves column, which games get when they are imported or finished, or for
+    // older games the moves encoded from their SAN, which keeps underpromotions. Games whose
+    // moves do not replay are left out and counted in unreplayable.
+    using EncodedGameVisitor = std::function<bool(qint64 gameId, const QString& result, const QString& startFen, const QByteArray& encodedMoves)>;
+    bool forEachEncodedGame(const EncodedGameVisitor& visitor, qint64* unreplayable = nullptr);
+
+    // The Positions table has a row for the position after every saved move, keyed by its
+    // Zobrist key (Board::key()), so finding the games that reached a position is a lookup
+    // in idx_positions_zobrist that never reads the Moves table. The ply is the index of the
+    // move that led to the position within its game, from 1 for the game's first move, so
+    // it counts the moves from the start position whether or not that came from a FEN.
+    // In game id order, at most limit games (all of them when limit <= 0)
+    QList<PositionMatch> findGamesWithPosition(uint64_t zobristKey, int limit = 1000);
+    // An empty list for a FEN that does not parse
+    QList<PositionMatch> findGamesWithPosition(const QString& fen, int limit = 1000);
+    // Fills the Positions table again from the FEN after every saved move, for databases
+    // from before it existed. Returns the number of positions, or -1 when it fails.
+    qint64 rebuildPositionIndex();
+
+signals:
+    // Saved moves the writer could not commit, even after retrying; the moves saved
+    // after them are still written
+    void movesNotSaved(int count, const QString& error);
 
 private:
     QSqlDatabase m_db;
     QString m_dbPath;
+    std::unique_ptr<MoveWriter> m_moveWriter;
+    int m_moveFlushIntervalMs = 250;
+    ConnectionSettings m_connectionSettings;
+    // Prepared once per connection and reused, keyed by their SQL
+    QHash<QString, QSqlQuery> m_statements;
 
     bool openDatabase();
     bool createTables();
+    void closeDatabase();
+    QSqlQuery& cachedQuery(const QString& sql);
+    // The saved moves of a game replayed from startFen (empty for the standard position) by
+    // their SAN and encoded with GameCodec; false when one does not replay
+    bool encodeSavedMoves(qint64 gameId, const QString& startFen, QByteArray& encodedMoves);
 };
 
 #endif 
\ No newline at end of file
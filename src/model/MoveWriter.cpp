@@ -0,0 +1,216 @@
+#include "model/MoveWriter.h"
+#include "engine/Board.h"
+
+#include <QSqlDatabase>
+#include <QSqlError>
+#include <QSqlQuery>
+#include <QVariant>
+#include <QDebug>
+#include <algorithm>
+#include <chrono>
+#include <iterator>
+
+namespace {
+
+const char* const WRITER_CONNECTION = "moveWriterConnection";
+
+} // namespace
+
+MoveWriter::MoveWriter(const QString& dbPath, const Settings& settings)
+    : dbPath(dbPath), settings(settings)
+{
+    this->settings.flushIntervalMs = std::max(0, settings.flushIntervalMs);
+    this->settings.queueCapacity = std::max<size_t>(1, settings.queueCapacity);
+}
+
+MoveWriter::~MoveWriter()
+{
+    stop();
+}
+
+bool MoveWriter::start()
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    if (running) return true;
+    opened = false;
+    running = true;
+    stopping = false;
+    movesDropped = 0;
+    writer = std::thread([this] { writerLoop(); });
+    written.wait(lock, [this] { return opened || !running; });
+    if (running) return true;
+    lock.unlock();
+    writer.join();
+    return false;
+}
+
+bool MoveWriter::enqueue(PendingMove&& move)
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    queueNotFull.wait(lock, [this] { return !running || queue.size() < settings.queueCapacity; });
+    if (!running) return false;
+    queue.push_back(std::move(move));
+    movesEnqueued++;
+    if (queue.size() == 1 || queue.size() >= settings.queueCapacity) queueNotEmpty.notify_one();
+    return true;
+}
+
+bool MoveWriter::flush()
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    if (movesWritten < movesEnqueued) {
+        flushTarget = movesEnqueued;
+        queueNotEmpty.notify_one();
+        written.wait(lock, [this] { return !running || movesWritten >= flushTarget; });
+    }
+    const bool ok = movesDropped == 0 && movesWritten == movesEnqueued;
+    movesDropped = 0;
+    return ok;
+}
+
+void MoveWriter::stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!running) return;
+        stopping = true;
+    }
+    queueNotEmpty.notify_one();
+    writer.join();
+}
+
+void MoveWriter::setFlushInterval(int milliseconds)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    settings.flushIntervalMs = std::max(0, milliseconds);
+}
+
+void MoveWriter::writerLoop()
+{
+    {
+        // The writer's own connection, used only from this thread
+        QSqlDatabase db = QSqlDatabase::addDatabase("QSQLITE", WRITER_CONNECTION);
+        db.setDatabaseName(dbPath);
+        const bool ok = db.open();
+        if (!ok) qWarning() << "Cannot open the database for saving moves:" << db.lastError().text();
+        else DatabaseManager::applyConnectionSettings(db, settings.connection);
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            opened = ok;
+            running = ok;
+        }
+        written.notify_all();
+
+        if (ok) {
+            QSqlQuery moveQuery(db);
+            moveQuery.prepare(R"(
+                INSERT INTO Moves (game_id, move_number, is_white_move, from_row, from_col, to_row, to_col, san, fen_after_move)
+                VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?)
+            )");
+            QSqlQuery positionQuery(db);
+            // Run after the move's own row is in, so the count is the move's index in its game
+            positionQuery.prepare(R"(
+                INSERT INTO Positions (zobrist, game_id, ply)
+                VALUES (?, ?, (SELECT COUNT(*) FROM Moves WHERE game_id = ?))
+            )");
+            QSqlQuery fenQuery(db);
+            fenQuery.prepare("UPDATE Games SET last_fen = ? WHERE game_id = ?");
+
+            std::vector<PendingMove> batch;
+            std::unique_lock<std::mutex> lock(mutex);
+            while (true) {
+                queueNotEmpty.wait(lock, [this] { return stopping || !queue.empty(); });
+                if (queue.empty()) break;
+
+                // Give the moves that follow soon after a chance to share the commit
+                const auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(settings.flushIntervalMs);
+                queueNotEmpty.wait_until(lock, deadline, [this] {
+                    return stopping || flushTarget > movesWritten || queue.size() >= settings.queueCapacity;
+                });
+
+                batch.assign(std::make_move_iterator(queue.begin()), std::make_move_iterator(queue.end()));
+                queue.clear();
+                lock.unlock();
+                queueNotFull.notify_all();
+
+                // Errors such as a locked database pass, so a failed batch gets a few more tries
+                bool committed = false;
+                QString error;
+                for (int attempt = 1; attempt <= COMMIT_ATTEMPTS && !committed; ++attempt) {
+                    if (attempt > 1) std::this_thread::sleep_for(std::chrono::milliseconds(RETRY_DELAY_MS * (attempt - 1)));
+                    error.clear();
+                    if (!db.transaction()) {
+                        error = db.lastError().text();
+                        continue;
+                    }
+                    committed = writeMoves(moveQuery, positionQuery, fenQuery, batch, error) && db.commit();
+                    if (!committed) {
+                        if (error.isEmpty()) error = db.lastError().text();
+                        db.rollback();
+                    }
+                }
+                if (!committed) {
+                    qWarning() << "Failed to save" << batch.size() << "moves after" << COMMIT_ATTEMPTS << "attempts:" << error;
+                    if (settings.movesLost) settings.movesLost(batch.size(), error);
+                }
+
+                lock.lock();
+                movesWritten += batch.size();
+                if (!committed) movesDropped += batch.size();
+                written.notify_all();
+            }
+            running = false;
+            lock.unlock();
+            queueNotFull.notify_all();
+            written.notify_all();
+        }
+        db.close();
+    }
+    QSqlDatabase::removeDatabase(WRITER_CONNECTION);
+}
+
+bool MoveWriter::writeMoves(QSqlQuery& moveQuery, QSqlQuery& positionQuery, QSqlQuery& fenQuery, const std::vector<PendingMove>& moves, QString& error)
+{
+    Board board;
+    for (const PendingMove& move : moves) {
+        moveQuery.bindValue(0, move.gameId);
+        moveQuery.bindValue(1, move.moveNumber);
+        moveQuery.bindValue(2, move.isWhiteMove ? 1 : 0);
+        moveQuery.bindValue(3, move.fromRow);
+        moveQuery.bindValue(4, move.fromCol);
+        moveQuery.bindValue(5, move.toRow);
+        moveQuery.bindValue(6, move.toCol);
+        moveQuery.bindValue(7, move.san);
+        moveQuery.bindValue(8, move.fenAfterMove);
+        if (!moveQuery.exec()) {
+            error = moveQuery.lastError().text();
+            return false;
+        }
+
+        if (!board.setFromFen(move.fenAfterMove.toStdString())) {
+            qWarning() << "Not indexing the position after move" << move.moveNumber << "of game" << move.gameId << ": invalid FEN";
+            continue;
+        }
+        positionQuery.bindValue(0, qint64(board.key()));
+        positionQuery.bindValue(1, move.gameId);
+        positionQuery.bindValue(2, move.gameId);
+        if (!positionQuery.exec()) {
+            error = positionQuery.lastError().text();
+            return false;
+        }
+    }
+
+    // last_fen only needs the last move of each game in the batch
+    std::vector<qint64> updatedGames;
+    for (auto it = moves.rbegin(); it != moves.rend(); ++it) {
+        if (std::find(updatedGames.begin(), updatedGames.end(), it->gameId) != updatedGames.end()) continue;
+        updatedGames.push_back(it->gameId);
+        fenQuery.bindValue(0, it->fenAfterMove);
+        fenQuery.bindValue(1, it->gameId);
+        if (!fenQuery.exec()) {
+            error = fenQuery.lastError().text();
+            return false;
+        }
+    }
+    return true;
+}
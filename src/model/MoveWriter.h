@@ -0,0 +1,88 @@
+#ifndef MOVEWRITER_H
+#define MOVEWRITER_H
+
+#include <QString>
+#include <QtGlobal>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "model/DatabaseManager.h"
+
+class QSqlQuery;
+
+// Writes the moves of games being played behind the GUI's back.
+//
+// enqueue() only copies the move into a bounded queue. A writer thread with its own
+// connection collects the moves that arrive within the flush interval and commits them
+// in one transaction: the Moves rows, their Positions keys computed from the FEN after
+// the move, and last_fen once per game. flush() returns when
+// everything enqueued before it is committed, so the caller can read or finish the game
+// on its own connection afterwards. A batch whose commit fails is retried a few times and
+// then dropped and reported; the moves after it are still written.
+class MoveWriter {
+public:
+    struct Settings {
+        int flushIntervalMs = 250;   // how long a move may wait for others to share its commit
+        size_t queueCapacity = 1024; // enqueue() waits for the writer beyond this
+        DatabaseManager::ConnectionSettings connection;
+        // Called on the writer thread with the moves of a batch it gave up on
+        std::function<void(size_t moves, const QString& error)> movesLost;
+    };
+
+    struct PendingMove {
+        qint64 gameId;
+        int moveNumber;
+        bool isWhiteMove;
+        uint8_t fromRow;
+        uint8_t fromCol;
+        uint8_t toRow;
+        uint8_t toCol;
+        QString san;
+        QString fenAfterMove;
+    };
+
+    // The database must exist with its tables; see DatabaseManager::initDatabase()
+    MoveWriter(const QString& dbPath, const Settings& settings);
+    ~MoveWriter();
+
+    // Starts the writer thread and waits until it has opened its connection
+    bool start();
+    // False when the writer is not running
+    bool enqueue(PendingMove&& move);
+    // False when moves were dropped since the previous flush()
+    bool flush();
+    // Flushes and stops the writer thread
+    void stop();
+    void setFlushInterval(int milliseconds);
+
+private:
+    static constexpr int COMMIT_ATTEMPTS = 3;
+    static constexpr int RETRY_DELAY_MS = 100; // times the attempt number
+
+    QString dbPath;
+    Settings settings;
+
+    std::mutex mutex;
+    std::condition_variable queueNotEmpty;
+    std::condition_variable queueNotFull;
+    std::condition_variable written;
+    std::deque<PendingMove> queue;
+    uint64_t movesEnqueued = 0;
+    uint64_t movesWritten = 0;
+    uint64_t flushTarget = 0;    // flush() waits for movesWritten to reach this
+    uint64_t movesDropped = 0;   // since the previous flush()
+    bool opened = false;
+    bool running = false;
+    bool stopping = false;
+
+    std::thread writer;
+
+    void writerLoop();
+    bool writeMoves(QSqlQuery& moveQuery, QSqlQuery& positionQuery, QSqlQuery& fenQuery, const std::vector<PendingMove>& moves, QString& error);
+};
+
+#endif // MOVEWRITER_H
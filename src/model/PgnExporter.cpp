@@ -0,0 +1,192 @@
+#include "model/PgnExporter.h"
+#include "core/PgnUtils.h"
+#include "model/DatabaseManager.h"
+
+#include <QSqlDatabase>
+#include <QSqlError>
+#include <QSqlQuery>
+#include <QVariant>
+#include <QDebug>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+
+namespace {
+
+const char* const EXPORT_CONNECTION = "pgnExportConnection";
+
+// Column order of the export query
+enum Column {
+    GAME_ID, START_DATETIME, RESULT, EVENT, SITE, ROUND, WHITE_PLAYER, BLACK_PLAYER, START_FEN,
+    MOVE_NUMBER, IS_WHITE_MOVE, SAN
+};
+
+std::string tagValue(const QVariant& value)
+{
+    std::string text = value.toString().toStdString();
+    return text.empty() ? std::string("?") : text;
+}
+
+// start_datetime is ISO 8601 ("2024-05-01T18:30:00"), or the date alone from an import;
+// PGN wants "2024.05.01"
+std::string dateTag(const QVariant& value)
+{
+    std::string date = value.toString().toStdString();
+    date = date.substr(0, date.find('T'));
+    if (date.empty()) return "????.??.??";
+    for (char& c : date) {
+        if (c == '-') c = '.';
+    }
+    return date;
+}
+
+std::string resultTag(const QVariant& value)
+{
+    const std::string result = value.toString().toStdString();
+    if (result == "1-0" || result == "0-1" || result == "1/2-1/2") return result;
+    return "*";
+}
+
+} // namespace
+
+PgnExporter::PgnExporter(const QString& dbPath)
+    : dbPath(dbPath)
+{
+}
+
+bool PgnExporter::exportTo(const std::string& pgnPath, bool finishedOnly)
+{
+    exportStats = Stats();
+    const auto start = std::chrono::steady_clock::now();
+
+    file.open(pgnPath, std::ios::binary | std::ios::trunc);
+    if (!file) {
+        qWarning() << "Cannot create" << QString::fromStdString(pgnPath);
+        return false;
+    }
+    buffer.clear();
+    buffer.reserve(WRITE_BUFFER_BYTES + 256);
+
+    bool ok = false;
+    {
+        QSqlDatabase db = QSqlDatabase::addDatabase("QSQLITE", EXPORT_CONNECTION);
+        db.setDatabaseName(dbPath);
+        if (!db.open()) {
+            qWarning() << "Cannot open the database for export:" << db.lastError().text();
+        } else {
+            DatabaseManager::applyConnectionSettings(db, DatabaseManager::ConnectionSettings());
+            // Games are scanned in rowid order and each one's moves come from
+            // idx_moves_game_id in move_id order, so the ORDER BY needs no sort. Games
+            // without moves still get one row, with NULL move columns.
+            QString sql = R"(
+                SELECT g.game_id, g.start_datetime, g.result, g.event, g.site, g.round,
+                       g.white_player_name, g.black_player_name, g.start_fen,
+                       m.move_number, m.is_white_move, m.san
+                FROM Games g LEFT JOIN Moves m ON m.game_id = g.game_id
+            )";
+            if (finishedOnly) sql += " WHERE g.result IN ('1-0', '0-1', '1/2-1/2')";
+            sql += " ORDER BY g.game_id, m.move_id";
+
+            QSqlQuery query(db);
+            query.setForwardOnly(true);
+            if (!query.prepare(sql) || !query.exec()) {
+                qWarning() << "Failed to read games for export:" << query.lastError();
+            } else {
+                ok = writeGames(query);
+            }
+            db.close();
+        }
+    }
+    QSqlDatabase::removeDatabase(EXPORT_CONNECTION);
+
+    ok = flush() && ok;
+    file.close();
+    exportStats.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return ok && !file.fail();
+}
+
+bool PgnExporter::writeGames(QSqlQuery& query)
+{
+    qint64 currentGame = -1;
+    std::string result;
+    bool firstPly = true;
+
+    while (query.next()) {
+        const qint64 gameId = query.value(GAME_ID).toLongLong();
+        if (gameId != currentGame) {
+            if (currentGame >= 0) endGame(result);
+            currentGame = gameId;
+            result = resultTag(query.value(RESULT));
+            writeTags(query, result);
+            firstPly = true;
+            exportStats.games++;
+        }
+        const QVariant sanValue = query.value(SAN);
+        if (sanValue.isNull()) continue;
+
+        // Black's move gets its own number only at the start of the game. The number
+        // goes out with its move, so a line never ends between them.
+        const bool isWhiteMove = query.value(IS_WHITE_MOVE).toInt() != 0;
+        const std::string san = sanValue.toString().toStdString();
+        if (isWhiteMove || firstPly) {
+            char token[64];
+            const int length = std::snprintf(token, sizeof(token), isWhiteMove ? "%d. %s" : "%d... %s",
+                                             query.value(MOVE_NUMBER).toInt(), san.c_str());
+            writeToken(token, std::min(size_t(length), sizeof(token) - 1));
+        } else {
+            writeToken(san.data(), san.size());
+        }
+        firstPly = false;
+        exportStats.plies++;
+
+        if (buffer.size() >= WRITE_BUFFER_BYTES && !flush()) return false;
+    }
+    if (currentGame >= 0) endGame(result);
+    return true;
+}
+
+void PgnExporter::writeTags(const QSqlQuery& query, const std::string& result)
+{
+    PgnUtils::writeTag(buffer, "Event", tagValue(query.value(EVENT)));
+    PgnUtils::writeTag(buffer, "Site", tagValue(query.value(SITE)));
+    PgnUtils::writeTag(buffer, "Date", dateTag(query.value(START_DATETIME)));
+    PgnUtils::writeTag(buffer, "Round", tagValue(query.value(ROUND)));
+    PgnUtils::writeTag(buffer, "White", tagValue(query.value(WHITE_PLAYER)));
+    PgnUtils::writeTag(buffer, "Black", tagValue(query.value(BLACK_PLAYER)));
+    PgnUtils::writeTag(buffer, "Result", result);
+    const std::string startFen = query.value(START_FEN).toString().toStdString();
+    if (!startFen.empty()) {
+        PgnUtils::writeTag(buffer, "SetUp", "1");
+        PgnUtils::writeTag(buffer, "FEN", startFen);
+    }
+    buffer += '\n';
+    lineLength = 0;
+}
+
+void PgnExporter::writeToken(const char* token, size_t length)
+{
+    if (lineLength > 0 && lineLength + 1 + length > LINE_LENGTH) {
+        buffer += '\n';
+        lineLength = 0;
+    } else if (lineLength > 0) {
+        buffer += ' ';
+        lineLength++;
+    }
+    buffer.append(token, length);
+    lineLength += length;
+}
+
+void PgnExporter::endGame(const std::string& result)
+{
+    writeToken(result.data(), result.size());
+    buffer += "\n\n";
+    lineLength = 0;
+}
+
+bool PgnExporter::flush()
+{
+    file.write(buffer.data(), std::streamsize(buffer.size()));
+    exportStats.bytes += buffer.size();
+    buffer.clear();
+    return bool(file);
+}
@@ -0,0 +1,50 @@
+#ifndef PGNEXPORTER_H
+#define PGNEXPORTER_H
+
+#include <QString>
+#include <cstdint>
+#include <fstream>
+#include <string>
+
+class QSqlQuery;
+
+// Writes the games database out as PGN.
+//
+// One forward-only query joins Games and Moves in game and move order, so every game
+// is written as its rows go by, with the Seven Tag Roster and the stored SAN as movetext.
+// The text collects in a fixed-size buffer that is flushed to the file whenever it fills,
+// so memory use does not depend on the size of the database.
+class PgnExporter {
+public:
+    struct Stats {
+        uint64_t games = 0;
+        uint64_t plies = 0;
+        uint64_t bytes = 0;
+        double seconds = 0;
+    };
+
+    explicit PgnExporter(const QString& dbPath);
+
+    // Writes every game, or only those with a result, in the order they were saved
+    bool exportTo(const std::string& pgnPath, bool finishedOnly = false);
+    const Stats& stats() const { return exportStats; }
+
+private:
+    static constexpr size_t WRITE_BUFFER_BYTES = 1 << 16;
+    static constexpr size_t LINE_LENGTH = 79;  // the longest movetext line
+
+    QString dbPath;
+    Stats exportStats;
+
+    std::ofstream file;
+    std::string buffer;
+    size_t lineLength = 0;
+
+    bool writeGames(QSqlQuery& query);
+    void writeTags(const QSqlQuery& query, const std::string& result);
+    void writeToken(const char* token, size_t length);
+    void endGame(const std::string& result);
+    bool flush();
+};
+
+#endif // PGNEXPORTER_H
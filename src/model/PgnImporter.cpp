@@ -0,0 +1,397 @@
+#include "model/PgnImporter.h"
+#include "core/PgnUtils.h"
+#include "engine/Board.h"
+#include "engine/GameCodec.h"
+#include "engine/San.h"
+#include "model/DatabaseManager.h"
+
+#include <QSqlDatabase>
+#include <QSqlError>
+#include <QSqlQuery>
+#include <QVariant>
+#include <QByteArray>
+#include <QDebug>
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+
+namespace {
+
+const char* const IMPORT_CONNECTION = "pgnImportConnection";
+
+QString fromUtf8(const std::string& text, const char* fallback)
+{
+    return text.empty() ? QString(fallback) : QString::fromUtf8(text.data(), int(text.size()));
+}
+
+} // namespace
+
+PgnImporter::PgnImporter(const QString& dbPath, const Settings& settings)
+    : dbPath(dbPath), settings(settings)
+{
+    this->settings.threads = std::max(1, settings.threads);
+    this->settings.transactionGames = std::max(1, settings.transactionGames);
+}
+
+PgnImporter::~PgnImporter()
+{
+    abort();
+    joinThreads();
+}
+
+bool PgnImporter::import(const std::string& pgnPath, const ProgressCallback& progressCallback)
+{
+    std::ifstream probe(pgnPath, std::ios::binary | std::ios::ate);
+    if (!probe) {
+        qWarning() << "Cannot open" << QString::fromStdString(pgnPath);
+        return false;
+    }
+    progress = Progress();
+    progress.totalBytes = uint64_t(probe.tellg());
+    probe.close();
+    rejections.clear();
+    positionRows.clear();
+    textQueue.clear();
+    parsed.clear();
+    nextToWrite = 0;
+    readerDone = false;
+    aborted = false;
+    readFailed = false;
+
+    bool ok = false;
+    {
+        // The writer's own connection, used only from this thread
+        QSqlDatabase db = QSqlDatabase::addDatabase("QSQLITE", IMPORT_CONNECTION);
+        db.setDatabaseName(dbPath);
+        if (!db.open()) {
+            qWarning() << "Cannot open the database for import:" << db.lastError().text();
+        } else {
+            DatabaseManager::applyConnectionSettings(db, DatabaseManager::ConnectionSettings());
+            workersRunning = settings.threads;
+            reader = std::thread([this, pgnPath] { readerLoop(pgnPath); });
+            for (int i = 0; i < settings.threads; ++i) workers.emplace_back([this] { workerLoop(); });
+
+            ok = writeBatches(db, progressCallback);
+            if (!ok) abort();
+            joinThreads();
+            db.close();
+        }
+    }
+    QSqlDatabase::removeDatabase(IMPORT_CONNECTION);
+    if (readFailed) qWarning() << "Reading" << QString::fromStdString(pgnPath) << "failed";
+    return ok && !readFailed;
+}
+
+void PgnImporter::readerLoop(const std::string& pgnPath)
+{
+    std::ifstream in(pgnPath, std::ios::binary);
+    std::string buffer;
+    uint64_t bufferOffset = 0; // file offset of buffer[0]
+    uint64_t sequence = 0;
+    uint64_t gameNumber = 1;
+    TextBatch batch;
+    bool atEnd = !in;
+
+    while (!atEnd) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (aborted) break;
+        }
+        // The unfinished game at the end of the buffer stays and is completed by the next chunk
+        const size_t kept = buffer.size();
+        buffer.resize(kept + READ_CHUNK_BYTES);
+        in.read(&buffer[kept], std::streamsize(READ_CHUNK_BYTES));
+        buffer.resize(kept + size_t(in.gcount()));
+        atEnd = !in;
+        if (in.bad()) {
+            std::lock_guard<std::mutex> lock(mutex);
+            readFailed = true;
+        }
+
+        size_t pos = 0;
+        std::string_view game;
+        while (PgnUtils::nextGame(buffer, pos, atEnd, game)) {
+            batch.games.emplace_back(batch.text.size(), game.size());
+            batch.text.append(game);
+            batch.bytesEnd = bufferOffset + pos;
+            if (batch.games.size() == BATCH_GAMES) {
+                batch.sequence = sequence++;
+                batch.firstGame = gameNumber;
+                gameNumber += batch.games.size();
+                pushText(std::move(batch));
+                batch = TextBatch();
+            }
+        }
+        buffer.erase(0, pos);
+        bufferOffset += pos;
+    }
+    if (!batch.games.empty()) {
+        batch.sequence = sequence;
+        batch.firstGame = gameNumber;
+        pushText(std::move(batch));
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    readerDone = true;
+    textNotEmpty.notify_all();
+}
+
+void PgnImporter::pushText(TextBatch&& batch)
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    // Bounded, so the reader cannot run ahead through the whole file
+    textNotFull.wait(lock, [this] { return aborted || textQueue.size() < 2 * size_t(settings.threads); });
+    if (aborted) return;
+    textQueue.push_back(std::move(batch));
+    textNotEmpty.notify_one();
+}
+
+void PgnImporter::workerLoop()
+{
+    const uint64_t window = 2 * uint64_t(settings.threads);
+    while (true) {
+        TextBatch text;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            textNotEmpty.wait(lock, [this] { return aborted || readerDone || !textQueue.empty(); });
+            if (aborted || textQueue.empty()) break;
+            text = std::move(textQueue.front());
+            textQueue.pop_front();
+            textNotFull.notify_one();
+        }
+
+        ParsedBatch batch;
+        parseBatch(text, batch);
+
+        // Batches are written in file order; one that is too far ahead waits, so finished
+        // batches cannot pile up behind a slow one
+        std::unique_lock<std::mutex> lock(mutex);
+        parsedRoom.wait(lock, [&] { return aborted || text.sequence < nextToWrite + window; });
+        if (aborted) break;
+        parsed.emplace(text.sequence, std::move(batch));
+        parsedReady.notify_one();
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    workersRunning--;
+    parsedReady.notify_one();
+}
+
+void PgnImporter::parseBatch(const TextBatch& text, ParsedBatch& batch) const
+{
+    PgnGame game;
+    Board board;
+    Board replay;
+    batch.bytesEnd = text.bytesEnd;
+    batch.games.reserve(text.games.size());
+
+    for (size_t i = 0; i < text.games.size(); ++i) {
+        const std::string_view gameText(text.text.data() + text.games[i].first, text.games[i].second);
+        const PgnError error = PgnUtils::parseGame(gameText, game, board);
+        if (error != PgnError::None) {
+            batch.rejected++;
+            std::string reason = "game " + std::to_string(text.firstGame + i) + ": " + PgnUtils::errorMessage(error);
+            if (error == PgnError::Move) {
+                reason += " " + std::string(game.errorToken) + " (" + San::errorMessage(game.moveError) + ")";
+            }
+            batch.errors.push_back(std::move(reason));
+            continue;
+        }
+
+        // Replayed once more for the rows: the SAN as this program writes it, and the FEN
+        // and key after every move
+        ImportedGame imported;
+        imported.event = std::move(game.event);
+        imported.site = std::move(game.site);
+        imported.date = std::move(game.date);
+        imported.round = std::move(game.round);
+        imported.white = std::move(game.white);
+        imported.black = std::move(game.black);
+        imported.result = game.result.empty() ? std::string("*") : std::move(game.result);
+        imported.startFen = std::move(game.fen);
+        imported.plies.resize(game.moves.size());
+
+        replay.setFromFen(imported.startFen.empty() ? std::string_view(Board::START_FEN) : std::string_view(imported.startFen));
+        for (size_t ply = 0; ply < game.moves.size(); ++ply) {
+            const BoardMove move = game.moves[ply];
+            ImportedPly& row = imported.plies[ply];
+            row.from = uint8_t(move.from());
+            row.to = uint8_t(move.to());
+            row.isWhiteMove = replay.sideToMove() == WHITE;
+            row.moveNumber = uint16_t(replay.fullmoveNumber());
+            row.sanLength = uint8_t(San::write(replay, move, row.san));
+            replay.makeMove(move);
+            row.key = replay.key();
+            row.fenLength = uint8_t(replay.writeFen(row.fen));
+        }
+        imported.lastFen = replay.toFen();
+
+        replay.setFromFen(imported.startFen.empty() ? std::string_view(Board::START_FEN) : std::string_view(imported.startFen));
+        GameCodec::encode(replay, game.moves.data(), game.moves.size(), imported.encodedMoves);
+        batch.games.push_back(std::move(imported));
+    }
+}
+
+bool PgnImporter::writeBatches(QSqlDatabase& db, const ProgressCallback& progressCallback)
+{
+    QSqlQuery gameQuery(db);
+    QSqlQuery moveQuery(db);
+    QSqlQuery positionQuery(db);
+    if (!gameQuery.prepare(R"(
+            INSERT INTO Games (start_datetime, result, last_fen, white_player_name, black_player_name,
+                               event, site, round, start_fen, encoded_moves)
+            VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, ?)
+        )")
+        || !moveQuery.prepare(R"(
+            INSERT INTO Moves (game_id, move_number, is_white_move, from_row, from_col, to_row, to_col, san, fen_after_move)
+            VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?)
+        )")
+        || !positionQuery.prepare("INSERT INTO Positions (zobrist, game_id, ply) VALUES (?, ?, ?)")) {
+        qWarning() << "Cannot prepare the import statements:" << gameQuery.lastError() << moveQuery.lastError()
+                   << positionQuery.lastError();
+        return false;
+    }
+
+    const auto start = std::chrono::steady_clock::now();
+    auto lastReport = start;
+    int gamesInTransaction = 0;
+    if (!db.transaction()) return false;
+
+    while (true) {
+        ParsedBatch batch;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            parsedReady.wait(lock, [this] { return aborted || workersRunning == 0 || parsed.count(nextToWrite) > 0; });
+            auto it = parsed.find(nextToWrite);
+            if (aborted || it == parsed.end()) break;
+            batch = std::move(it->second);
+            parsed.erase(it);
+            nextToWrite++;
+            parsedRoom.notify_all();
+        }
+
+        for (const ImportedGame& game : batch.games) {
+            if (!writeGame(gameQuery, moveQuery, game)) {
+                db.rollback();
+                return false;
+            }
+            progress.plies += game.plies.size();
+            if (++gamesInTransaction >= settings.transactionGames) {
+                if (!writePositions(positionQuery)) {
+                    db.rollback();
+                    return false;
+                }
+                if (!db.commit() || !db.transaction()) {
+                    qWarning() << "Import commit failed:" << db.lastError().text();
+                    return false;
+                }
+                gamesInTransaction = 0;
+            }
+        }
+        progress.gamesImported += batch.games.size();
+        progress.gamesRejected += batch.rejected;
+        progress.bytesDone = batch.bytesEnd;
+        for (std::string& error : batch.errors) {
+            if (rejections.size() < MAX_ERRORS) rejections.push_back(std::move(error));
+        }
+
+        const auto now = std::chrono::steady_clock::now();
+        if (progressCallback && std::chrono::duration_cast<std::chrono::milliseconds>(now - lastReport).count() >= PROGRESS_INTERVAL_MS) {
+            progress.seconds = std::chrono::duration<double>(now - start).count();
+            progressCallback(progress);
+            lastReport = now;
+        }
+    }
+
+    if (!writePositions(positionQuery)) {
+        db.rollback();
+        return false;
+    }
+    if (!db.commit()) {
+        qWarning() << "Import commit failed:" << db.lastError().text();
+        return false;
+    }
+    progress.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    if (progressCallback) progressCallback(progress);
+    return true;
+}
+
+bool PgnImporter::writeGame(QSqlQuery& gameQuery, QSqlQuery& moveQuery, const ImportedGame& game)
+{
+    // PGN dates are "yyyy.mm.dd" with '?' for unknown parts
+    QString date = fromUtf8(game.date, "????.??.??");
+    date.replace('.', '-');
+    gameQuery.bindValue(0, date);
+    gameQuery.bindValue(1, QString::fromStdString(game.result));
+    gameQuery.bindValue(2, QString::fromStdString(game.lastFen));
+    gameQuery.bindValue(3, fromUtf8(game.white, "?"));
+    gameQuery.bindValue(4, fromUtf8(game.black, "?"));
+    gameQuery.bindValue(5, fromUtf8(game.event, "?"));
+    gameQuery.bindValue(6, fromUtf8(game.site, "?"));
+    gameQuery.bindValue(7, fromUtf8(game.round, "?"));
+    gameQuery.bindValue(8, game.startFen.empty() ? QVariant() : QVariant(QString::fromStdString(game.startFen)));
+    gameQuery.bindValue(9, QByteArray(game.encodedMoves.data(), int(game.encodedMoves.size())));
+    if (!gameQuery.exec()) {
+        qWarning() << "Failed to import game:" << gameQuery.lastError();
+        return false;
+    }
+    const qint64 gameId = gameQuery.lastInsertId().toLongLong();
+
+    for (size_t index = 0; index < game.plies.size(); ++index) {
+        const ImportedPly& ply = game.plies[index];
+        moveQuery.bindValue(0, gameId);
+        moveQuery.bindValue(1, int(ply.moveNumber));
+        moveQuery.bindValue(2, ply.isWhiteMove ? 1 : 0);
+        moveQuery.bindValue(3, ply.from / 8);
+        moveQuery.bindValue(4, ply.from % 8);
+        moveQuery.bindValue(5, ply.to / 8);
+        moveQuery.bindValue(6, ply.to % 8);
+        moveQuery.bindValue(7, QString::fromLatin1(ply.san, ply.sanLength));
+        moveQuery.bindValue(8, QString::fromLatin1(ply.fen, ply.fenLength));
+        if (!moveQuery.exec()) {
+            qWarning() << "Failed to import move of game" << gameId << ":" << moveQuery.lastError();
+            return false;
+        }
+        positionRows.push_back(PositionRow{ ply.key, gameId, int(index) + 1 });
+    }
+    return true;
+}
+
+bool PgnImporter::writePositions(QSqlQuery& positionQuery)
+{
+    // In key order the inserts walk idx_positions_zobrist from one end to the other instead
+    // of landing on a random page each, which matters once the index outgrows the cache
+    std::sort(positionRows.begin(), positionRows.end(), [](const PositionRow& a, const PositionRow& b) {
+        return qint64(a.key) < qint64(b.key);
+    });
+    for (const PositionRow& row : positionRows) {
+        positionQuery.bindValue(0, qint64(row.key));
+        positionQuery.bindValue(1, row.gameId);
+        positionQuery.bindValue(2, row.ply);
+        if (!positionQuery.exec()) {
+            qWarning() << "Failed to index position of game" << row.gameId << ":" << positionQuery.lastError();
+            return false;
+        }
+    }
+    positionRows.clear();
+    return true;
+}
+
+void PgnImporter::abort()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    aborted = true;
+    textNotEmpty.notify_all();
+    textNotFull.notify_all();
+    parsedReady.notify_all();
+    parsedRoom.notify_all();
+}
+
+void PgnImporter::joinThreads()
+{
+    if (reader.joinable()) reader.join();
+    for (std::thread& worker : workers) {
+        if (worker.joinable()) worker.join();
+    }
+    workers.clear();
+}
@@ -0,0 +1,145 @@
+#ifndef PGNIMPORTER_H
+#define PGNIMPORTER_H
+
+#include "core/FenUtils.h"
+#include "engine/San.h"
+
+#include <QString>
+#include <QtGlobal>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+class QSqlDatabase;
+class QSqlQuery;
+
+// Imports PGN files of any size into the games database.
+//
+// A reader thread reads the file in fixed-size chunks and splits it into games, which
+// go in batches to a pool of worker threads. Each worker parses the tags and the SAN
+// of its games, validating every move on a private Board, and prepares the rows of the
+// Moves and Positions tables. The calling thread is the single SQLite writer: it takes the parsed
+// batches in file order, so game ids follow the file, and commits them in large
+// transactions. Both queues are bounded, so memory use does not grow with the file.
+class PgnImporter {
+public:
+    struct Settings {
+        int threads = 1;                 // parsing workers
+        int transactionGames = 10000;    // games per committed transaction
+    };
+
+    struct Progress {
+        uint64_t bytesDone = 0;          // of the file, up to the last game written
+        uint64_t totalBytes = 0;
+        uint64_t gamesImported = 0;
+        uint64_t gamesRejected = 0;
+        uint64_t plies = 0;
+        double seconds = 0;
+    };
+    // Called from the writer about once a second, and once more at the end
+    using ProgressCallback = std::function<void(const Progress& progress)>;
+
+    // The database must exist with its tables; see DatabaseManager::initDatabase()
+    PgnImporter(const QString& dbPath, const Settings& settings);
+    ~PgnImporter();
+
+    bool import(const std::string& pgnPath, const ProgressCallback& progressCallback = ProgressCallback());
+    const Progress& stats() const { return progress; }
+    // "game <n>: <reason>" for the first rejected games
+    const std::vector<std::string>& errors() const { return rejections; }
+
+private:
+    // Game texts copied out of the read buffer; spans index into text
+    struct TextBatch {
+        uint64_t sequence = 0;
+        uint64_t firstGame = 0;          // number of the first game in the file, from 1
+        uint64_t bytesEnd = 0;           // file offset after the last game
+        std::string text;
+        std::vector<std::pair<size_t, size_t>> games;
+    };
+
+    struct ImportedPly {
+        uint64_t key;                    // Board::key() after the move
+        uint8_t from;
+        uint8_t to;
+        bool isWhiteMove;
+        uint16_t moveNumber;
+        uint8_t sanLength;
+        uint8_t fenLength;
+        char san[San::SAN_BUFFER_SIZE];
+        char fen[FenUtils::FEN_BUFFER_SIZE];
+    };
+
+    struct ImportedGame {
+        std::string event;
+        std::string site;
+        std::string date;
+        std::string round;
+        std::string white;
+        std::string black;
+        std::string result;
+        std::string startFen;            // empty for the standard starting position
+        std::string lastFen;
+        std::string encodedMoves;        // GameCodec, one byte per ply
+        std::vector<ImportedPly> plies;
+    };
+
+    // A Positions row, held back until the transaction commits
+    struct PositionRow {
+        uint64_t key;
+        qint64 gameId;
+        int ply;
+    };
+
+    struct ParsedBatch {
+        uint64_t bytesEnd = 0;
+        uint64_t rejected = 0;
+        std::vector<ImportedGame> games;
+        std::vector<std::string> errors;
+    };
+
+    static constexpr size_t READ_CHUNK_BYTES = 4 << 20;
+    static constexpr size_t BATCH_GAMES = 512;
+    static constexpr size_t MAX_ERRORS = 20;
+    static constexpr int PROGRESS_INTERVAL_MS = 1000;
+
+    QString dbPath;
+    Settings settings;
+    Progress progress;
+    std::vector<std::string> rejections;
+    std::vector<PositionRow> positionRows;
+
+    std::mutex mutex;
+    std::condition_variable textNotEmpty;
+    std::condition_variable textNotFull;
+    std::condition_variable parsedReady;
+    std::condition_variable parsedRoom;
+    std::deque<TextBatch> textQueue;
+    std::map<uint64_t, ParsedBatch> parsed; // finished batches waiting for their turn
+    uint64_t nextToWrite = 0;
+    bool readerDone = false;
+    int workersRunning = 0;
+    bool aborted = false;
+    bool readFailed = false;
+
+    std::thread reader;
+    std::vector<std::thread> workers;
+
+    void readerLoop(const std::string& pgnPath);
+    void pushText(TextBatch&& batch);
+    void workerLoop();
+    void parseBatch(const TextBatch& text, ParsedBatch& batch) const;
+    bool writeBatches(QSqlDatabase& db, const ProgressCallback& progressCallback);
+    bool writeGame(QSqlQuery& gameQuery, QSqlQuery& moveQuery, const ImportedGame& game);
+    bool writePositions(QSqlQuery& positionQuery);
+    void abort();
+    void joinThreads();
+};
+
+#endif // PGNIMPORTER_H